@@ -0,0 +1,848 @@
+#include "BigIntCalculator.h"
+#include "CalculationService.h"
+#include "Calculator.h"
+#include "CalculatorBank.h"
+#include "ConcurrentCalculator.h"
+#include "ExprKernel.h"
+#include "Expression.h"
+#include "GpuBatch.h"
+#include "MathUtils.h"
+#include "MemoCache.h"
+#include "OperationJournal.h"
+#include "ParallelReduce.h"
+#include "SessionFile.h"
+#include "Snapshot.h"
+#ifdef CALCULATOR_COROUTINES
+#include "ChainScheduler.h"
+#endif
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <future>
+#include <iostream>
+#include <memory_resource>
+#include <stdexcept>
+#include <streambuf>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace {
+    // Discards everything written to it, so printing methods can be timed quietly
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override {
+            return c;
+        }
+
+        std::streamsize xsputn(const char*, std::streamsize n) override {
+            return n;
+        }
+    };
+
+    // Redirects std::cout to a NullBuffer for the lifetime of the object
+    class SilenceCout {
+    public:
+        SilenceCout() : previous(std::cout.rdbuf(&sink)) {}
+        ~SilenceCout() {
+            std::cout.rdbuf(previous);
+        }
+
+    private:
+        NullBuffer sink;
+        std::streambuf* previous;
+    };
+
+    std::vector<double> makeOperands(std::size_t n, double offset) {
+        std::vector<double> values(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            values[i] = offset + static_cast<double>(i % 1000) * 0.001;
+        }
+        return values;
+    }
+
+    // The operands of makeOperands rounded to float, Half or BFloat16
+    template <typename Narrow>
+    std::vector<Narrow> makeNarrowOperands(std::size_t n, double offset) {
+        std::vector<double> wide = makeOperands(n, offset);
+        std::vector<float> single(n);
+        Utils::MathUtils::convert(wide.data(), single.data(), n);
+        if constexpr (std::is_same<Narrow, float>::value) {
+            return single;
+        } else {
+            std::vector<Narrow> narrow(n);
+            Utils::MathUtils::convert(single.data(), narrow.data(), n);
+            return narrow;
+        }
+    }
+
+    void setBatchCounters(benchmark::State& state, std::size_t arrays, std::size_t elementSize = sizeof(double)) {
+        const int64_t n = state.range(0);
+        state.SetItemsProcessed(state.iterations() * n);
+        state.SetBytesProcessed(state.iterations() * n * static_cast<int64_t>(arrays * elementSize));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// MathUtils scalar operations
+// ---------------------------------------------------------------------------
+
+#define CALCULATOR_SCALAR_BENCH(name, expression)  \
+    static void name(benchmark::State& state) {    \
+        double a = 1.5;                            \
+        double b = 2.25;                           \
+        for (auto _ : state) {                     \
+            benchmark::DoNotOptimize(a);           \
+            benchmark::DoNotOptimize(b);           \
+            double result = expression;            \
+            benchmark::DoNotOptimize(result);      \
+        }                                          \
+    }                                              \
+    BENCHMARK(name)
+
+CALCULATOR_SCALAR_BENCH(BM_MathUtils_Add, Utils::MathUtils::add(a, b));
+CALCULATOR_SCALAR_BENCH(BM_MathUtils_Subtract, Utils::MathUtils::subtract(a, b));
+CALCULATOR_SCALAR_BENCH(BM_MathUtils_Multiply, Utils::MathUtils::multiply(a, b));
+CALCULATOR_SCALAR_BENCH(BM_MathUtils_Divide, Utils::MathUtils::divide(a, b));
+CALCULATOR_SCALAR_BENCH(BM_MathUtils_TryDivide, Utils::MathUtils::tryDivide(a, b).value);
+CALCULATOR_SCALAR_BENCH(BM_MathUtils_PowerFixed8, Utils::MathUtils::power<8>(a));
+
+static void BM_MathUtils_Power(benchmark::State& state) {
+    double base = 1.0000001;
+    int exponent = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(base);
+        benchmark::DoNotOptimize(exponent);
+        double result = Utils::MathUtils::power(base, exponent);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_MathUtils_Power)->Arg(2)->Arg(5)->Arg(16)->Arg(-16)->Arg(1000)->Arg(1 << 20)->Arg(2147483647);
+
+// Hot (base, exponent) pairs through the memo cache, to compare with BM_MathUtils_Power
+static void BM_PowerCache_Hit(benchmark::State& state) {
+    Utils::PowerCache cache;
+    double base = 1.0000001;
+    int exponent = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(base);
+        benchmark::DoNotOptimize(exponent);
+        double result = cache.power(base, exponent);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_PowerCache_Hit)->Arg(1 << 20)->Arg(2147483647);
+
+// Every lookup misses: the cost of hashing, probing and CLOCK eviction
+static void BM_PowerCache_Miss(benchmark::State& state) {
+    Utils::PowerCache cache(1024);
+    double base = 1.0000001;
+    for (auto _ : state) {
+        base += 1e-9;
+        double result = cache.power(base, 1 << 20);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_PowerCache_Miss);
+
+static void BM_MathUtils_IsEven(benchmark::State& state) {
+    int number = 12345;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(number);
+        bool even = Utils::MathUtils::isEven(number);
+        benchmark::DoNotOptimize(even);
+    }
+}
+BENCHMARK(BM_MathUtils_IsEven);
+
+// Error-path costs: throwing divide versus the status-returning tryDivide
+static void BM_MathUtils_DivideByZeroThrow(benchmark::State& state) {
+    double a = 1.5;
+    double zero = 0.0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(zero);
+        try {
+            double result = Utils::MathUtils::divide(a, zero);
+            benchmark::DoNotOptimize(result);
+        } catch (const std::runtime_error& e) {
+            benchmark::DoNotOptimize(e);
+        }
+    }
+}
+BENCHMARK(BM_MathUtils_DivideByZeroThrow);
+
+static void BM_MathUtils_TryDivideByZero(benchmark::State& state) {
+    double a = 1.5;
+    double zero = 0.0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(zero);
+        Utils::MathResult result = Utils::MathUtils::tryDivide(a, zero);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_MathUtils_TryDivideByZero);
+
+// ---------------------------------------------------------------------------
+// MathUtils batch kernels, 1 to 10^7 elements
+// ---------------------------------------------------------------------------
+
+#define CALCULATOR_BATCH_BENCH(name, function)                                \
+    static void name(benchmark::State& state) {                               \
+        const std::size_t n = static_cast<std::size_t>(state.range(0));       \
+        std::vector<double> a = makeOperands(n, 1.0);                         \
+        std::vector<double> b = makeOperands(n, 2.0);                         \
+        std::vector<double> out(n);                                           \
+        for (auto _ : state) {                                                \
+            Utils::MathUtils::function(a.data(), b.data(), out.data(), n);    \
+            benchmark::ClobberMemory();                                       \
+        }                                                                     \
+        setBatchCounters(state, 3);                                           \
+    }                                                                         \
+    BENCHMARK(name)->RangeMultiplier(10)->Range(1, 10000000)
+
+CALCULATOR_BATCH_BENCH(BM_Batch_Add, add);
+CALCULATOR_BATCH_BENCH(BM_Batch_Subtract, subtract);
+CALCULATOR_BATCH_BENCH(BM_Batch_Multiply, multiply);
+CALCULATOR_BATCH_BENCH(BM_Batch_Divide, divide);
+
+// The same kernels on narrower elements; bytes/s counts the narrow size
+#define CALCULATOR_NARROW_BATCH_BENCH(name, type, function)                   \
+    static void name(benchmark::State& state) {                               \
+        const std::size_t n = static_cast<std::size_t>(state.range(0));       \
+        std::vector<type> a = makeNarrowOperands<type>(n, 1.0);               \
+        std::vector<type> b = makeNarrowOperands<type>(n, 2.0);               \
+        std::vector<type> out(n);                                             \
+        for (auto _ : state) {                                                \
+            Utils::MathUtils::function(a.data(), b.data(), out.data(), n);    \
+            benchmark::ClobberMemory();                                       \
+        }                                                                     \
+        setBatchCounters(state, 3, sizeof(type));                             \
+    }                                                                         \
+    BENCHMARK(name)->RangeMultiplier(10)->Range(1, 10000000)
+
+CALCULATOR_NARROW_BATCH_BENCH(BM_BatchFloat_Add, float, add);
+CALCULATOR_NARROW_BATCH_BENCH(BM_BatchFloat_Multiply, float, multiply);
+CALCULATOR_NARROW_BATCH_BENCH(BM_BatchFloat_Divide, float, divide);
+CALCULATOR_NARROW_BATCH_BENCH(BM_BatchHalf_Add, Utils::Half, add);
+CALCULATOR_NARROW_BATCH_BENCH(BM_BatchBFloat16_Add, Utils::BFloat16, add);
+
+static void BM_Batch_ConvertToHalf(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<float> in = makeNarrowOperands<float>(n, 1.0);
+    std::vector<Utils::Half> out(n);
+    for (auto _ : state) {
+        Utils::MathUtils::convert(in.data(), out.data(), n);
+        benchmark::ClobberMemory();
+    }
+    setBatchCounters(state, 1, sizeof(float) + sizeof(Utils::Half));
+}
+BENCHMARK(BM_Batch_ConvertToHalf)->RangeMultiplier(10)->Range(1, 10000000);
+
+// The offload path for huge batches; labelled with the device that ran it
+static void BM_GpuBatch_Multiply(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<double> a = makeOperands(n, 1.0);
+    std::vector<double> b = makeOperands(n, 2.0);
+    std::vector<double> out(n);
+    Utils::GpuOptions options;
+    options.minimumElements = 0;
+    for (auto _ : state) {
+        Utils::GpuBatch::multiply(a.data(), b.data(), out.data(), n, options);
+        benchmark::ClobberMemory();
+    }
+    state.SetLabel(Utils::GpuBatch::deviceName());
+    setBatchCounters(state, 3);
+}
+BENCHMARK(BM_GpuBatch_Multiply)->RangeMultiplier(10)->Range(100000, 10000000);
+
+// Scalar loop over the same data, as the baseline the batch kernels replace
+static void BM_Batch_AddScalarLoop(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<double> a = makeOperands(n, 1.0);
+    std::vector<double> b = makeOperands(n, 2.0);
+    std::vector<double> out(n);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < n; ++i) {
+            double x = a[i];
+            benchmark::DoNotOptimize(x);
+            out[i] = Utils::MathUtils::add(x, b[i]);
+        }
+        benchmark::ClobberMemory();
+    }
+    setBatchCounters(state, 3);
+}
+BENCHMARK(BM_Batch_AddScalarLoop)->RangeMultiplier(10)->Range(1, 10000000);
+
+static void BM_Batch_AddInPlace(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<double> a = makeOperands(n, 1.0);
+    std::vector<double> b(n, 0.0);
+    for (auto _ : state) {
+        Utils::MathUtils::add(a.data(), b.data(), n);
+        benchmark::ClobberMemory();
+    }
+    setBatchCounters(state, 2);
+}
+BENCHMARK(BM_Batch_AddInPlace)->RangeMultiplier(10)->Range(1, 10000000);
+
+static void BM_Batch_Power(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<double> base = makeOperands(n, 1.0);
+    std::vector<double> out(n);
+    for (auto _ : state) {
+        Utils::MathUtils::power(base.data(), 5, out.data(), n);
+        benchmark::ClobberMemory();
+    }
+    setBatchCounters(state, 2);
+}
+BENCHMARK(BM_Batch_Power)->RangeMultiplier(10)->Range(1, 10000000);
+
+static void BM_Batch_SumCompensated(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<double> values = makeOperands(n, 1.0);
+    for (auto _ : state) {
+        double total = Utils::MathUtils::sum(values.data(), n, Utils::Summation::Compensated);
+        benchmark::DoNotOptimize(total);
+    }
+    setBatchCounters(state, 1);
+}
+BENCHMARK(BM_Batch_SumCompensated)->RangeMultiplier(10)->Range(1, 10000000);
+
+static void BM_Batch_Sign(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<double> values = makeOperands(n, -0.5);
+    std::vector<Utils::Sign> out(n);
+    for (auto _ : state) {
+        Utils::MathUtils::sign(values.data(), out.data(), n);
+        benchmark::ClobberMemory();
+    }
+    setBatchCounters(state, 1);
+}
+BENCHMARK(BM_Batch_Sign)->RangeMultiplier(10)->Range(1, 10000000);
+
+static void BM_Batch_ParityMasks(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<double> values = makeOperands(n, 1.0e6);
+    std::vector<std::uint64_t> even((n + 63) / 64);
+    std::vector<std::uint64_t> odd((n + 63) / 64);
+    for (auto _ : state) {
+        Utils::MathUtils::parityMasks(values.data(), n, even.data(), odd.data());
+        benchmark::ClobberMemory();
+    }
+    setBatchCounters(state, 1);
+}
+BENCHMARK(BM_Batch_ParityMasks)->RangeMultiplier(10)->Range(1, 10000000);
+
+static void BM_Batch_SignMasks(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<double> values = makeOperands(n, -0.5);
+    std::vector<std::uint64_t> positive((n + 63) / 64);
+    std::vector<std::uint64_t> zero((n + 63) / 64);
+    std::vector<std::uint64_t> negative((n + 63) / 64);
+    for (auto _ : state) {
+        Utils::MathUtils::signMasks(values.data(), n, positive.data(), zero.data(), negative.data());
+        benchmark::ClobberMemory();
+    }
+    setBatchCounters(state, 1);
+}
+BENCHMARK(BM_Batch_SignMasks)->RangeMultiplier(10)->Range(1, 10000000);
+
+static void BM_Batch_DivideByZeroThrow(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<double> a = makeOperands(n, 1.0);
+    std::vector<double> b = makeOperands(n, 2.0);
+    std::vector<double> out(n);
+    b[n - 1] = 0.0;
+    for (auto _ : state) {
+        try {
+            Utils::MathUtils::divide(a.data(), b.data(), out.data(), n);
+        } catch (const std::runtime_error& e) {
+            benchmark::DoNotOptimize(e);
+        }
+    }
+    setBatchCounters(state, 1);
+}
+BENCHMARK(BM_Batch_DivideByZeroThrow)->RangeMultiplier(10)->Range(1, 10000000);
+
+// Parallel reductions, by summation mode (0 naive, 1 compensated, 2 pairwise)
+static void BM_ParallelReduce_Sum(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<double> values = makeOperands(n, 1.0);
+    Utils::ReduceOptions options;
+    options.summation = static_cast<Utils::Summation>(state.range(1));
+    for (auto _ : state) {
+        double total = Utils::ParallelReduce::sum(values.data(), n, options);
+        benchmark::DoNotOptimize(total);
+    }
+    setBatchCounters(state, 1);
+}
+BENCHMARK(BM_ParallelReduce_Sum)->ArgsProduct({{1000, 1000000, 10000000}, {0, 1, 2}})->UseRealTime();
+
+// ---------------------------------------------------------------------------
+// Calculator methods
+// ---------------------------------------------------------------------------
+
+#define CALCULATOR_METHOD_BENCH(name, type, call)   \
+    static void name(benchmark::State& state) {     \
+        type calc;                                  \
+        calc.add(1.0);                              \
+        double operand = 1.0;                       \
+        int exponent = 1;                           \
+        for (auto _ : state) {                      \
+            benchmark::DoNotOptimize(operand);      \
+            benchmark::DoNotOptimize(exponent);     \
+            call;                                   \
+            benchmark::DoNotOptimize(calc);         \
+        }                                           \
+    }                                               \
+    BENCHMARK(name)
+
+CALCULATOR_METHOD_BENCH(BM_Calculator_Add, Calculator, calc.add(operand));
+CALCULATOR_METHOD_BENCH(BM_Calculator_Subtract, Calculator, calc.subtract(operand));
+CALCULATOR_METHOD_BENCH(BM_Calculator_Multiply, Calculator, calc.multiply(operand));
+CALCULATOR_METHOD_BENCH(BM_Calculator_Divide, Calculator, calc.divide(operand));
+CALCULATOR_METHOD_BENCH(BM_Calculator_PowerOf, Calculator, calc.powerOf(exponent));
+CALCULATOR_METHOD_BENCH(BM_Calculator_Reset, Calculator, calc.reset());
+CALCULATOR_METHOD_BENCH(BM_Calculator_GetValue, Calculator, benchmark::DoNotOptimize(calc.getValue()));
+CALCULATOR_METHOD_BENCH(BM_Calculator_GetLastOperation, Calculator,
+                        benchmark::DoNotOptimize(calc.getLastOperation()));
+
+// Exact backends: overflow-checked int64 and two-decimal fixed point
+#define EXACT_CALCULATOR_BENCH(name, type, initial, call) \
+    static void name(benchmark::State& state) {           \
+        type calc;                                        \
+        type::value_type operand = initial;               \
+        calc.add(operand);                                \
+        for (auto _ : state) {                            \
+            benchmark::DoNotOptimize(operand);            \
+            call;                                         \
+            benchmark::DoNotOptimize(calc);               \
+        }                                                 \
+    }                                                     \
+    BENCHMARK(name)
+
+EXACT_CALCULATOR_BENCH(BM_IntegerCalculator_Add, IntegerCalculator, 1, (calc.add(operand), calc.subtract(operand)));
+EXACT_CALCULATOR_BENCH(BM_IntegerCalculator_Multiply, IntegerCalculator, 1, calc.multiply(operand));
+EXACT_CALCULATOR_BENCH(BM_IntegerCalculator_Divide, IntegerCalculator, 1, calc.divide(operand));
+EXACT_CALCULATOR_BENCH(BM_DecimalCalculator_Add, DecimalCalculator<2>, Utils::Fixed<2>::fromInteger(1),
+                       (calc.add(operand), calc.subtract(operand)));
+EXACT_CALCULATOR_BENCH(BM_DecimalCalculator_Multiply, DecimalCalculator<2>, Utils::Fixed<2>::fromInteger(1),
+                       calc.multiply(operand));
+EXACT_CALCULATOR_BENCH(BM_DecimalCalculator_Divide, DecimalCalculator<2>, Utils::Fixed<2>::fromInteger(1),
+                       calc.divide(operand));
+EXACT_CALCULATOR_BENCH(BM_BigIntCalculator_Add, BigIntCalculator, 1, (calc.add(operand), calc.subtract(operand)));
+EXACT_CALCULATOR_BENCH(BM_BigIntCalculator_Multiply, BigIntCalculator, 1, calc.multiply(operand));
+EXACT_CALCULATOR_BENCH(BM_BigIntCalculator_Divide, BigIntCalculator, 1, calc.divide(operand));
+
+// BigInt multiplication from the inline 128-bit range to Karatsuba sizes;
+// the argument is the limb count of each factor
+static void BM_BigInt_Multiply(benchmark::State& state) {
+    const std::size_t limbs = static_cast<std::size_t>(state.range(0));
+    const Utils::BigInt a = Utils::BigInt::power(Utils::BigInt::fromString("4294967291"), static_cast<unsigned>(limbs));
+    const Utils::BigInt b = a - 12345;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a * b);
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_BigInt_Multiply)->RangeMultiplier(4)->Range(1, 4096)->Complexity();
+
+static void BM_BigInt_Power(benchmark::State& state) {
+    const Utils::BigInt base(3);
+    const unsigned exponent = static_cast<unsigned>(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Utils::BigInt::power(base, exponent));
+    }
+}
+BENCHMARK(BM_BigInt_Power)->RangeMultiplier(10)->Range(10, 100000);
+
+// The description formatted into a per-request bump arena instead of the heap
+static void BM_Calculator_GetLastOperationArena(benchmark::State& state) {
+    Calculator calc;
+    calc.powerOf(2); // "Raised to power 2" is too long for the small-string buffer
+    alignas(std::max_align_t) char storage[4096];
+    std::pmr::monotonic_buffer_resource arena(storage, sizeof(storage), std::pmr::null_memory_resource());
+    std::size_t requests = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(calc.getLastOperation(&arena));
+        // End of a "request": discard everything allocated from the arena at once
+        if (++requests % 64 == 0) {
+            arena.release();
+        }
+    }
+}
+BENCHMARK(BM_Calculator_GetLastOperationArena);
+
+static void BM_Calculator_GetLastOperationHeap(benchmark::State& state) {
+    Calculator calc;
+    calc.powerOf(2);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(calc.getLastOperation());
+    }
+}
+BENCHMARK(BM_Calculator_GetLastOperationHeap);
+
+CALCULATOR_METHOD_BENCH(BM_CalculatorNoTrace_Add, BasicCalculator<NoTrace>, calc.add(operand));
+CALCULATOR_METHOD_BENCH(BM_CalculatorNoTrace_Divide, BasicCalculator<NoTrace>, calc.divide(operand));
+CALCULATOR_METHOD_BENCH(BM_CompensatedCalculator_Add, CompensatedCalculator, calc.add(operand));
+
+static void BM_Calculator_DivideByZero(benchmark::State& state) {
+    Calculator calc;
+    double zero = 0.0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(zero);
+        calc.divide(zero);
+        benchmark::DoNotOptimize(calc);
+    }
+}
+BENCHMARK(BM_Calculator_DivideByZero);
+
+static void BM_Calculator_CheckIfResultIsEven(benchmark::State& state) {
+    SilenceCout silence;
+    Calculator calc;
+    calc.add(9);
+    for (auto _ : state) {
+        calc.checkIfResultIsEven();
+    }
+}
+BENCHMARK(BM_Calculator_CheckIfResultIsEven);
+
+static void BM_Calculator_CheckIfPositive(benchmark::State& state) {
+    SilenceCout silence;
+    Calculator calc;
+    calc.add(9);
+    for (auto _ : state) {
+        calc.checkIfPositive();
+    }
+}
+BENCHMARK(BM_Calculator_CheckIfPositive);
+
+// The non-flushing overload, as a per-record report would call it
+static void BM_Calculator_CheckIfPositiveStream(benchmark::State& state) {
+    NullBuffer sink;
+    std::ostream out(&sink);
+    Calculator calc;
+    calc.add(9);
+    for (auto _ : state) {
+        calc.checkIfPositive(out);
+    }
+}
+BENCHMARK(BM_Calculator_CheckIfPositiveStream);
+
+static void BM_Calculator_ClassifySign(benchmark::State& state) {
+    Calculator calc;
+    calc.add(9);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(calc.classifySign());
+    }
+}
+BENCHMARK(BM_Calculator_ClassifySign);
+
+// The add -> multiply -> subtract -> divide -> powerOf chain from the demo
+template <typename CalculatorType>
+static void BM_Calculator_Chain(benchmark::State& state) {
+    double operands[4] = {10, 5, 20, 10};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(operands);
+        CalculatorType calc;
+        calc.add(operands[0]);
+        calc.multiply(operands[1]);
+        calc.subtract(operands[2]);
+        calc.divide(operands[3]);
+        calc.powerOf(2);
+        benchmark::DoNotOptimize(calc.getValue());
+    }
+    state.SetItemsProcessed(state.iterations() * 5);
+}
+BENCHMARK_TEMPLATE(BM_Calculator_Chain, Calculator);
+BENCHMARK_TEMPLATE(BM_Calculator_Chain, BasicCalculator<NoTrace>);
+
+// One operation across many calculators: an array of Calculator objects
+// against the structure-of-arrays CalculatorBank
+static void BM_CalculatorArray_AddEach(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<Calculator> calcs(n);
+    std::vector<double> operands = makeOperands(n, 1.0);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < n; ++i) {
+            calcs[i].add(operands[i]);
+        }
+        benchmark::ClobberMemory();
+    }
+    setBatchCounters(state, 2);
+}
+BENCHMARK(BM_CalculatorArray_AddEach)->RangeMultiplier(100)->Range(100, 10000000);
+
+static void BM_CalculatorBank_AddEach(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    CalculatorBank bank(n);
+    std::vector<double> operands = makeOperands(n, 1.0);
+    for (auto _ : state) {
+        bank.addEach(operands.data());
+        benchmark::ClobberMemory();
+    }
+    setBatchCounters(state, 2);
+}
+BENCHMARK(BM_CalculatorBank_AddEach)->RangeMultiplier(100)->Range(100, 10000000);
+
+static void BM_FloatCalculatorBank_AddEach(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    FloatCalculatorBank bank(n);
+    std::vector<float> operands = makeNarrowOperands<float>(n, 1.0);
+    for (auto _ : state) {
+        bank.addEach(operands.data());
+        benchmark::ClobberMemory();
+    }
+    setBatchCounters(state, 2, sizeof(float));
+}
+BENCHMARK(BM_FloatCalculatorBank_AddEach)->RangeMultiplier(100)->Range(100, 10000000);
+
+static void BM_CalculatorBank_DivideEach(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    CalculatorBank bank(n, 1.0);
+    std::vector<double> divisors = makeOperands(n, 0.0); // every 1000th divisor is zero
+    for (auto _ : state) {
+        bank.divideEach(divisors.data());
+        benchmark::ClobberMemory();
+    }
+    setBatchCounters(state, 2);
+}
+BENCHMARK(BM_CalculatorBank_DivideEach)->RangeMultiplier(100)->Range(100, 10000000);
+
+// Interest on positive balances only, selected with a sign mask
+static void BM_CalculatorBank_MaskedMultiply(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    CalculatorBank bank(n);
+    std::vector<double> balances = makeOperands(n, -0.5);
+    bank.addEach(balances.data());
+    std::vector<std::uint64_t> positive((n + 63) / 64);
+    std::vector<std::uint64_t> zero((n + 63) / 64);
+    std::vector<std::uint64_t> negative((n + 63) / 64);
+    for (auto _ : state) {
+        bank.signMasks(positive.data(), zero.data(), negative.data());
+        bank.multiply(1.0000001, positive.data());
+        benchmark::ClobberMemory();
+    }
+    setBatchCounters(state, 1);
+}
+BENCHMARK(BM_CalculatorBank_MaskedMultiply)->RangeMultiplier(100)->Range(100, 10000000);
+
+// Many threads feeding one shared accumulator
+static void BM_ConcurrentCalculator_Add(benchmark::State& state) {
+    static ConcurrentCalculator shared;
+    double operand = 1.0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(operand);
+        shared.add(operand);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConcurrentCalculator_Add)->ThreadRange(1, 8)->UseRealTime();
+
+// Round trip of one request through the service: the unbatched latency
+static void BM_CalculationService_Future(benchmark::State& state) {
+    ServiceOptions options;
+    options.workers = 1;
+    CalculationService service(options);
+    double lhs = 1.0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(service.submit(Operation::Multiply, lhs, 1.0000001).get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CalculationService_Future)->UseRealTime();
+
+// A burst of callback requests from one thread, coalesced by the workers
+static void BM_CalculationService_Burst(benchmark::State& state) {
+    const std::size_t burst = static_cast<std::size_t>(state.range(0));
+    CalculationService service;
+    std::atomic<std::size_t> done(0);
+    std::size_t submitted = 0;
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < burst; ++i) {
+            service.submit(Operation::Add, static_cast<double>(i), 1.0,
+                           [&done](Utils::MathResult) { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+        submitted += burst;
+        while (done.load(std::memory_order_relaxed) != submitted) {
+            std::this_thread::yield();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(burst));
+    const ServiceStats stats = service.getStats();
+    state.counters["batch"] = stats.batches != 0 ? static_cast<double>(stats.requests) / stats.batches : 0.0;
+}
+BENCHMARK(BM_CalculationService_Burst)->RangeMultiplier(16)->Range(1, 4096)->UseRealTime();
+
+#ifdef CALCULATOR_COROUTINES
+// The demo chain (add, multiply, subtract, divide, powerOf) as a coroutine
+static Chain demoChain(ChainScheduler& scheduler, double start, double& out) {
+    double value = co_await scheduler.add(start, 10);
+    value = co_await scheduler.multiply(value, 5);
+    value = co_await scheduler.subtract(value, 20);
+    value = co_await scheduler.divide(value, 10);
+    out = co_await scheduler.powerOf(value, 2);
+}
+
+// N interleaved chains, each step batched across all of them
+static void BM_ChainScheduler_Chains(benchmark::State& state) {
+    const std::size_t chains = static_cast<std::size_t>(state.range(0));
+    const std::vector<double> starts = makeOperands(chains, 1.0);
+    std::vector<double> results(chains);
+    ChainScheduler scheduler;
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < chains; ++i) {
+            scheduler.spawn(demoChain(scheduler, starts[i], results[i]));
+        }
+        scheduler.run();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(chains));
+}
+BENCHMARK(BM_ChainScheduler_Chains)->RangeMultiplier(16)->Range(1, 65536);
+#endif
+
+// Reconstructing a session from its journal
+static void BM_OperationJournal_Replay(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    const Operation cycle[4] = {Operation::Add, Operation::Multiply, Operation::Subtract, Operation::Divide};
+    OperationJournal journal(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        journal.record(cycle[i % 4], 1.0 + static_cast<double>(i % 1000) * 0.001);
+    }
+    for (auto _ : state) {
+        Calculator calc;
+        journal.replayInto(calc);
+        benchmark::DoNotOptimize(calc.getValue());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(n * sizeof(JournalEntry)));
+}
+BENCHMARK(BM_OperationJournal_Replay)->RangeMultiplier(10)->Range(1, 10000000);
+
+// The same replay from a memory-mapped session file (page cache warm after the first run)
+static void BM_MappedSession_Replay(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    const Operation cycle[4] = {Operation::Add, Operation::Multiply, Operation::Subtract, Operation::Divide};
+    const std::string path = "calculator_bench_session.bin";
+    {
+        SessionWriter writer(path);
+        for (std::size_t i = 0; i < n; ++i) {
+            writer.record(cycle[i % 4], 1.0 + static_cast<double>(i % 1000) * 0.001);
+        }
+    }
+    for (auto _ : state) {
+        MappedSession session(path);
+        Calculator calc;
+        session.replayInto(calc);
+        benchmark::DoNotOptimize(calc.getValue());
+    }
+    std::remove(path.c_str());
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(n * sizeof(JournalEntry)));
+}
+BENCHMARK(BM_MappedSession_Replay)->RangeMultiplier(10)->Range(1, 10000000);
+
+// Warm startup of a bank from a mapped snapshot instead of replaying its history
+static void BM_Snapshot_RestoreBank(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    const std::string path = "calculator_bench_snapshot.bin";
+    {
+        CalculatorBank bank(n, 1.0);
+        bank.multiply(3.0);
+        writeSnapshot(path, bank);
+    }
+    CalculatorBank bank;
+    for (auto _ : state) {
+        MappedSnapshot snapshot(path);
+        snapshot.restoreInto(bank);
+        benchmark::DoNotOptimize(bank.getValues());
+    }
+    std::remove(path.c_str());
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(n * (2 * sizeof(double) + 1)));
+}
+BENCHMARK(BM_Snapshot_RestoreBank)->RangeMultiplier(100)->Range(1, 1000000);
+
+// Taking the snapshot: write to a temporary file and rename it into place
+static void BM_Snapshot_WriteBank(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    const std::string path = "calculator_bench_snapshot.bin";
+    CalculatorBank bank(n, 1.0);
+    bank.multiply(3.0);
+    for (auto _ : state) {
+        writeSnapshot(path, bank);
+    }
+    std::remove(path.c_str());
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(n * (2 * sizeof(double) + 1)));
+}
+BENCHMARK(BM_Snapshot_WriteBank)->RangeMultiplier(100)->Range(1, 1000000);
+
+// ---------------------------------------------------------------------------
+// Expressions
+// ---------------------------------------------------------------------------
+
+static void BM_Expression_Compile(benchmark::State& state) {
+    const std::string source = "(x + 1) * y - x ^ 3 / 2";
+    for (auto _ : state) {
+        Expr::CompiledExpression expression = Expr::CompiledExpression::compile(source);
+        benchmark::DoNotOptimize(expression);
+    }
+}
+BENCHMARK(BM_Expression_Compile);
+
+static void BM_Expression_Evaluate(benchmark::State& state) {
+    const Expr::CompiledExpression expression = Expr::CompiledExpression::compile("(x + 1) * y - x ^ 3 / 2");
+    double variables[2] = {1.5, 2.5};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(variables);
+        double result = expression.evaluate(variables);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_Expression_Evaluate);
+
+static void BM_CachedExpression_Evaluate(benchmark::State& state) {
+    const Expr::CachedExpression expression(Expr::CompiledExpression::compile("(x + 1) * y - x ^ 3 / 2"));
+    double variables[2] = {1.5, 2.5};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(variables);
+        double result = expression.evaluate(variables);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_CachedExpression_Evaluate);
+
+static void BM_Expression_EvaluateBatch(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    const Expr::CompiledExpression expression = Expr::CompiledExpression::compile("(x + 1) * y - x ^ 3 / 2");
+    std::vector<double> x = makeOperands(n, 1.0);
+    std::vector<double> y = makeOperands(n, 2.0);
+    std::vector<double> out(n);
+    const double* columns[2] = {x.data(), y.data()};
+    for (auto _ : state) {
+        expression.evaluate(columns, out.data(), n);
+        benchmark::ClobberMemory();
+    }
+    setBatchCounters(state, 3);
+}
+BENCHMARK(BM_Expression_EvaluateBatch)->RangeMultiplier(10)->Range(1, 10000000);
+
+static void BM_ExprKernel_EvaluateBatch(benchmark::State& state) {
+    using namespace Expr::Kernel;
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    const auto formula = (var<0> + 1.0) * var<1> - pow<3>(var<0>) / 2.0;
+    std::vector<double> x = makeOperands(n, 1.0);
+    std::vector<double> y = makeOperands(n, 2.0);
+    std::vector<double> out(n);
+    for (auto _ : state) {
+        evaluate(formula, out.data(), n, x.data(), y.data());
+        benchmark::ClobberMemory();
+    }
+    setBatchCounters(state, 3);
+}
+BENCHMARK(BM_ExprKernel_EvaluateBatch)->RangeMultiplier(10)->Range(1, 10000000);
+
+BENCHMARK_MAIN();
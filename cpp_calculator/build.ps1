@@ -4,7 +4,7 @@
 Write-Host "Building C++ Calculator..." -ForegroundColor Green
 
 # Compile with g++
-g++ -I.\include -o calculator.exe src\main.cpp src\Calculator.cpp src\MathUtils.cpp
+g++ -std=c++17 -pthread -I.\include -o calculator.exe src\main.cpp src\StreamMode.cpp src\BigInt.cpp src\Calculator.cpp src\CalculationService.cpp src\CalculatorBank.cpp src\ConcurrentCalculator.cpp src\MathUtils.cpp src\MathUtilsFloat.cpp src\MemoCache.cpp src\Expression.cpp src\GpuBatch.cpp src\Instrumentation.cpp src\MappedFile.cpp src\OperationJournal.cpp src\ParallelReduce.cpp src\SessionFile.cpp src\Snapshot.cpp
 
 if ($LASTEXITCODE -eq 0) {
     Write-Host "Build successful! Run with: .\calculator.exe" -ForegroundColor Green
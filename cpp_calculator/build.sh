@@ -0,0 +1,20 @@
+#!/bin/sh
+# Configure and build with one of the presets in CMakePresets.json
+# Usage: ./build.sh [preset]    (default release-lto; also x86-64-v3, x86-64-v4)
+#        ./build.sh pgo         instrument, train on calculator_bench, rebuild with the profile
+
+set -e
+cd "$(dirname "$0")"
+preset="${1:-release-lto}"
+
+if [ "$preset" = "pgo" ]; then
+    cmake --preset pgo-generate
+    cmake --build --preset pgo-train
+    cmake --preset pgo-use
+    cmake --build --preset pgo-use
+    echo "Build successful! Run with: ./build/pgo-use/calculator"
+else
+    cmake --preset "$preset"
+    cmake --build --preset "$preset"
+    echo "Build successful! Run with: ./build/$preset/calculator"
+fi
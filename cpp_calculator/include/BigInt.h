@@ -0,0 +1,190 @@
+#ifndef BIGINT_H
+#define BIGINT_H
+
+#include "Numeric.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace Utils {
+    // Arbitrary-precision signed integer, stored as sign and magnitude in
+    // 32-bit limbs (least significant first). Magnitudes of up to 128 bits
+    // live in an inline buffer, so arithmetic on values that fit in 128 bits
+    // never allocates; larger ones move to heap limbs. Multiplication switches
+    // from schoolbook to Karatsuba for long operands. Division truncates
+    // toward zero, like the built-in integers.
+    class BigInt {
+    public:
+        typedef std::uint32_t Limb;
+
+        // Limbs held without allocating: 128 bits
+        static const std::size_t inlineLimbs = 4;
+        // Products and powers above this many limbs (2^30 bits) are reported
+        // as Overflow by Arithmetic<BigInt> rather than exhausting memory
+        static const std::size_t maxLimbs = std::size_t(1) << 25;
+
+        BigInt() noexcept : length(0), capacity(inlineLimbs), negative(false) {}
+        // Implicit, so that calculator code can pass integer literals
+        BigInt(std::int64_t value) noexcept;
+        BigInt(const BigInt& other);
+        BigInt(BigInt&& other) noexcept;
+        BigInt& operator=(const BigInt& other);
+        BigInt& operator=(BigInt&& other) noexcept;
+        ~BigInt();
+
+        // Parses an optionally signed decimal integer; throws std::invalid_argument
+        static BigInt fromString(const std::string& text);
+        std::string toString() const;
+        // Nearest double, or +-infinity beyond its range
+        double toDouble() const;
+
+        bool isZero() const {
+            return length == 0;
+        }
+
+        bool isNegative() const {
+            return negative;
+        }
+
+        bool isOdd() const {
+            return length != 0 && (limbs()[0] & 1u) != 0;
+        }
+
+        // True while the magnitude is in the inline buffer, i.e. not on the heap
+        bool isInline() const {
+            return capacity == inlineLimbs;
+        }
+
+        std::size_t limbCount() const {
+            return length;
+        }
+
+        // Bits in the magnitude; 0 for zero
+        std::size_t bitLength() const;
+
+        // Negative, zero or positive as *this is less than, equal to or greater than other
+        int compare(const BigInt& other) const;
+
+        BigInt operator-() const;
+        friend BigInt operator+(const BigInt& a, const BigInt& b);
+        friend BigInt operator-(const BigInt& a, const BigInt& b);
+        friend BigInt operator*(const BigInt& a, const BigInt& b);
+        // Throw std::runtime_error("Division by zero error") for a zero divisor
+        friend BigInt operator/(const BigInt& a, const BigInt& b);
+        friend BigInt operator%(const BigInt& a, const BigInt& b);
+
+        // Truncating division; the remainder has the sign of the dividend
+        static void divide(const BigInt& dividend, const BigInt& divisor, BigInt& quotient, BigInt& remainder);
+        // Exponentiation by squaring on the Karatsuba multiplication
+        static BigInt power(const BigInt& base, unsigned int exponent);
+
+        friend bool operator==(const BigInt& a, const BigInt& b) {
+            return a.compare(b) == 0;
+        }
+
+        friend bool operator!=(const BigInt& a, const BigInt& b) {
+            return a.compare(b) != 0;
+        }
+
+        friend bool operator<(const BigInt& a, const BigInt& b) {
+            return a.compare(b) < 0;
+        }
+
+        friend bool operator>(const BigInt& a, const BigInt& b) {
+            return a.compare(b) > 0;
+        }
+
+        friend bool operator<=(const BigInt& a, const BigInt& b) {
+            return a.compare(b) <= 0;
+        }
+
+        friend bool operator>=(const BigInt& a, const BigInt& b) {
+            return a.compare(b) >= 0;
+        }
+
+        // Decimal, e.g. "-340282366920938463463374607431768211456"
+        friend std::ostream& operator<<(std::ostream& out, const BigInt& value);
+
+    private:
+        const Limb* limbs() const {
+            return isInline() ? local : heap;
+        }
+
+        Limb* limbs() {
+            return isInline() ? local : heap;
+        }
+
+        // Makes room for count limbs; the current limbs are not kept
+        void allocate(std::size_t count);
+        // Drops leading zero limbs; zero is never negative
+        void trim();
+        // a + b or a - b, as b's sign is flipped by subtract
+        static BigInt addSigned(const BigInt& a, const BigInt& b, bool subtract);
+
+        std::uint32_t length;
+        std::uint32_t capacity;
+        bool negative;
+        union {
+            Limb local[inlineLimbs];
+            Limb* heap;
+        };
+    };
+
+    // Exact arithmetic on BigInt. Like std::int64_t, a negative exponent is
+    // InvalidExponent; sums never overflow, and products and powers only past
+    // BigInt::maxLimbs.
+    template <>
+    struct Arithmetic<BigInt> {
+        typedef CheckedValue<BigInt> Result;
+
+        static Result add(const BigInt& a, const BigInt& b) {
+            return Result{a + b, MathStatus::Ok};
+        }
+
+        static Result subtract(const BigInt& a, const BigInt& b) {
+            return Result{a - b, MathStatus::Ok};
+        }
+
+        static Result multiply(const BigInt& a, const BigInt& b) {
+            if (a.limbCount() + b.limbCount() > BigInt::maxLimbs) {
+                return Result{BigInt(), MathStatus::Overflow};
+            }
+            return Result{a * b, MathStatus::Ok};
+        }
+
+        static Result divide(const BigInt& a, const BigInt& b) {
+            if (b.isZero()) {
+                return Result{BigInt(), MathStatus::DivisionByZero};
+            }
+            return Result{a / b, MathStatus::Ok};
+        }
+
+        static Result power(const BigInt& base, int exponent) {
+            if (exponent < 0) {
+                return Result{BigInt(), MathStatus::InvalidExponent};
+            }
+            // |base| <= 1 never grows; otherwise the result has at most
+            // bitLength * exponent bits
+            if (base.bitLength() > 1 &&
+                base.bitLength() * static_cast<std::uint64_t>(exponent) > std::uint64_t(BigInt::maxLimbs) * 32) {
+                return Result{BigInt(), MathStatus::Overflow};
+            }
+            return Result{BigInt::power(base, static_cast<unsigned int>(exponent)), MathStatus::Ok};
+        }
+
+        static Parity parity(const BigInt& value) {
+            return value.isOdd() ? Parity::Odd : Parity::Even;
+        }
+
+        static Sign sign(const BigInt& value) {
+            return value.isZero() ? Sign::Zero : value.isNegative() ? Sign::Negative : Sign::Positive;
+        }
+
+        static double toDouble(const BigInt& value) {
+            return value.toDouble();
+        }
+    };
+}
+
+#endif // BIGINT_H
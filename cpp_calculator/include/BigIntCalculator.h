@@ -0,0 +1,11 @@
+#ifndef BIGINT_CALCULATOR_H
+#define BIGINT_CALCULATOR_H
+
+#include "BigInt.h"
+#include "Calculator.h"
+
+// Exact integers of any size, allocation-free up to 128 bits. Kept apart from
+// Calculator.h so only code that uses it pays for BigInt.h.
+typedef BasicCalculator<ExactTrace<Utils::BigInt>, ExactAccumulate<Utils::BigInt> > BigIntCalculator;
+
+#endif // BIGINT_CALCULATOR_H
@@ -0,0 +1,78 @@
+#ifndef CALCULATIONSERVICE_H
+#define CALCULATIONSERVICE_H
+
+#include "MathUtils.h"
+#include "Operation.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+// Controls the worker pool of a CalculationService
+struct ServiceOptions {
+    // Worker threads; 0 uses one per hardware thread
+    unsigned workers = 0;
+    // Most requests a worker takes from its queue for one batch
+    std::size_t maxBatch = 256;
+};
+
+// Counters describing how requests were coalesced
+struct ServiceStats {
+    std::uint64_t requests;
+    std::uint64_t batches;
+};
+
+// Asynchronous front end for one-off calculations (lhs op rhs). Requests go
+// onto per-worker lock-free multi-producer queues; each worker drains what
+// has arrived, up to maxBatch requests, and runs them grouped by operation
+// through the MathUtils batch kernels. A worker never waits for a batch to
+// fill, so batching only grows with load and an idle service answers a lone
+// request immediately. Results are bit-for-bit what the scalar MathUtils
+// operations give.
+class CalculationService {
+public:
+    // Called on a worker thread with the result of a request; must not throw
+    typedef std::function<void(Utils::MathResult)> Callback;
+
+    // Starts the worker threads
+    explicit CalculationService(const ServiceOptions& options = ServiceOptions());
+    // Finishes every accepted request, then stops the workers
+    ~CalculationService();
+
+    CalculationService(const CalculationService&) = delete;
+    CalculationService& operator=(const CalculationService&) = delete;
+
+    // Queues lhs op rhs. operation must be Add, Subtract, Multiply, Divide or
+    // Power (rhs is then an integer exponent), otherwise std::invalid_argument
+    // is thrown. Division by zero and non-integer exponents are reported through
+    // the result status. Throws std::runtime_error after shutdown().
+    std::future<Utils::MathResult> submit(Operation operation, double lhs, double rhs);
+    void submit(Operation operation, double lhs, double rhs, Callback callback);
+
+    // Stops accepting requests, finishes the accepted ones and joins the
+    // workers. Called by the destructor; calling it again does nothing.
+    void shutdown();
+
+    unsigned getWorkerCount() const;
+    ServiceStats getStats() const;
+
+private:
+    struct Request;
+    struct Worker;
+
+    void enqueue(Request* request);
+    static void run(Worker& worker, std::size_t maxBatch);
+    static void process(Worker& worker, std::size_t count);
+
+    std::vector<std::unique_ptr<Worker> > workers;
+    std::size_t maxBatch;
+    std::atomic<std::size_t> nextWorker;
+    std::atomic<unsigned> activeSubmits;
+    std::atomic<bool> stopping;
+    bool stopped;
+};
+
+#endif // CALCULATIONSERVICE_H
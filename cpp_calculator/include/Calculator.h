@@ -1,38 +1,615 @@
 #ifndef CALCULATOR_H
 #define CALCULATOR_H
 
+#include "Instrumentation.h"
 #include "MathUtils.h"
+#include "Numeric.h"
+#include "Operation.h"
+#include "ParallelReduce.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+#include <sstream>
 #include <string>
+#include <type_traits>
+
+// Formats an operation record the way getLastOperation() reports it
+std::string describeOperation(Operation operation, double operand);
+// The same, allocating the string from a memory resource such as a request arena
+std::pmr::string describeOperation(Operation operation, double operand, std::pmr::memory_resource* resource);
+// The same for Add, Subtract, Multiply and Divide with the operand already
+// formatted, e.g. an exact value printed in full
+std::string describeOperation(Operation operation, const std::string& operand);
+
+// Tracing policy that remembers the last operation for getLastOperation()
+class Trace {
+private:
+    // The last operation is kept as a compact record and only formatted on demand
+    double lastOperand;
+    std::size_t divisionErrors;
+    Operation lastOperation;
+
+public:
+    Trace() : lastOperand(0.0), divisionErrors(0), lastOperation(Operation::Initialized) {}
+
+    void record(Operation operation, double operand) {
+        lastOperation = operation;
+        lastOperand = operand;
+    }
+
+    // Called by BasicCalculator::restore(); sets the record without side effects
+    void restore(Operation operation, double operand) {
+        record(operation, operand);
+    }
+
+    // Called instead of record() when a division by zero is rejected
+    void recordDivisionError(double divisor) {
+        ++divisionErrors;
+        record(Operation::DivisionError, divisor);
+    }
+
+    std::string describe() const {
+        return describeOperation(lastOperation, lastOperand);
+    }
+
+    std::pmr::string describe(std::pmr::memory_resource* resource) const {
+        return describeOperation(lastOperation, lastOperand, resource);
+    }
+
+    std::size_t divisionErrorCount() const {
+        return divisionErrors;
+    }
+
+    Operation operation() const {
+        return lastOperation;
+    }
+
+    double operand() const {
+        return lastOperand;
+    }
+};
+
+// Tracing policy for the exact calculators: like Trace, but also keeps the
+// operand of the last add/subtract/multiply/divide as a Number, so that
+// getLastOperation() prints it in full ("Added 1234567890123") instead of
+// rounding it through a double. Records set by restore() only have the double.
+template <typename Number>
+class ExactTrace : public Trace {
+private:
+    Number exactOperand;
+    bool hasExactOperand;
+
+public:
+    ExactTrace() : exactOperand(), hasExactOperand(false) {}
+
+    // Power and Reset, whose operands are not values
+    void record(Operation operation, double operand) {
+        Trace::record(operation, operand);
+        hasExactOperand = false;
+    }
+
+    void record(Operation operation, const Number& operand) {
+        Trace::record(operation, Utils::Arithmetic<Number>::toDouble(operand));
+        exactOperand = operand;
+        hasExactOperand = true;
+    }
+
+    void restore(Operation operation, double operand) {
+        record(operation, operand);
+    }
+
+    void recordDivisionError(const Number& divisor) {
+        Trace::recordDivisionError(Utils::Arithmetic<Number>::toDouble(divisor));
+        hasExactOperand = false;
+    }
+
+    std::string describe() const {
+        if (!hasExactOperand) {
+            return Trace::describe();
+        }
+        std::ostringstream text;
+        text << exactOperand;
+        return describeOperation(operation(), text.str());
+    }
+
+    std::pmr::string describe(std::pmr::memory_resource* resource) const {
+        if (!hasExactOperand) {
+            return Trace::describe(resource);
+        }
+        const std::string text = describe();
+        return std::pmr::string(text.data(), text.size(), resource);
+    }
+};
+
+// Tracing policy that records nothing, so the calculator holds only its value
+class NoTrace {
+public:
+    template <typename Operand>
+    void record(Operation, const Operand&) {}
+    template <typename Operand>
+    void recordDivisionError(const Operand&) {}
+    void restore(Operation, double) {}
+};
+
+// Accumulation policy keeping the value in a plain double
+class PlainAccumulate {
+private:
+    double value;
+
+public:
+    typedef double value_type;
+
+    PlainAccumulate() : value(0.0) {}
+
+    void add(double operand) {
+        value = Utils::MathUtils::add(value, operand);
+    }
+
+    void subtract(double operand) {
+        value = Utils::MathUtils::subtract(value, operand);
+    }
+
+    // Adds the reduction of an array and returns the total that was added
+    double addAll(const double* values, std::size_t n, const Utils::ReduceOptions& options) {
+        const double total = Utils::ParallelReduce::sum(values, n, options);
+        add(total);
+        return total;
+    }
+
+    void set(double newValue) {
+        value = newValue;
+    }
+
+    double get() const {
+        return value;
+    }
+};
+
+// Accumulation policy keeping a Neumaier carry term next to the value, so long
+// streams of add/subtract do not accumulate rounding error. Multiplicative
+// operations fold the carry into the value and start a fresh carry.
+class CompensatedAccumulate {
+private:
+    double value;
+    double carry;
+
+public:
+    typedef double value_type;
+
+    CompensatedAccumulate() : value(0.0), carry(0.0) {}
+
+    void add(double operand) {
+        Utils::MathUtils::compensatedAdd(value, carry, operand);
+    }
+
+    void subtract(double operand) {
+        Utils::MathUtils::compensatedAdd(value, carry, -operand);
+    }
+
+    // Always reduces the array with compensated summation, whatever options asks for
+    double addAll(const double* values, std::size_t n, const Utils::ReduceOptions& options) {
+        Utils::ReduceOptions compensated = options;
+        compensated.summation = Utils::Summation::Compensated;
+        const double total = Utils::ParallelReduce::sum(values, n, compensated);
+        add(total);
+        return total;
+    }
+
+    void set(double newValue) {
+        value = newValue;
+        carry = 0.0;
+    }
+
+    double get() const {
+        return value + carry;
+    }
+};
+
+// Accumulation policy for exact values: std::int64_t, Utils::Fixed<Decimals>,
+// Utils::BigInt (see BigIntCalculator.h) or any type with a Utils::Arithmetic
+// specialization. Every operation is overflow-checked, and one whose result
+// does not fit throws std::overflow_error with the value left unchanged.
+template <typename Number>
+class ExactAccumulate {
+private:
+    Number value;
+
+public:
+    typedef Number value_type;
+
+    ExactAccumulate() : value() {}
+
+    void add(const Number& operand) {
+        value = Utils::valueOrThrow(Utils::Arithmetic<Number>::add(value, operand));
+    }
+
+    void subtract(const Number& operand) {
+        value = Utils::valueOrThrow(Utils::Arithmetic<Number>::subtract(value, operand));
+    }
+
+    void set(const Number& newValue) {
+        value = newValue;
+    }
+
+    // Takes over a freshly computed result, e.g. a BigInt's heap limbs
+    void set(Number&& newValue) {
+        value = static_cast<Number&&>(newValue);
+    }
+
+    const Number& get() const {
+        return value;
+    }
+};
+
+template <typename TracePolicy, typename AccumulatePolicy = PlainAccumulate>
+class BasicCalculator : private TracePolicy {
+public:
+    // Type of the value and operands: double, or the exact type of ExactAccumulate
+    typedef typename AccumulatePolicy::value_type value_type;
 
-class Calculator {
 private:
-    double currentValue;
-    std::string lastOperation;
-    
-    // Private helper function
-    bool isPositive(double value) const;
-    
-public:
-    // Constructor
-    Calculator();
-    
-    // Basic operations using MathUtils
-    void add(double value);
-    void subtract(double value);
-    void multiply(double value);
-    void divide(double value);
-    
+    typedef Utils::Arithmetic<value_type> Arithmetic;
+
+    // Holds currentValue (and any compensation state)
+    AccumulatePolicy accumulator;
+
+public:
+    // Constructors
+    BasicCalculator();
+    // Starts with a copy of the given trace policy, for policies that carry state
+    explicit BasicCalculator(const TracePolicy& tracePolicy);
+
+    // Basic operations using MathUtils (Utils::Arithmetic for exact types)
+    void add(const value_type& value);
+    void subtract(const value_type& value);
+    void multiply(const value_type& value);
+    void divide(const value_type& value);
+
     // Advanced operations
     void powerOf(int exponent);
     void reset();
-    
+    // Sets the value directly (e.g. after replaying a journal) and reports
+    // operation/operand as the last operation without applying or tracing it
+    void restore(const value_type& value, Operation operation = Operation::Initialized, double operand = 0.0);
+
+    // Bulk operations folding a whole array into the value across all cores;
+    // double calculators only
+    void addAll(const double* values, std::size_t n,
+                const Utils::ReduceOptions& options = Utils::ReduceOptions());
+    void multiplyAll(const double* values, std::size_t n,
+                     const Utils::ReduceOptions& options = Utils::ReduceOptions());
+
     // Getters
-    double getValue() const;
+    value_type getValue() const;
+    // Only available when TracePolicy keeps a record (e.g. Trace)
     std::string getLastOperation() const;
-    
-    // Utility
+    // The same, with the string allocated from resource (e.g. a monotonic arena
+    // released at the end of a request); the calculator itself never allocates
+    std::pmr::string getLastOperation(std::pmr::memory_resource* resource) const;
+    // The last operation as the record restore() takes, e.g. for snapshots
+    Operation getOperation() const;
+    double getOperand() const;
+    std::size_t getDivisionErrorCount() const;
+
+    // Classification of the current value, with no output
+    Utils::Parity classifyParity() const;
+    Utils::Sign classifySign() const;
+
+    // Utility: print the classification to std::cout and flush
     void checkIfResultIsEven();
     void checkIfPositive();
+    // Write the same line to out without flushing it, for per-record reports
+    void checkIfResultIsEven(std::ostream& out) const;
+    void checkIfPositive(std::ostream& out) const;
 };
 
+// The default calculator traces its last operation
+typedef BasicCalculator<Trace> Calculator;
+// Traces like Calculator, but sums with compensated (Neumaier) accumulation
+typedef BasicCalculator<Trace, CompensatedAccumulate> CompensatedCalculator;
+// Exact integer calculator, e.g. for ledgers kept in integer cents
+typedef BasicCalculator<ExactTrace<std::int64_t>, ExactAccumulate<std::int64_t> > IntegerCalculator;
+// Exact decimal calculator; DecimalCalculator<2> keeps two decimal places
+template <int Decimals>
+using DecimalCalculator =
+    BasicCalculator<ExactTrace<Utils::Fixed<Decimals> >, ExactAccumulate<Utils::Fixed<Decimals> > >;
+
+/**
+ * @brief Constructor - Initializes the calculator with default values
+ * Sets currentValue to 0.0 and lastOperation to "initialized"
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+BasicCalculator<TracePolicy, AccumulatePolicy>::BasicCalculator() {}
+
+/**
+ * @brief Constructor - Initializes the calculator with a given trace policy
+ * @param tracePolicy The policy to copy, e.g. one pointing at an operation journal
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+BasicCalculator<TracePolicy, AccumulatePolicy>::BasicCalculator(const TracePolicy& tracePolicy)
+    : TracePolicy(tracePolicy) {}
+
+/**
+ * @brief Adds a value to the current calculator result
+ * @param value The value to add to currentValue
+ * Uses MathUtils::add, or MathUtils::compensatedAdd with CompensatedAccumulate
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void BasicCalculator<TracePolicy, AccumulatePolicy>::add(const value_type& value) {
+    CALCULATOR_INSTRUMENT(Operation::Add);
+    accumulator.add(value);
+    this->record(Operation::Add, value);
+}
+
+/**
+ * @brief Subtracts a value from the current calculator result
+ * @param value The value to subtract from currentValue
+ * Uses MathUtils::subtract, or MathUtils::compensatedAdd with CompensatedAccumulate
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void BasicCalculator<TracePolicy, AccumulatePolicy>::subtract(const value_type& value) {
+    CALCULATOR_INSTRUMENT(Operation::Subtract);
+    accumulator.subtract(value);
+    this->record(Operation::Subtract, value);
+}
+
+/**
+ * @brief Multiplies the current calculator result by a value
+ * @param value The value to multiply currentValue by
+ * Uses MathUtils::multiply for doubles; exact types throw std::overflow_error
+ * when the product does not fit
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void BasicCalculator<TracePolicy, AccumulatePolicy>::multiply(const value_type& value) {
+    CALCULATOR_INSTRUMENT(Operation::Multiply);
+    accumulator.set(Utils::valueOrThrow(Arithmetic::multiply(accumulator.get(), value)));
+    this->record(Operation::Multiply, value);
+}
+
+/**
+ * @brief Divides the current calculator result by a value
+ * @param value The divisor (cannot be zero)
+ * Uses the non-throwing MathUtils::tryDivide; a zero divisor leaves currentValue
+ * unchanged, sets lastOperation to "Division error" and counts the error.
+ * Exact types throw std::overflow_error for a quotient that does not fit.
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void BasicCalculator<TracePolicy, AccumulatePolicy>::divide(const value_type& value) {
+    CALCULATOR_INSTRUMENT(Operation::Divide);
+    const Utils::CheckedValue<value_type> result = Arithmetic::divide(accumulator.get(), value);
+    if (result.ok()) {
+        accumulator.set(result.value);
+        this->record(Operation::Divide, value);
+    } else if (result.status == Utils::MathStatus::DivisionByZero) {
+        CALCULATOR_INSTRUMENT_COUNT(Operation::DivisionError);
+        this->recordDivisionError(value);
+    } else {
+        Utils::valueOrThrow(result);
+    }
+}
+
+/**
+ * @brief Raises the current calculator result to a power
+ * @param exponent The exponent to raise currentValue to
+ * Uses MathUtils::power for doubles. Exact types throw std::overflow_error when
+ * the power does not fit, and std::domain_error for a negative exponent.
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void BasicCalculator<TracePolicy, AccumulatePolicy>::powerOf(int exponent) {
+    CALCULATOR_INSTRUMENT(Operation::Power);
+    accumulator.set(Utils::valueOrThrow(Arithmetic::power(accumulator.get(), exponent)));
+    this->record(Operation::Power, static_cast<double>(exponent));
+}
+
+/**
+ * @brief Resets the calculator to its initial state
+ * Sets currentValue to 0.0 and lastOperation to "reset"
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void BasicCalculator<TracePolicy, AccumulatePolicy>::reset() {
+    CALCULATOR_INSTRUMENT(Operation::Reset);
+    accumulator.set(value_type());
+    this->record(Operation::Reset, 0.0);
+}
+
+/**
+ * @brief Restores the calculator to a known state
+ * @param value The new current value
+ * @param operation The operation to report as the last one
+ * @param operand The operand to report with it
+ * Unlike the arithmetic methods this does not pass through the trace policy's
+ * record(), so journaling policies do not log the restore itself
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void BasicCalculator<TracePolicy, AccumulatePolicy>::restore(const value_type& value, Operation operation,
+                                                             double operand) {
+    accumulator.set(value);
+    TracePolicy::restore(operation, operand);
+}
+
+/**
+ * @brief Adds the sum of an array of values to the current result
+ * @param values The values to add
+ * @param n Number of values
+ * @param options Summation mode, thread count and chunk size for the reduction
+ * The array is reduced by ParallelReduce::sum and the total is added once, so
+ * the result is reproducible for any thread count but may differ in the last
+ * bits from calling add() n times. lastOperation reports the total added.
+ * With CompensatedAccumulate the reduction is always compensated.
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void BasicCalculator<TracePolicy, AccumulatePolicy>::addAll(const double* values, std::size_t n,
+                                          const Utils::ReduceOptions& options) {
+    CALCULATOR_INSTRUMENT(Operation::Add);
+    const double total = accumulator.addAll(values, n, options);
+    this->record(Operation::Add, total);
+}
+
+/**
+ * @brief Multiplies the current result by the product of an array of values
+ * @param values The factors
+ * @param n Number of factors
+ * @param options Thread count and chunk size for the reduction
+ * lastOperation reports the combined factor
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void BasicCalculator<TracePolicy, AccumulatePolicy>::multiplyAll(const double* values, std::size_t n,
+                                               const Utils::ReduceOptions& options) {
+    CALCULATOR_INSTRUMENT(Operation::Multiply);
+    const double total = Utils::ParallelReduce::product(values, n, options);
+    accumulator.set(Utils::MathUtils::multiply(accumulator.get(), total));
+    this->record(Operation::Multiply, total);
+}
+
+/**
+ * @brief Gets the current calculator result
+ * @return The current value stored in the calculator
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+typename BasicCalculator<TracePolicy, AccumulatePolicy>::value_type
+BasicCalculator<TracePolicy, AccumulatePolicy>::getValue() const {
+    return accumulator.get();
+}
+
+/**
+ * @brief Gets the description of the last operation performed
+ * @return A string describing the last operation executed
+ * The description is formatted from the stored operation record on each call
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+std::string BasicCalculator<TracePolicy, AccumulatePolicy>::getLastOperation() const {
+    return this->describe();
+}
+
+/**
+ * @brief Gets the description of the last operation, allocated from a memory resource
+ * @param resource Supplies the memory for the returned string
+ * @return A string describing the last operation executed
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+std::pmr::string BasicCalculator<TracePolicy, AccumulatePolicy>::getLastOperation(
+    std::pmr::memory_resource* resource) const {
+    return this->describe(resource);
+}
+
+/**
+ * @brief Gets the code of the last operation performed
+ * @return The operation restore() would report again
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+Operation BasicCalculator<TracePolicy, AccumulatePolicy>::getOperation() const {
+    return this->operation();
+}
+
+/**
+ * @brief Gets the operand of the last operation performed
+ * @return The operand (the exponent for Power, the divisor for DivisionError)
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+double BasicCalculator<TracePolicy, AccumulatePolicy>::getOperand() const {
+    return this->operand();
+}
+
+/**
+ * @brief Gets the number of divisions by zero rejected by this calculator
+ * @return How many times divide() was called with a zero divisor
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+std::size_t BasicCalculator<TracePolicy, AccumulatePolicy>::getDivisionErrorCount() const {
+    return this->divisionErrorCount();
+}
+
+/**
+ * @brief Classifies the current result as even or odd
+ * @return The parity of the integer part of currentValue, or NotFinite
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+Utils::Parity BasicCalculator<TracePolicy, AccumulatePolicy>::classifyParity() const {
+    return Arithmetic::parity(getValue());
+}
+
+/**
+ * @brief Classifies the current result by sign
+ * @return Positive, Zero, Negative or NotANumber
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+Utils::Sign BasicCalculator<TracePolicy, AccumulatePolicy>::classifySign() const {
+    return Arithmetic::sign(getValue());
+}
+
+/**
+ * @brief Checks if the current result is an even number
+ * Prints the result to stdout and flushes it
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void BasicCalculator<TracePolicy, AccumulatePolicy>::checkIfResultIsEven() {
+    checkIfResultIsEven(std::cout);
+    std::cout.flush();
+}
+
+/**
+ * @brief Writes whether the current result is even to a stream
+ * @param out The stream; only a newline is written, it is never flushed
+ * Classifies the integer part of currentValue with MathUtils::parity, so values
+ * outside the range of int are handled instead of overflowing a cast. Exact
+ * types are classified on the value itself and printed as they are.
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void BasicCalculator<TracePolicy, AccumulatePolicy>::checkIfResultIsEven(std::ostream& out) const {
+    const value_type currentValue = getValue();
+    const Utils::Parity parity = classifyParity();
+    if constexpr (!std::is_floating_point<value_type>::value) {
+        out << "Current value " << currentValue << (parity == Utils::Parity::Even ? " is even\n" : " is odd\n");
+    } else {
+        if (parity == Utils::Parity::NotFinite) {
+            out << "Current value " << currentValue << " is neither even nor odd\n";
+            return;
+        }
+        // Adding 0.0 turns the -0 that truncating a small negative value gives into 0
+        const double integerPart = std::trunc(currentValue) + 0.0;
+        out << "Current value ";
+        if (std::fabs(integerPart) < 9.2e18) {
+            out << static_cast<long long>(integerPart);
+        } else {
+            out << integerPart;
+        }
+        out << (parity == Utils::Parity::Even ? " is even\n" : " is odd\n");
+    }
+}
+
+/**
+ * @brief Checks if the current result is positive
+ * Prints the result to stdout and flushes it
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void BasicCalculator<TracePolicy, AccumulatePolicy>::checkIfPositive() {
+    checkIfPositive(std::cout);
+    std::cout.flush();
+}
+
+/**
+ * @brief Writes the sign of the current result to a stream
+ * @param out The stream; only a newline is written, it is never flushed
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void BasicCalculator<TracePolicy, AccumulatePolicy>::checkIfPositive(std::ostream& out) const {
+    const value_type currentValue = getValue();
+    switch (classifySign()) {
+    case Utils::Sign::Positive:
+        out << "Current value " << currentValue << " is positive\n";
+        break;
+    case Utils::Sign::Zero:
+        out << "Current value is zero\n";
+        break;
+    case Utils::Sign::Negative:
+        out << "Current value " << currentValue << " is negative\n";
+        break;
+    default:
+        out << "Current value " << currentValue << " is not a number\n";
+        break;
+    }
+}
+
 #endif // CALCULATOR_H
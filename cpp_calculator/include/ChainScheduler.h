@@ -0,0 +1,152 @@
+#ifndef CHAINSCHEDULER_H
+#define CHAINSCHEDULER_H
+
+// Requires C++20 coroutines: link Calculator::coro, which is built when
+// CALCULATOR_ENABLE_COROUTINES is ON and the compiler supports them.
+#include "MathUtils.h"
+#include "Operation.h"
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <vector>
+
+class ChainScheduler;
+
+// A calculation chain written as a coroutine. Its steps co_await the
+// scheduler's operations, and it can wait for values through ChainInput:
+//
+//     Chain step(ChainScheduler& s, double x, double& out) {
+//         double v = co_await s.add(x, 10);
+//         v = co_await s.multiply(v, 5);
+//         out = co_await s.powerOf(v, 2);
+//     }
+//
+// The coroutine starts suspended; ChainScheduler::spawn takes ownership.
+class Chain {
+public:
+    struct promise_type {
+        std::exception_ptr error;
+
+        Chain get_return_object() {
+            return Chain(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { error = std::current_exception(); }
+    };
+
+    Chain(Chain&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    Chain& operator=(Chain&& other) noexcept;
+    Chain(const Chain&) = delete;
+    Chain& operator=(const Chain&) = delete;
+    ~Chain();
+
+private:
+    friend class ChainScheduler;
+    explicit Chain(std::coroutine_handle<promise_type> h) : handle(h) {}
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Awaitable result of one arithmetic step; obtained from ChainScheduler
+class ChainStep {
+public:
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle);
+    // Throws std::runtime_error for a zero divisor, like MathUtils::divide
+    double await_resume() const;
+
+private:
+    friend class ChainScheduler;
+    ChainStep(ChainScheduler& s, Operation op, double l, double r)
+        : scheduler(&s), operation(op), lhs(l), rhs(r), result(0.0), waiter() {}
+
+    ChainScheduler* scheduler;
+    Operation operation;
+    double lhs;
+    double rhs; // the exponent for Power
+    double result;
+    std::coroutine_handle<> waiter;
+};
+
+// A value that chains wait on until someone provides it with set(), e.g. the
+// next line of input for one session. Only one chain may await it at a time;
+// once set, awaiting it returns immediately.
+class ChainInput {
+public:
+    explicit ChainInput(ChainScheduler& s) : scheduler(&s), value(0.0), ready(false), waiter() {}
+    ChainInput(const ChainInput&) = delete;
+    ChainInput& operator=(const ChainInput&) = delete;
+
+    // Stores the value and makes the waiting chain, if any, runnable
+    void set(double v);
+    // Clears the value so the input can be awaited again
+    void reset() noexcept { ready = false; }
+    bool isSet() const noexcept { return ready; }
+
+    bool await_ready() const noexcept { return ready; }
+    void await_suspend(std::coroutine_handle<> handle) noexcept { waiter = handle; }
+    double await_resume() const noexcept { return value; }
+
+private:
+    ChainScheduler* scheduler;
+    double value;
+    bool ready;
+    std::coroutine_handle<> waiter;
+};
+
+// Interleaves many chains on one thread. run() resumes every runnable chain
+// until it suspends on a step or an input, then executes the suspended steps
+// together, one MathUtils batch kernel call per operation, and repeats. A
+// chain waiting on a ChainInput holds up no one; it is resumed in a later
+// run() once its input is set. Step results are bit-for-bit the scalar
+// MathUtils results.
+class ChainScheduler {
+public:
+    ChainScheduler() = default;
+    ChainScheduler(const ChainScheduler&) = delete;
+    ChainScheduler& operator=(const ChainScheduler&) = delete;
+    // Destroys chains that have not finished
+    ~ChainScheduler();
+
+    // Steps for chains to co_await
+    ChainStep add(double lhs, double rhs) { return ChainStep(*this, Operation::Add, lhs, rhs); }
+    ChainStep subtract(double lhs, double rhs) { return ChainStep(*this, Operation::Subtract, lhs, rhs); }
+    ChainStep multiply(double lhs, double rhs) { return ChainStep(*this, Operation::Multiply, lhs, rhs); }
+    ChainStep divide(double lhs, double rhs) { return ChainStep(*this, Operation::Divide, lhs, rhs); }
+    ChainStep powerOf(double base, int exponent) { return ChainStep(*this, Operation::Power, base, exponent); }
+
+    // Takes ownership of a chain and makes it runnable
+    void spawn(Chain chain);
+
+    // Runs until every chain has finished or is waiting on an unset input.
+    // An exception escaping a chain ends that chain and is rethrown here once
+    // the others have reached the same point; call run() again to continue.
+    // Returns the number of unfinished chains.
+    std::size_t run();
+
+    std::size_t size() const { return chains.size(); }
+    // Batch kernel calls made so far
+    std::size_t getBatchCount() const { return batches; }
+
+private:
+    friend class ChainStep;
+    friend class ChainInput;
+
+    void executeSteps();
+    std::exception_ptr collectFinished();
+
+    std::vector<std::coroutine_handle<Chain::promise_type> > chains;
+    std::deque<std::coroutine_handle<> > runnable;
+    std::vector<ChainStep*> steps;
+    // Scratch for the batch kernels
+    std::vector<ChainStep*> grouped;
+    std::vector<double> lhs;
+    std::vector<double> rhs;
+    std::vector<double> out;
+    std::size_t batches = 0;
+};
+
+#endif // CHAINSCHEDULER_H
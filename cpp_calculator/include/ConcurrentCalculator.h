@@ -0,0 +1,41 @@
+#ifndef CONCURRENTCALCULATOR_H
+#define CONCURRENTCALCULATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Accumulator shared by many threads. Each thread adds into its own
+// cache-line-sized shard with a lock-free compare-and-swap, and getValue()
+// combines the shards, so ingestion scales across cores without a mutex.
+class ConcurrentCalculator {
+private:
+    // Aligned to a cache line so that neighbouring shards never share one;
+    // C++17 aligned new makes the vector honour it
+    struct alignas(64) Shard {
+        std::atomic<double> value;
+    };
+
+    std::vector<Shard> shards;
+
+    Shard& localShard();
+
+public:
+    // Constructor; shardCount 0 uses one shard per hardware thread
+    explicit ConcurrentCalculator(std::size_t shardCount = 0);
+
+    // Operations safe to call from any number of threads
+    void add(double value);
+    void subtract(double value);
+
+    // Sum of all shards. While other threads are still writing this is not an
+    // atomic snapshot, and since rounding depends on which values landed in
+    // which shard it may differ in the last bits from a serial sum.
+    double getValue() const;
+    // Not atomic with respect to concurrent add/subtract calls
+    void reset();
+
+    std::size_t getShardCount() const;
+};
+
+#endif // CONCURRENTCALCULATOR_H
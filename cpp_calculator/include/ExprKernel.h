@@ -0,0 +1,296 @@
+#ifndef EXPRKERNEL_H
+#define EXPRKERNEL_H
+
+#include "MathUtils.h"
+#include <cstddef>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+
+// Expression templates for formulas known at compile time. A formula such as
+//     using namespace Expr::Kernel;
+//     auto f = (var<0> + 1.0) * var<1> - pow(var<0>, 3);
+// is a tree of empty or tiny node types; evaluating it over arrays produces a
+// single fused loop of MathUtils operations with no interpretive dispatch.
+namespace Expr {
+    namespace Kernel {
+        // Variable bindings for a single evaluation (values[i] is variable i)
+        struct ScalarBindings {
+            const double* values;
+
+            template <std::size_t I>
+            double get() const {
+                return values[I];
+            }
+        };
+
+        // Variable bindings for one row of a column-wise batch. The column pointers
+        // are held by value so the compiler can keep them in registers.
+        template <typename... Columns>
+        struct ColumnBindings {
+            std::tuple<const Columns*...> columns;
+            std::size_t row;
+
+            template <std::size_t I>
+            double get() const {
+                return std::get<I>(columns)[row];
+            }
+        };
+
+        // Leaf: the I-th variable
+        template <std::size_t I>
+        struct Var {
+            static constexpr std::size_t arity = I + 1;
+
+            template <typename Bindings>
+            double eval(const Bindings& bindings, unsigned&) const {
+                return bindings.template get<I>();
+            }
+        };
+
+        // Leaf: a literal value
+        struct Constant {
+            static constexpr std::size_t arity = 0;
+            double value;
+
+            template <typename Bindings>
+            double eval(const Bindings&, unsigned&) const {
+                return value;
+            }
+        };
+
+        // Element-wise operations, all forwarding to the inline MathUtils ops
+        struct AddOp {
+            static double apply(double a, double b, unsigned&) {
+                return Utils::MathUtils::add(a, b);
+            }
+        };
+
+        struct SubtractOp {
+            static double apply(double a, double b, unsigned&) {
+                return Utils::MathUtils::subtract(a, b);
+            }
+        };
+
+        struct MultiplyOp {
+            static double apply(double a, double b, unsigned&) {
+                return Utils::MathUtils::multiply(a, b);
+            }
+        };
+
+        // Zero divisors are counted rather than thrown so the loop stays branch-free;
+        // the evaluate functions turn a non-zero count into the usual error.
+        struct DivideOp {
+            static double apply(double a, double b, unsigned& failures) {
+                failures |= static_cast<unsigned>(b == 0);
+                return a / b;
+            }
+        };
+
+        template <typename Op, typename L, typename R>
+        struct Binary {
+            static constexpr std::size_t arity = L::arity > R::arity ? L::arity : R::arity;
+            L left;
+            R right;
+
+            template <typename Bindings>
+            double eval(const Bindings& bindings, unsigned& failures) const {
+                return Op::apply(left.eval(bindings, failures), right.eval(bindings, failures), failures);
+            }
+        };
+
+        template <typename E>
+        struct Negate {
+            static constexpr std::size_t arity = E::arity;
+            E operand;
+
+            template <typename Bindings>
+            double eval(const Bindings& bindings, unsigned& failures) const {
+                return -operand.eval(bindings, failures);
+            }
+        };
+
+        // Integer power with an exponent chosen at runtime
+        template <typename E>
+        struct Power {
+            static constexpr std::size_t arity = E::arity;
+            E base;
+            int exponent;
+
+            template <typename Bindings>
+            double eval(const Bindings& bindings, unsigned& failures) const {
+                return Utils::MathUtils::power(base.eval(bindings, failures), exponent);
+            }
+        };
+
+        // Integer power with an exponent fixed at compile time
+        template <int N, typename E>
+        struct FixedPower {
+            static constexpr std::size_t arity = E::arity;
+            E base;
+
+            template <typename Bindings>
+            double eval(const Bindings& bindings, unsigned& failures) const {
+                return Utils::MathUtils::power<N>(base.eval(bindings, failures));
+            }
+        };
+
+        // Trait identifying expression nodes, used to constrain the operators below
+        template <typename T>
+        struct IsNode : std::false_type {};
+        template <std::size_t I>
+        struct IsNode<Var<I> > : std::true_type {};
+        template <>
+        struct IsNode<Constant> : std::true_type {};
+        template <typename Op, typename L, typename R>
+        struct IsNode<Binary<Op, L, R> > : std::true_type {};
+        template <typename E>
+        struct IsNode<Negate<E> > : std::true_type {};
+        template <typename E>
+        struct IsNode<Power<E> > : std::true_type {};
+        template <int N, typename E>
+        struct IsNode<FixedPower<N, E> > : std::true_type {};
+
+        // Plain numbers taking part in an expression become Constant leaves
+        template <typename T>
+        struct AsNode {
+            typedef typename std::conditional<IsNode<T>::value, T, Constant>::type type;
+        };
+
+        template <typename T>
+        typename std::enable_if<IsNode<T>::value, T>::type toNode(const T& node) {
+            return node;
+        }
+
+        inline Constant toNode(double value) {
+            Constant constant = {value};
+            return constant;
+        }
+
+        template <typename L, typename R>
+        struct EnableBinary
+            : std::enable_if<(IsNode<L>::value || IsNode<R>::value) &&
+                             (IsNode<L>::value || std::is_arithmetic<L>::value) &&
+                             (IsNode<R>::value || std::is_arithmetic<R>::value)> {};
+
+        template <typename Op, typename L, typename R>
+        Binary<Op, typename AsNode<L>::type, typename AsNode<R>::type> makeBinary(const L& l, const R& r) {
+            Binary<Op, typename AsNode<L>::type, typename AsNode<R>::type> node = {
+                toNode(static_cast<typename std::conditional<IsNode<L>::value, L, double>::type>(l)),
+                toNode(static_cast<typename std::conditional<IsNode<R>::value, R, double>::type>(r))};
+            return node;
+        }
+
+        template <typename L, typename R, typename = typename EnableBinary<L, R>::type>
+        Binary<AddOp, typename AsNode<L>::type, typename AsNode<R>::type> operator+(const L& l, const R& r) {
+            return makeBinary<AddOp>(l, r);
+        }
+
+        template <typename L, typename R, typename = typename EnableBinary<L, R>::type>
+        Binary<SubtractOp, typename AsNode<L>::type, typename AsNode<R>::type> operator-(const L& l, const R& r) {
+            return makeBinary<SubtractOp>(l, r);
+        }
+
+        template <typename L, typename R, typename = typename EnableBinary<L, R>::type>
+        Binary<MultiplyOp, typename AsNode<L>::type, typename AsNode<R>::type> operator*(const L& l, const R& r) {
+            return makeBinary<MultiplyOp>(l, r);
+        }
+
+        template <typename L, typename R, typename = typename EnableBinary<L, R>::type>
+        Binary<DivideOp, typename AsNode<L>::type, typename AsNode<R>::type> operator/(const L& l, const R& r) {
+            return makeBinary<DivideOp>(l, r);
+        }
+
+        template <typename E, typename = typename std::enable_if<IsNode<E>::value>::type>
+        Negate<E> operator-(const E& operand) {
+            Negate<E> node = {operand};
+            return node;
+        }
+
+        // operator^ would bind looser than + and -, so powers are spelled pow(e, n)
+        template <typename E, typename = typename std::enable_if<IsNode<E>::value>::type>
+        Power<E> pow(const E& base, int exponent) {
+            Power<E> node = {base, exponent};
+            return node;
+        }
+
+        // pow<N>(e) for an exponent known at compile time
+        template <int N, typename E, typename = typename std::enable_if<IsNode<E>::value>::type>
+        FixedPower<N, E> pow(const E& base) {
+            FixedPower<N, E> node = {base};
+            return node;
+        }
+
+        // True when every type in the pack is arithmetic; keeps the scalar
+        // evaluate() from competing with the batch overload
+        template <typename... Ts>
+        struct AllArithmetic : std::true_type {};
+        template <typename T, typename... Ts>
+        struct AllArithmetic<T, Ts...>
+            : std::integral_constant<bool, std::is_arithmetic<T>::value && AllArithmetic<Ts...>::value> {};
+
+        // Ready-made variables: var<0>, var<1>, ...
+        template <std::size_t I>
+        constexpr Var<I> var{};
+
+        /**
+         * @brief Evaluates a formula for one set of variable values without throwing
+         * @param expression The formula
+         * @param values values[i] is variable i (at least E::arity entries)
+         * @return The value, or a DivisionByZero status
+         */
+        template <typename E>
+        Utils::MathResult tryEvaluate(const E& expression, const double* values) noexcept {
+            unsigned failures = 0;
+            const ScalarBindings bindings = {values};
+            const double value = expression.eval(bindings, failures);
+            if (failures != 0) {
+                return Utils::MathResult{0.0, Utils::MathStatus::DivisionByZero};
+            }
+            return Utils::MathResult{value, Utils::MathStatus::Ok};
+        }
+
+        /**
+         * @brief Evaluates a formula for one set of variable values
+         * @param expression The formula
+         * @param values The variable values in index order
+         * @return The value; throws std::runtime_error on a zero divisor
+         */
+        template <typename E, typename... Values,
+                  typename = typename std::enable_if<AllArithmetic<Values...>::value>::type>
+        double evaluate(const E& expression, Values... values) {
+            static_assert(sizeof...(Values) >= E::arity, "Not enough variable values for expression");
+            const double bound[sizeof...(Values) + 1] = {static_cast<double>(values)...};
+            const Utils::MathResult result = tryEvaluate(expression, bound);
+            if (!result.ok()) {
+                throw std::runtime_error("Division by zero error");
+            }
+            return result.value;
+        }
+
+        /**
+         * @brief Evaluates a formula over n rows in one fused loop
+         * @param expression The formula
+         * @param out Receives n results
+         * @param n Number of rows
+         * @param columns One array of n values per variable, in index order
+         * Throws std::runtime_error after the loop if any row divided by zero;
+         * the contents of out are then unspecified.
+         */
+        template <typename E, typename... Columns>
+        void evaluate(const E& expression, double* out, std::size_t n, const Columns*... columns) {
+            static_assert(sizeof...(Columns) >= E::arity, "Not enough input columns for expression");
+            const std::tuple<const Columns*...> inputs(columns...);
+            unsigned failures = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                const ColumnBindings<Columns...> bindings = {inputs, i};
+                out[i] = expression.eval(bindings, failures);
+            }
+            if (failures != 0) {
+                throw std::runtime_error("Division by zero error");
+            }
+        }
+    }
+}
+
+#endif // EXPRKERNEL_H
@@ -0,0 +1,108 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include "MathUtils.h"
+#include "MemoCache.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Expr {
+    // Instructions of the stack machine a formula is compiled into
+    enum class OpCode : std::uint8_t {
+        PushConstant,
+        PushVariable,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Power,
+        Negate
+    };
+
+    // One bytecode instruction; operand indexes the constant pool or the variables
+    struct Instruction {
+        OpCode op;
+        std::uint32_t operand;
+    };
+
+    // An infix formula over +, -, *, / and ^ compiled once into flat bytecode
+    // and evaluated many times with different variable bindings.
+    class CompiledExpression {
+    public:
+        // Deepest evaluation stack a compiled expression may need
+        static const std::size_t maxStackDepth = 64;
+
+        // Compile a formula; variables are numbered in order of first appearance.
+        // Throws std::runtime_error describing the position of a syntax error.
+        static CompiledExpression compile(const std::string& source);
+        // Compile a formula whose variables are exactly the given names, in that order
+        static CompiledExpression compile(const std::string& source,
+                                          const std::vector<std::string>& variables);
+
+        // Evaluate with variables[i] bound to variable i. Like MathUtils::divide,
+        // throws std::runtime_error on a zero divisor or a non-integer exponent.
+        double evaluate(const double* variables) const;
+        double evaluate(const std::vector<double>& variables) const;
+        // Non-throwing evaluation reporting errors through the status
+        Utils::MathResult tryEvaluate(const double* variables) const noexcept;
+
+        // Evaluate n bindings at once: columns[i][row] is variable i for that row.
+        // Runs the bytecode over blocks of rows using the MathUtils batch kernels.
+        void evaluate(const double* const* columns, double* out, std::size_t n) const;
+
+        // Introspection
+        const std::vector<std::string>& variables() const;
+        // Index of a variable, or -1 if the expression does not use it
+        int variableIndex(const std::string& name) const;
+        const std::vector<Instruction>& instructions() const;
+        const std::vector<double>& constants() const;
+        std::size_t stackDepth() const;
+
+    private:
+        class Compiler;
+
+        CompiledExpression();
+
+        std::vector<Instruction> code;
+        std::vector<double> constantPool;
+        std::vector<std::string> variableNames;
+        std::size_t depth;
+    };
+
+    // A compiled expression in front of a memo cache of its results, keyed by
+    // the bits of the variable values, for workloads that evaluate the same
+    // bindings over and over. Errors are cached too. Safe to evaluate from
+    // many threads at once. Expressions with more than maxCachedVariables
+    // variables are evaluated without the cache.
+    class CachedExpression {
+    public:
+        static const std::size_t maxCachedVariables = 4;
+
+        explicit CachedExpression(CompiledExpression expression, std::size_t capacity = 4096,
+                                  std::size_t shards = 16);
+
+        // Same results and errors as the CompiledExpression methods
+        double evaluate(const double* variables) const;
+        double evaluate(const std::vector<double>& variables) const;
+        Utils::MathResult tryEvaluate(const double* variables) const;
+
+        const CompiledExpression& expression() const;
+        Utils::CacheStats getStats() const;
+        void clearCache();
+
+    private:
+        struct Key {
+            std::uint64_t bits[maxCachedVariables];
+
+            bool operator==(const Key& other) const;
+            std::uint64_t hash() const;
+        };
+
+        CompiledExpression compiled;
+        mutable Utils::MemoCache<Key, Utils::MathResult> cache;
+    };
+}
+
+#endif // EXPRESSION_H
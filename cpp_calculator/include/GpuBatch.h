@@ -0,0 +1,59 @@
+#ifndef GPUBATCH_H
+#define GPUBATCH_H
+
+#include "MathUtils.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace Utils {
+    // Controls when GpuBatch uses the device and how it streams to it
+    struct GpuOptions {
+        // Batches smaller than this run on the CPU kernels, since copying them
+        // over PCIe costs more than computing them in place
+        std::size_t minimumElements = std::size_t(1) << 22;
+        // Elements per transfer chunk, rounded up to a multiple of 64 so that
+        // mask words never straddle chunks. Each of the two streams owns pinned
+        // staging buffers and device buffers of this size.
+        std::size_t chunkElements = std::size_t(1) << 20;
+    };
+
+    // The MathUtils batch operations offloaded to a GPU, for batches far
+    // beyond what the CPU kernels get through at memory bandwidth. Operands
+    // are ordinary host arrays: each chunk is staged into pinned memory and
+    // runs on one of two CUDA streams, so the copy-in, kernel and copy-out of
+    // consecutive chunks overlap.
+    //
+    // Built with -DCALCULATOR_ENABLE_CUDA=ON. Without a CUDA build, without a
+    // usable device, or below minimumElements every call runs on the CPU
+    // through MathUtils instead. Either way the results are bit-for-bit the
+    // MathUtils ones, since both sides perform the same correctly rounded
+    // IEEE-754 operations in the same order.
+    class GpuBatch {
+    public:
+        // True when a CUDA device was found and initialized
+        static bool isAvailable();
+        // The device's name, or "cpu" when calls fall back to MathUtils
+        static const char* deviceName();
+
+        static void add(const double* a, const double* b, double* out, std::size_t n,
+                        const GpuOptions& options = GpuOptions());
+        static void subtract(const double* a, const double* b, double* out, std::size_t n,
+                             const GpuOptions& options = GpuOptions());
+        static void multiply(const double* a, const double* b, double* out, std::size_t n,
+                             const GpuOptions& options = GpuOptions());
+        // Throws std::runtime_error for a zero divisor anywhere in b. The device
+        // finds it while streaming, so out is unspecified after the throw.
+        static void divide(const double* a, const double* b, double* out, std::size_t n,
+                           const GpuOptions& options = GpuOptions());
+        static void power(const double* base, int exponent, double* out, std::size_t n,
+                          const GpuOptions& options = GpuOptions());
+
+        // The predicates of MathUtils::parityMasks/signMasks, (n + 63) / 64 words each
+        static void parityMasks(const double* values, std::size_t n, std::uint64_t* even, std::uint64_t* odd,
+                                const GpuOptions& options = GpuOptions());
+        static void signMasks(const double* values, std::size_t n, std::uint64_t* positive, std::uint64_t* zero,
+                              std::uint64_t* negative, const GpuOptions& options = GpuOptions());
+    };
+}
+
+#endif // GPUBATCH_H
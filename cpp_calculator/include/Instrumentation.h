@@ -0,0 +1,136 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include "Operation.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Opt-in counters and sampled latency histograms for Calculator operations.
+// Configure with -DCALCULATOR_ENABLE_INSTRUMENTATION=ON to define
+// CALCULATOR_INSTRUMENTATION; without it the CALCULATOR_INSTRUMENT macros
+// expand to nothing and snapshot() reports zeros. Each thread updates its own
+// counters without synchronization; snapshot() adds them up on demand.
+namespace Instrumentation {
+    // One slot per Operation enumerator
+    const std::size_t operationCount = static_cast<std::size_t>(Operation::DivisionError) + 1;
+    // Latency bucket b counts samples in [2^b, 2^(b+1)) ns; the last is open-ended
+    const std::size_t latencyBuckets = 32;
+
+    // Aggregated view of every thread's counters
+    struct Snapshot {
+        std::uint64_t calls[operationCount];
+        std::uint64_t samples[operationCount];
+        std::uint64_t sampledNanoseconds[operationCount];
+        std::uint64_t latency[operationCount][latencyBuckets];
+
+        std::uint64_t count(Operation operation) const {
+            return calls[static_cast<std::size_t>(operation)];
+        }
+    };
+
+    // Whether this build records anything
+    constexpr bool enabled() {
+#if defined(CALCULATOR_INSTRUMENTATION)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Time one call in every interval per thread on average (default 64; 1 times
+    // every call). Gaps between samples are randomized so that a repeating
+    // pattern of operations cannot line up with the sampling.
+    void setSampleInterval(std::uint32_t interval);
+    std::uint32_t getSampleInterval();
+
+    // Sums the counters of all live threads and of threads that have exited
+    Snapshot snapshot();
+    // Writes a snapshot in the Prometheus text exposition format
+    void writePrometheus(std::ostream& out, const Snapshot& snapshot);
+    std::string toPrometheus(const Snapshot& snapshot);
+
+    namespace detail {
+        // Counters owned by one thread. Only the owner writes them, with relaxed
+        // load/store pairs rather than read-modify-write, so updates cost about
+        // as much as plain increments while snapshot() can still read them safely.
+        struct ThreadStats {
+            std::atomic<std::uint64_t> calls[operationCount];
+            std::atomic<std::uint64_t> samples[operationCount];
+            std::atomic<std::uint64_t> sampledNanoseconds[operationCount];
+            std::atomic<std::uint64_t> latency[operationCount][latencyBuckets];
+            std::uint32_t untilSample;
+            std::uint32_t jitter; // xorshift state varying the gap between samples
+        };
+
+        // Creates and registers the calling thread's counters; they are folded
+        // into the totals of exited threads when the thread ends
+        ThreadStats* registerThread();
+
+        // The calling thread's counters
+        inline ThreadStats& localStats() {
+            thread_local ThreadStats* const stats = registerThread();
+            return *stats;
+        }
+        // Restarts the calling thread's sampling countdown
+        void rearm(ThreadStats& stats);
+        void recordLatency(ThreadStats& stats, std::size_t slot, std::uint64_t nanoseconds);
+
+        inline void bump(std::atomic<std::uint64_t>& counter, std::uint64_t amount = 1) {
+            counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+    }
+
+    // Counts an operation without timing it
+    inline void count(Operation operation) {
+        detail::bump(detail::localStats().calls[static_cast<std::size_t>(operation)]);
+    }
+
+    // Counts an operation on construction and, for sampled calls, records how
+    // long the enclosing scope took on destruction
+    class ScopedTimer {
+    private:
+        detail::ThreadStats& stats;
+        std::size_t slot;
+        bool sampled;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        explicit ScopedTimer(Operation operation)
+            : stats(detail::localStats()), slot(static_cast<std::size_t>(operation)), sampled(false) {
+            detail::bump(stats.calls[slot]);
+            if (--stats.untilSample == 0) {
+                detail::rearm(stats);
+                sampled = true;
+                start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~ScopedTimer() {
+            if (sampled) {
+                const auto elapsed = std::chrono::steady_clock::now() - start;
+                detail::recordLatency(stats, slot, static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            }
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+    };
+}
+
+#if defined(CALCULATOR_INSTRUMENTATION)
+// Counts and (sampled) times the rest of the enclosing scope as one operation
+#define CALCULATOR_INSTRUMENT(operation) \
+    const ::Instrumentation::ScopedTimer calculatorInstrumentTimer_(operation)
+// Counts an event without timing it
+#define CALCULATOR_INSTRUMENT_COUNT(operation) ::Instrumentation::count(operation)
+#else
+#define CALCULATOR_INSTRUMENT(operation) ((void)0)
+#define CALCULATOR_INSTRUMENT_COUNT(operation) ((void)0)
+#endif
+
+#endif // INSTRUMENTATION_H
@@ -0,0 +1,281 @@
+#ifndef MEMOCACHE_H
+#define MEMOCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+namespace Utils {
+    // Counters of a memo cache, summed over its shards
+    struct CacheStats {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t evictions;
+        std::size_t size;     // entries currently held
+        std::size_t capacity; // most entries the cache holds
+
+        double hitRate() const {
+            return hits + misses != 0 ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0;
+        }
+    };
+
+    // Bits of a double, so that cache keys tell -0.0 from 0.0 and match NaN payloads
+    inline std::uint64_t doubleBits(double value) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    // Finalizer of splitmix64; spreads key bits over the whole hash
+    inline std::uint64_t mixHash(std::uint64_t h) {
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebull;
+        return h ^ (h >> 31);
+    }
+
+    // Bounded, thread-safe memo cache. Keys go to one of a power-of-two number
+    // of shards, each behind its own mutex, by the top bits of their hash. A
+    // shard is an open-addressing table probed linearly over a window of
+    // probeWindow slots (a couple of cache lines); entries are never removed
+    // individually, so an empty slot ends a probe. When the window is full,
+    // CLOCK picks the victim: a hit sets a slot's reference bit, and the sweep
+    // evicts the first slot whose bit is clear, clearing bits as it passes.
+    //
+    // Key must be trivially copyable and provide operator== and
+    // std::uint64_t hash() const; Value must be copyable and default-constructible.
+    template <typename Key, typename Value>
+    class MemoCache {
+    public:
+        static const std::size_t probeWindow = 8;
+
+        // capacity is rounded up so that every shard holds a power of two of at
+        // least probeWindow slots; shards is rounded up to a power of two
+        explicit MemoCache(std::size_t capacity = 4096, std::size_t shards = 16);
+
+        MemoCache(const MemoCache&) = delete;
+        MemoCache& operator=(const MemoCache&) = delete;
+
+        // Copies the cached value for key into value; counts a hit or a miss
+        bool find(const Key& key, Value& value);
+        // Stores value for key, evicting an entry from the probe window if it is full
+        void insert(const Key& key, const Value& value);
+        // The cached value for key, or compute() stored and returned. compute runs
+        // outside the shard lock, so two threads missing on one key may both run it.
+        template <typename Compute>
+        Value getOrCompute(const Key& key, Compute compute);
+
+        CacheStats getStats() const;
+        // Drops every entry and zeroes the counters
+        void clear();
+
+    private:
+        struct Slot {
+            Key key;
+            Value value;
+            bool used;
+            bool referenced; // CLOCK bit, set on every hit
+        };
+
+        // Aligned so that two shards never share the cache line holding their locks
+        struct alignas(64) Shard {
+            mutable std::mutex mutex;
+            std::unique_ptr<Slot[]> slots;
+            std::size_t size = 0;
+            std::size_t hand = 0; // where the next CLOCK sweep starts in a window
+            std::uint64_t hits = 0;
+            std::uint64_t misses = 0;
+            std::uint64_t evictions = 0;
+        };
+
+        Shard& shardFor(std::uint64_t hash) {
+            return shards[shardShift < 64 ? hash >> shardShift : 0];
+        }
+
+        std::unique_ptr<Shard[]> shards;
+        std::size_t shardCount;
+        unsigned shardShift;   // 64 - log2(shardCount)
+        std::size_t slotMask;  // slots per shard - 1
+    };
+
+    /**
+     * @brief Constructor - Allocates empty shards
+     * @param capacity Total entries to hold, rounded up per shard
+     * @param shards Number of independently locked shards, rounded up to a power of two
+     */
+    template <typename Key, typename Value>
+    MemoCache<Key, Value>::MemoCache(std::size_t capacity, std::size_t shards) : shardCount(1), shardShift(64) {
+        while (shardCount < shards) {
+            shardCount <<= 1;
+            --shardShift;
+        }
+        std::size_t perShard = probeWindow;
+        while (perShard * shardCount < capacity) {
+            perShard <<= 1;
+        }
+        slotMask = perShard - 1;
+
+        this->shards.reset(new Shard[shardCount]);
+        for (std::size_t i = 0; i < shardCount; ++i) {
+            this->shards[i].slots.reset(new Slot[perShard]());
+        }
+    }
+
+    /**
+     * @brief Looks a key up
+     * @param key The key
+     * @param value Receives the cached value on a hit
+     * @return Whether the key was cached
+     */
+    template <typename Key, typename Value>
+    bool MemoCache<Key, Value>::find(const Key& key, Value& value) {
+        const std::uint64_t hash = key.hash();
+        Shard& shard = shardFor(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (std::size_t i = 0; i < probeWindow; ++i) {
+            Slot& slot = shard.slots[(hash + i) & slotMask];
+            if (!slot.used) {
+                break;
+            }
+            if (slot.key == key) {
+                slot.referenced = true;
+                value = slot.value;
+                ++shard.hits;
+                return true;
+            }
+        }
+        ++shard.misses;
+        return false;
+    }
+
+    /**
+     * @brief Caches a value, replacing the one already stored for the key
+     * @param key The key
+     * @param value The value to cache
+     */
+    template <typename Key, typename Value>
+    void MemoCache<Key, Value>::insert(const Key& key, const Value& value) {
+        const std::uint64_t hash = key.hash();
+        Shard& shard = shardFor(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (std::size_t i = 0; i < probeWindow; ++i) {
+            Slot& slot = shard.slots[(hash + i) & slotMask];
+            if (!slot.used) {
+                slot.key = key;
+                slot.value = value;
+                slot.used = true;
+                slot.referenced = false;
+                ++shard.size;
+                return;
+            }
+            if (slot.key == key) {
+                slot.value = value;
+                return;
+            }
+        }
+
+        // Window full: CLOCK sweep, which ends within two passes
+        for (;;) {
+            Slot& slot = shard.slots[(hash + shard.hand) & slotMask];
+            shard.hand = (shard.hand + 1) % probeWindow;
+            if (!slot.referenced) {
+                slot.key = key;
+                slot.value = value;
+                ++shard.evictions;
+                return;
+            }
+            slot.referenced = false;
+        }
+    }
+
+    /**
+     * @brief Returns the cached value, computing and caching it on a miss
+     * @param key The key
+     * @param compute Callable returning the Value for key
+     * @return The value for key
+     */
+    template <typename Key, typename Value>
+    template <typename Compute>
+    Value MemoCache<Key, Value>::getOrCompute(const Key& key, Compute compute) {
+        Value value;
+        if (find(key, value)) {
+            return value;
+        }
+        value = compute();
+        insert(key, value);
+        return value;
+    }
+
+    /**
+     * @brief Sums the counters of all shards
+     * @return Hits, misses, evictions, current size and capacity
+     */
+    template <typename Key, typename Value>
+    CacheStats MemoCache<Key, Value>::getStats() const {
+        CacheStats stats = {0, 0, 0, 0, shardCount * (slotMask + 1)};
+        for (std::size_t i = 0; i < shardCount; ++i) {
+            std::lock_guard<std::mutex> lock(shards[i].mutex);
+            stats.hits += shards[i].hits;
+            stats.misses += shards[i].misses;
+            stats.evictions += shards[i].evictions;
+            stats.size += shards[i].size;
+        }
+        return stats;
+    }
+
+    template <typename Key, typename Value>
+    void MemoCache<Key, Value>::clear() {
+        for (std::size_t i = 0; i < shardCount; ++i) {
+            Shard& shard = shards[i];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (std::size_t j = 0; j <= slotMask; ++j) {
+                shard.slots[j].used = false;
+                shard.slots[j].referenced = false;
+            }
+            shard.size = 0;
+            shard.hand = 0;
+            shard.hits = 0;
+            shard.misses = 0;
+            shard.evictions = 0;
+        }
+    }
+
+    // Key of a cached MathUtils::power call
+    struct PowerKey {
+        std::uint64_t base; // bits of the base
+        int exponent;
+
+        bool operator==(const PowerKey& other) const {
+            return base == other.base && exponent == other.exponent;
+        }
+
+        std::uint64_t hash() const {
+            return mixHash(base ^ (static_cast<std::uint64_t>(static_cast<unsigned int>(exponent)) * 0x9e3779b97f4a7c15ull));
+        }
+    };
+
+    // Memoized MathUtils::power, for workloads that repeat (base, exponent)
+    // pairs. A hit costs a hash and an uncontended shard lock, about as much as
+    // the 20 multiplications of an exponent near 1000, so exponents up to
+    // uncachedExponent in magnitude are computed directly and not counted.
+    class PowerCache {
+    public:
+        static const int uncachedExponent = 1024;
+
+        explicit PowerCache(std::size_t capacity = 4096, std::size_t shards = 16);
+
+        // Bit-for-bit MathUtils::power(base, exponent)
+        double power(double base, int exponent);
+
+        CacheStats getStats() const;
+        void clear();
+
+    private:
+        MemoCache<PowerKey, double> cache;
+    };
+}
+
+#endif // MEMOCACHE_H
@@ -0,0 +1,397 @@
+#ifndef NUMERIC_H
+#define NUMERIC_H
+
+#include "MathUtils.h"
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+
+namespace Utils {
+    // Result of a checked operation on any numeric type; value is the zero of
+    // the type unless status is Ok
+    template <typename T>
+    struct CheckedValue {
+        T value;
+        MathStatus status;
+
+        constexpr bool ok() const noexcept {
+            return status == MathStatus::Ok;
+        }
+    };
+
+    // The value of a checked result, or the exception for its status:
+    // std::overflow_error, std::domain_error for an invalid exponent, and the
+    // std::runtime_error MathUtils::divide throws for a zero divisor
+    template <typename T>
+    T valueOrThrow(CheckedValue<T>&& result) {
+        switch (result.status) {
+        case MathStatus::Ok:
+            return static_cast<T&&>(result.value);
+        case MathStatus::DivisionByZero:
+            throw std::runtime_error("Division by zero error");
+        case MathStatus::InvalidExponent:
+            throw std::domain_error("Exponent out of range for this numeric type");
+        default:
+            throw std::overflow_error("Arithmetic overflow");
+        }
+    }
+
+    // The same for an lvalue result, which is copied
+    template <typename T>
+    T valueOrThrow(const CheckedValue<T>& result) {
+        return valueOrThrow(CheckedValue<T>(result));
+    }
+
+    // Overflow-checked 64-bit integer primitives; they return true and leave
+    // out unspecified on overflow. Compiler builtins where available, so the
+    // check is the processor's overflow flag.
+    inline bool addOverflows(std::int64_t a, std::int64_t b, std::int64_t& out) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_add_overflow(a, b, &out);
+#else
+        if ((b > 0 && a > INT64_MAX - b) || (b < 0 && a < INT64_MIN - b)) {
+            return true;
+        }
+        out = a + b;
+        return false;
+#endif
+    }
+
+    inline bool subtractOverflows(std::int64_t a, std::int64_t b, std::int64_t& out) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_sub_overflow(a, b, &out);
+#else
+        if ((b < 0 && a > INT64_MAX + b) || (b > 0 && a < INT64_MIN + b)) {
+            return true;
+        }
+        out = a - b;
+        return false;
+#endif
+    }
+
+    inline bool multiplyOverflows(std::int64_t a, std::int64_t b, std::int64_t& out) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_mul_overflow(a, b, &out);
+#else
+        if (a > 0 ? (b > 0 ? a > INT64_MAX / b : b < INT64_MIN / a)
+                  : (b > 0 ? a < INT64_MIN / b : a != 0 && b < INT64_MAX / a)) {
+            return true;
+        }
+        out = a * b;
+        return false;
+#endif
+    }
+
+    constexpr std::int64_t powerOfTen(int exponent) {
+        return exponent == 0 ? 1 : 10 * powerOfTen(exponent - 1);
+    }
+
+    // Decimal fixed-point number: an int64 count of units of 10^-Decimals, so
+    // Fixed<2> holds integer cents exactly. Arithmetic on it goes through
+    // Arithmetic<Fixed<Decimals>>, which rounds products and quotients half
+    // away from zero and reports overflow.
+    template <int Decimals>
+    class Fixed {
+    public:
+        static_assert(Decimals >= 0 && Decimals <= 18, "Fixed supports 0 to 18 decimals");
+
+        static constexpr std::int64_t scale = powerOfTen(Decimals);
+
+        constexpr Fixed() : units(0) {}
+
+        static constexpr Fixed fromUnits(std::int64_t units) {
+            return Fixed(units);
+        }
+
+        // Throws std::overflow_error when value * 10^Decimals does not fit
+        static Fixed fromInteger(std::int64_t value) {
+            std::int64_t units;
+            if (multiplyOverflows(value, scale, units)) {
+                throw std::overflow_error("Value does not fit the fixed-point range");
+            }
+            return Fixed(units);
+        }
+
+        // Nearest representable value; throws std::overflow_error when value is
+        // out of range or NaN
+        static Fixed fromDouble(double value) {
+            const double scaled = value * static_cast<double>(scale);
+            if (!(scaled > -9223372036854775808.0 && scaled < 9223372036854775808.0)) {
+                throw std::overflow_error("Value does not fit the fixed-point range");
+            }
+            return Fixed(static_cast<std::int64_t>(std::round(scaled)));
+        }
+
+        constexpr std::int64_t getUnits() const {
+            return units;
+        }
+
+        double toDouble() const {
+            return static_cast<double>(units) / static_cast<double>(scale);
+        }
+
+        friend constexpr bool operator==(Fixed a, Fixed b) {
+            return a.units == b.units;
+        }
+
+        friend constexpr bool operator!=(Fixed a, Fixed b) {
+            return a.units != b.units;
+        }
+
+        friend constexpr bool operator<(Fixed a, Fixed b) {
+            return a.units < b.units;
+        }
+
+        // Prints every decimal, e.g. "-12.50" for Fixed<2>
+        friend std::ostream& operator<<(std::ostream& out, Fixed value) {
+            // Magnitude in unsigned arithmetic so that INT64_MIN prints correctly
+            const std::uint64_t magnitude = value.units < 0 ? 0u - static_cast<std::uint64_t>(value.units)
+                                                            : static_cast<std::uint64_t>(value.units);
+            const std::uint64_t whole = magnitude / static_cast<std::uint64_t>(scale);
+            std::uint64_t fraction = magnitude % static_cast<std::uint64_t>(scale);
+            if (value.units < 0) {
+                out << '-';
+            }
+            out << whole;
+            if (Decimals > 0) {
+                char digits[Decimals + 1];
+                for (int i = Decimals - 1; i >= 0; --i) {
+                    digits[i] = static_cast<char>('0' + fraction % 10);
+                    fraction /= 10;
+                }
+                digits[Decimals] = '\0';
+                out << '.' << digits;
+            }
+            return out;
+        }
+
+    private:
+        explicit constexpr Fixed(std::int64_t u) : units(u) {}
+
+        std::int64_t units;
+    };
+
+    // Arithmetic on a numeric type, with every operation checked. Calculator
+    // policies go through it, so one BasicCalculator works on double, int64
+    // and fixed-point values:
+    //   add/subtract/multiply/divide(a, b), power(base, int) -> CheckedValue<T>
+    //   parity(v), sign(v), toDouble(v)
+    template <typename T>
+    struct Arithmetic;
+
+    // The MathUtils operations; only division can fail
+    template <>
+    struct Arithmetic<double> {
+        static constexpr CheckedValue<double> add(double a, double b) {
+            return CheckedValue<double>{MathUtils::add(a, b), MathStatus::Ok};
+        }
+
+        static constexpr CheckedValue<double> subtract(double a, double b) {
+            return CheckedValue<double>{MathUtils::subtract(a, b), MathStatus::Ok};
+        }
+
+        static constexpr CheckedValue<double> multiply(double a, double b) {
+            return CheckedValue<double>{MathUtils::multiply(a, b), MathStatus::Ok};
+        }
+
+        static constexpr CheckedValue<double> divide(double a, double b) {
+            return b == 0 ? CheckedValue<double>{0.0, MathStatus::DivisionByZero}
+                          : CheckedValue<double>{a / b, MathStatus::Ok};
+        }
+
+        static constexpr CheckedValue<double> power(double base, int exponent) {
+            return CheckedValue<double>{MathUtils::power(base, exponent), MathStatus::Ok};
+        }
+
+        static Parity parity(double value) {
+            return MathUtils::parity(value);
+        }
+
+        static constexpr Sign sign(double value) {
+            return MathUtils::sign(value);
+        }
+
+        static constexpr double toDouble(double value) {
+            return value;
+        }
+    };
+
+    // Exact 64-bit integer arithmetic. Division truncates toward zero; a
+    // negative exponent is InvalidExponent, since its result is not an integer
+    // for any base but 1 and -1.
+    template <>
+    struct Arithmetic<std::int64_t> {
+        static CheckedValue<std::int64_t> add(std::int64_t a, std::int64_t b) {
+            std::int64_t out;
+            return addOverflows(a, b, out) ? CheckedValue<std::int64_t>{0, MathStatus::Overflow}
+                                           : CheckedValue<std::int64_t>{out, MathStatus::Ok};
+        }
+
+        static CheckedValue<std::int64_t> subtract(std::int64_t a, std::int64_t b) {
+            std::int64_t out;
+            return subtractOverflows(a, b, out) ? CheckedValue<std::int64_t>{0, MathStatus::Overflow}
+                                                : CheckedValue<std::int64_t>{out, MathStatus::Ok};
+        }
+
+        static CheckedValue<std::int64_t> multiply(std::int64_t a, std::int64_t b) {
+            std::int64_t out;
+            return multiplyOverflows(a, b, out) ? CheckedValue<std::int64_t>{0, MathStatus::Overflow}
+                                                : CheckedValue<std::int64_t>{out, MathStatus::Ok};
+        }
+
+        static constexpr CheckedValue<std::int64_t> divide(std::int64_t a, std::int64_t b) {
+            return b == 0                  ? CheckedValue<std::int64_t>{0, MathStatus::DivisionByZero}
+                 : a == INT64_MIN && b == -1 ? CheckedValue<std::int64_t>{0, MathStatus::Overflow}
+                                             : CheckedValue<std::int64_t>{a / b, MathStatus::Ok};
+        }
+
+        // Exponentiation by squaring with every multiplication checked
+        static CheckedValue<std::int64_t> power(std::int64_t base, int exponent) {
+            if (exponent < 0) {
+                return CheckedValue<std::int64_t>{0, MathStatus::InvalidExponent};
+            }
+            std::int64_t result = 1;
+            std::int64_t square = base;
+            unsigned int remaining = static_cast<unsigned int>(exponent);
+            while (remaining != 0) {
+                if ((remaining & 1u) && multiplyOverflows(result, square, result)) {
+                    return CheckedValue<std::int64_t>{0, MathStatus::Overflow};
+                }
+                remaining >>= 1;
+                if (remaining != 0 && multiplyOverflows(square, square, square)) {
+                    return CheckedValue<std::int64_t>{0, MathStatus::Overflow};
+                }
+            }
+            return CheckedValue<std::int64_t>{result, MathStatus::Ok};
+        }
+
+        // The lowest bit, with no conversion or truncation
+        static constexpr Parity parity(std::int64_t value) {
+            return (value & 1) == 0 ? Parity::Even : Parity::Odd;
+        }
+
+        static constexpr Sign sign(std::int64_t value) {
+            return value > 0 ? Sign::Positive : value < 0 ? Sign::Negative : Sign::Zero;
+        }
+
+        static double toDouble(std::int64_t value) {
+            return static_cast<double>(value);
+        }
+    };
+
+    // Fixed-point arithmetic on the unit counts. Sums are exact; products and
+    // quotients are rounded half away from zero to the nearest unit. With
+    // 128-bit integer support the only intermediate that can overflow is the
+    // final result; otherwise a product of unit counts must itself fit in int64.
+    template <int Decimals>
+    struct Arithmetic<Fixed<Decimals> > {
+        typedef Fixed<Decimals> Number;
+        typedef CheckedValue<Number> Result;
+
+        static Result add(Number a, Number b) {
+            std::int64_t out;
+            return addOverflows(a.getUnits(), b.getUnits(), out) ? Result{Number(), MathStatus::Overflow}
+                                                                 : Result{Number::fromUnits(out), MathStatus::Ok};
+        }
+
+        static Result subtract(Number a, Number b) {
+            std::int64_t out;
+            return subtractOverflows(a.getUnits(), b.getUnits(), out)
+                       ? Result{Number(), MathStatus::Overflow}
+                       : Result{Number::fromUnits(out), MathStatus::Ok};
+        }
+
+        static Result multiply(Number a, Number b) {
+            return scaledQuotient(a.getUnits(), b.getUnits(), Number::scale);
+        }
+
+        static Result divide(Number a, Number b) {
+            if (b.getUnits() == 0) {
+                return Result{Number(), MathStatus::DivisionByZero};
+            }
+            return scaledQuotient(a.getUnits(), Number::scale, b.getUnits());
+        }
+
+        // Exponentiation by squaring, rounding after every multiplication. A
+        // negative exponent is InvalidExponent: the reciprocal of the rounded
+        // positive power loses most of its digits (0.15^-2 would give 50.00).
+        static Result power(Number base, int exponent) {
+            if (exponent < 0) {
+                return Result{Number(), MathStatus::InvalidExponent};
+            }
+            unsigned int remaining = static_cast<unsigned int>(exponent);
+            Result result = {Number::fromInteger(1), MathStatus::Ok};
+            Result square = {base, MathStatus::Ok};
+            while (remaining != 0) {
+                if (remaining & 1u) {
+                    result = multiply(result.value, square.value);
+                    if (!result.ok()) {
+                        return result;
+                    }
+                }
+                remaining >>= 1;
+                if (remaining != 0) {
+                    square = multiply(square.value, square.value);
+                    if (!square.ok()) {
+                        return square;
+                    }
+                }
+            }
+            return result;
+        }
+
+        // Parity of the integer part, computed on the unit count
+        static constexpr Parity parity(Number value) {
+            return ((value.getUnits() / Number::scale) & 1) == 0 ? Parity::Even : Parity::Odd;
+        }
+
+        static constexpr Sign sign(Number value) {
+            return value.getUnits() > 0 ? Sign::Positive : value.getUnits() < 0 ? Sign::Negative : Sign::Zero;
+        }
+
+        static double toDouble(Number value) {
+            return value.toDouble();
+        }
+
+    private:
+        // a * b / divisor rounded half away from zero; divisor is non-zero
+        static Result scaledQuotient(std::int64_t a, std::int64_t b, std::int64_t divisor) {
+#if defined(__SIZEOF_INT128__)
+            const __int128 product = static_cast<__int128>(a) * b;
+            __int128 quotient = product / divisor;
+            const __int128 remainder = product % divisor;
+            const __int128 twiceRemainder = remainder < 0 ? -2 * remainder : 2 * remainder;
+            const __int128 magnitude = divisor < 0 ? -static_cast<__int128>(divisor) : divisor;
+            if (twiceRemainder >= magnitude) {
+                quotient += (product < 0) == (divisor < 0) ? 1 : -1;
+            }
+            if (quotient > INT64_MAX || quotient < INT64_MIN) {
+                return Result{Number(), MathStatus::Overflow};
+            }
+            return Result{Number::fromUnits(static_cast<std::int64_t>(quotient)), MathStatus::Ok};
+#else
+            std::int64_t product;
+            if (multiplyOverflows(a, b, product)) {
+                return Result{Number(), MathStatus::Overflow};
+            }
+            if (product == INT64_MIN && divisor == -1) {
+                return Result{Number(), MathStatus::Overflow};
+            }
+            std::int64_t quotient = product / divisor;
+            const std::int64_t remainder = product % divisor;
+            // |remainder| < |divisor| <= 2^63, so compare halves to avoid overflow
+            const std::uint64_t magnitude = divisor < 0 ? 0u - static_cast<std::uint64_t>(divisor)
+                                                        : static_cast<std::uint64_t>(divisor);
+            const std::uint64_t rest = remainder < 0 ? 0u - static_cast<std::uint64_t>(remainder)
+                                                     : static_cast<std::uint64_t>(remainder);
+            if (rest >= magnitude - rest) {
+                quotient += (product < 0) == (divisor < 0) ? 1 : -1;
+            }
+            return Result{Number::fromUnits(quotient), MathStatus::Ok};
+#endif
+        }
+    };
+}
+
+#endif // NUMERIC_H
@@ -0,0 +1,18 @@
+#ifndef OPERATION_H
+#define OPERATION_H
+
+#include <cstdint>
+
+// Kind of operation last applied to a Calculator
+enum class Operation : std::uint8_t {
+    Initialized,
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Power,
+    Reset,
+    DivisionError
+};
+
+#endif // OPERATION_H
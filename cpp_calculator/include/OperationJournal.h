@@ -0,0 +1,123 @@
+#ifndef OPERATIONJOURNAL_H
+#define OPERATIONJOURNAL_H
+
+#include "Calculator.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <vector>
+
+// One journal record: the operation and the operand it was applied with
+struct JournalEntry {
+    double operand;
+    Operation operation;
+    std::uint8_t reserved[7];
+};
+
+static_assert(sizeof(JournalEntry) == 16, "JournalEntry must stay 16 bytes");
+
+// True if operand can be a Power record's exponent: a finite integer within
+// int range. Records read from files are checked with this before the
+// operand is converted to int.
+inline bool isValidExponent(double operand) {
+    return operand == std::trunc(operand) && operand >= std::numeric_limits<int>::min() &&
+           operand <= std::numeric_limits<int>::max();
+}
+
+// Compact binary log of calculator operations with undo/redo and replay.
+// Entries live in a fixed-capacity ring buffer allocated once up front, from
+// any std::pmr::memory_resource (e.g. a per-request arena). When
+// it is full, the oldest entry is folded into the base value the journal
+// replays from, so replaying always reproduces the live value exactly.
+// Replay follows PlainAccumulate semantics (a rejected division is a no-op).
+class OperationJournal {
+private:
+    std::pmr::vector<JournalEntry> entries;
+    std::size_t capacity;
+    std::size_t head;      // ring index of the oldest retained entry
+    std::size_t count;     // retained entries, including undone ones
+    std::size_t cursor;    // entries currently applied (count - cursor can be redone)
+    double baseValue;      // value before the oldest retained entry
+
+    const JournalEntry& at(std::size_t index) const;
+
+public:
+    // Constructor; capacity is the number of entries kept for undo, and the ring
+    // buffer is allocated from resource
+    explicit OperationJournal(std::size_t capacity = 4096, double initialValue = 0.0,
+                              std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Appends an operation; discards anything that could have been redone.
+    // Throws std::invalid_argument for a Power operand that is not a valid exponent.
+    void record(Operation operation, double operand);
+
+    // Undo/redo move through the recorded history; false when there is nothing to move to
+    bool undo();
+    bool redo();
+    bool canUndo() const;
+    bool canRedo() const;
+
+    // Value after replaying every applied entry from the base value
+    double value() const;
+    // Replays the applied entries onto a calculator, e.g. a freshly constructed one
+    template <typename TracePolicy, typename AccumulatePolicy>
+    void replayInto(BasicCalculator<TracePolicy, AccumulatePolicy>& calculator) const;
+
+    // Discards all entries and starts again from initialValue
+    void clear(double initialValue = 0.0);
+
+    // Getters
+    std::size_t size() const;
+    std::size_t getCapacity() const;
+    double getBaseValue() const;
+    // The index-th oldest applied entry
+    const JournalEntry& entry(std::size_t index) const;
+
+    // Tight replay loop over raw entries, without going through Calculator.
+    // Throws std::runtime_error for a Power entry whose operand fails
+    // isValidExponent, e.g. from a corrupt session file.
+    static double replay(double initialValue, const JournalEntry* entries, std::size_t n);
+};
+
+// Trace policy that keeps the usual last-operation record and also appends
+// every operation to an OperationJournal:
+//     OperationJournal journal;
+//     BasicCalculator<JournalTrace> calc{JournalTrace(journal)};
+class JournalTrace : public Trace {
+private:
+    OperationJournal* journal;
+
+public:
+    explicit JournalTrace(OperationJournal& target) : journal(&target) {}
+
+    void record(Operation operation, double operand) {
+        Trace::record(operation, operand);
+        journal->record(operation, operand);
+    }
+
+    void recordDivisionError(double divisor) {
+        Trace::recordDivisionError(divisor);
+        journal->record(Operation::DivisionError, divisor);
+    }
+};
+
+/**
+ * @brief Replays the journal onto a calculator
+ * @param calculator The calculator to set; its previous value is discarded
+ * The value is computed with replay() and installed with restore(), so the
+ * calculator reports the last applied entry as its last operation and a
+ * journaling calculator does not log the replay again
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void OperationJournal::replayInto(BasicCalculator<TracePolicy, AccumulatePolicy>& calculator) const {
+    if (cursor == 0) {
+        calculator.restore(baseValue);
+        return;
+    }
+    const JournalEntry& last = entry(cursor - 1);
+    calculator.restore(value(), last.operation, last.operand);
+}
+
+#endif // OPERATIONJOURNAL_H
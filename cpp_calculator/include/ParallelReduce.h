@@ -0,0 +1,32 @@
+#ifndef PARALLELREDUCE_H
+#define PARALLELREDUCE_H
+
+#include "MathUtils.h"
+#include <cstddef>
+
+namespace Utils {
+    // Controls how a parallel reduction splits and accumulates its input
+    struct ReduceOptions {
+        // Accumulation used within and across chunks
+        Summation summation = Summation::Naive;
+        // Worker threads including the caller; 0 uses one per hardware thread
+        unsigned threads = 0;
+        // Elements per chunk. Chunk boundaries depend only on this, never on the
+        // thread count, which is what makes results reproducible.
+        std::size_t chunkSize = std::size_t(1) << 16;
+    };
+
+    // Reductions over very large arrays spread across a persistent pool of
+    // threads, started on first use and shared by all calls.
+    // The input is cut into fixed-size chunks that threads claim dynamically;
+    // every chunk's partial result is stored by index and the partials are
+    // combined in chunk order, so the result is bit-for-bit the same for any
+    // thread count and any scheduling.
+    class ParallelReduce {
+    public:
+        static double sum(const double* values, std::size_t n, const ReduceOptions& options = ReduceOptions());
+        static double product(const double* values, std::size_t n, const ReduceOptions& options = ReduceOptions());
+    };
+}
+
+#endif // PARALLELREDUCE_H
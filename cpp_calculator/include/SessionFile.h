@@ -0,0 +1,167 @@
+#ifndef SESSIONFILE_H
+#define SESSIONFILE_H
+
+#include "Calculator.h"
+#include "MappedFile.h"
+#include "OperationJournal.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+// On-disk session format: a 32-byte SessionHeader followed by JournalEntry
+// records (16 bytes each) in the order they were performed. The record count
+// is implied by the file size, so appending never rewrites the header and a
+// record cut short by a crash is simply ignored. Files use the writer's byte
+// order, which the header records so that a mismatch is detected on open.
+struct SessionHeader {
+    char magic[4];             // "CALC"
+    std::uint16_t version;     // sessionFormatVersion
+    std::uint16_t recordSize;  // sizeof(JournalEntry)
+    std::uint32_t byteOrder;   // sessionByteOrderMark as written by the writer
+    std::uint32_t flags;       // reserved, 0
+    double initialValue;       // value before the first record
+    std::uint64_t reserved;
+};
+
+static_assert(sizeof(SessionHeader) == 32, "SessionHeader must stay 32 bytes");
+
+const std::uint16_t sessionFormatVersion = 1;
+const std::uint32_t sessionByteOrderMark = 0x01020304u;
+
+// Checks that a header describes a session this build can read; throws
+// std::runtime_error naming source and the first mismatch otherwise
+void validateSessionHeader(const SessionHeader& header, const std::string& source);
+
+// How SessionWriter treats an existing file
+enum class SessionOpen : std::uint8_t {
+    Create, // start a new session, replacing any existing file
+    Append  // continue an existing session (created if missing)
+};
+
+// Append-only writer that buffers records and writes them in large blocks
+class SessionWriter {
+private:
+    std::FILE* file;
+    std::unique_ptr<JournalEntry[]> buffer;
+    std::size_t bufferCapacity;
+    std::size_t buffered;
+    std::uint64_t flushed;
+
+public:
+    // Opens path for writing; throws std::runtime_error on I/O errors or, when
+    // appending, if the existing file is not a compatible session. initialValue
+    // is ignored when appending to an existing session.
+    explicit SessionWriter(const std::string& path, double initialValue = 0.0,
+                           SessionOpen mode = SessionOpen::Create, std::size_t bufferEntries = 4096);
+    // Flushes remaining records; errors at this point are lost, call flush() to see them
+    ~SessionWriter();
+
+    SessionWriter(const SessionWriter&) = delete;
+    SessionWriter& operator=(const SessionWriter&) = delete;
+
+    // Appends records
+    void record(Operation operation, double operand);
+    void append(const JournalEntry* entries, std::size_t n);
+    // Appends the applied entries of a journal, oldest first
+    void append(const OperationJournal& journal);
+
+    // Writes buffered records to the file; throws std::runtime_error on failure
+    void flush();
+
+    // Records in the session so far, including those still buffered
+    std::uint64_t size() const;
+};
+
+// Trace policy that keeps the usual last-operation record and also appends
+// every operation to a session file:
+//     SessionWriter writer("session.bin");
+//     BasicCalculator<SessionTrace> calc{SessionTrace(writer)};
+class SessionTrace : public Trace {
+private:
+    SessionWriter* writer;
+
+public:
+    explicit SessionTrace(SessionWriter& target) : writer(&target) {}
+
+    void record(Operation operation, double operand) {
+        Trace::record(operation, operand);
+        writer->record(operation, operand);
+    }
+
+    void recordDivisionError(double divisor) {
+        Trace::recordDivisionError(divisor);
+        writer->record(Operation::DivisionError, divisor);
+    }
+};
+
+// A session file mapped into memory. The records are used in place, with no
+// parsing or copying, and replay runs the same loop as OperationJournal.
+class MappedSession {
+private:
+    MappedFile file;
+    const SessionHeader* header;
+    const JournalEntry* records;
+    std::size_t count;
+
+public:
+    // Maps and validates a session file; throws std::runtime_error if it is not one
+    explicit MappedSession(const std::string& path);
+
+    double getInitialValue() const;
+    // The records, valid for the lifetime of this object
+    const JournalEntry* entries() const;
+    std::size_t size() const;
+    const JournalEntry& entry(std::size_t index) const;
+
+    // Value after replaying every record from the initial value
+    double replay() const;
+    // Replays the session onto a calculator, as OperationJournal::replayInto does
+    template <typename TracePolicy, typename AccumulatePolicy>
+    void replayInto(BasicCalculator<TracePolicy, AccumulatePolicy>& calculator) const;
+    // Replays only the records from index first onwards, continuing from the
+    // calculator's current value: the tail after a snapshot taken at first
+    template <typename TracePolicy, typename AccumulatePolicy>
+    void replayTailInto(BasicCalculator<TracePolicy, AccumulatePolicy>& calculator, std::uint64_t first) const;
+};
+
+/**
+ * @brief Replays the session onto a calculator
+ * @param calculator The calculator to set; its previous value is discarded
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void MappedSession::replayInto(BasicCalculator<TracePolicy, AccumulatePolicy>& calculator) const {
+    if (count == 0) {
+        calculator.restore(header->initialValue);
+        return;
+    }
+    const JournalEntry& last = records[count - 1];
+    calculator.restore(replay(), last.operation, last.operand);
+}
+
+/**
+ * @brief Replays the records written after a given point onto a calculator
+ * @param calculator Holds the state after the first records, e.g. restored
+ *                   from a snapshot; receives the state after all of them
+ * @param first Records already applied to the calculator
+ * Throws std::runtime_error if the session holds fewer than first records,
+ * which means the calculator's state did not come from this session
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void MappedSession::replayTailInto(BasicCalculator<TracePolicy, AccumulatePolicy>& calculator,
+                                   std::uint64_t first) const {
+    if (first > count) {
+        throw std::runtime_error("Session has fewer records than the state being replayed onto");
+    }
+    if (first == count) {
+        return;
+    }
+    const std::size_t start = static_cast<std::size_t>(first);
+    const JournalEntry& last = records[count - 1];
+    calculator.restore(OperationJournal::replay(calculator.getValue(), records + start, count - start),
+                       last.operation, last.operand);
+}
+
+#endif // SESSIONFILE_H
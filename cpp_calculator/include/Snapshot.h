@@ -0,0 +1,224 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "Calculator.h"
+#include "CalculatorBank.h"
+#include "MappedFile.h"
+#include "MathUtils.h"
+#include "SessionFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// On-disk snapshot format: a 64-byte SnapshotHeader followed by the state of
+// count calculators in CalculatorBank's structure-of-arrays layout: count
+// values, then count operands (both of the header's precision), then count
+// one-byte operation codes. MappedSnapshot uses the arrays in place, so
+// restoring a bank costs three copies and no parsing. Like session files,
+// snapshots use the writer's byte order.
+//
+// For warm startup, pair a snapshot with the session file the calculators
+// journal to. sequence records how many session records the saved state
+// already includes, so recovery replays only the records after it:
+//     MappedSnapshot snapshot("calc.snap");
+//     Calculator calc;
+//     snapshot.restoreInto(calc);
+//     MappedSession("calc.session").replayTailInto(calc, snapshot.getSequence());
+// To take the snapshot, flush the SessionWriter first and pass its size() as
+// sequence. Then the session on disk always covers the snapshot.
+struct SnapshotHeader {
+    char magic[4];                // "CSNP"
+    std::uint16_t version;        // snapshotFormatVersion
+    std::uint8_t precision;       // Utils::Precision of the values and operands
+    std::uint8_t reserved0;
+    std::uint32_t byteOrder;      // sessionByteOrderMark as written by the writer
+    std::uint32_t flags;          // reserved, 0
+    std::uint64_t count;          // calculators in the snapshot
+    std::uint64_t sequence;       // journal position of the state, e.g. SessionWriter::size()
+    std::uint64_t divisionErrors; // a bank's division error count; 0 for calculators
+    std::uint64_t reserved[3];
+};
+
+static_assert(sizeof(SnapshotHeader) == 64, "SnapshotHeader must stay 64 bytes");
+static_assert(sizeof(Operation) == 1, "Snapshots store one byte per operation code");
+
+const std::uint16_t snapshotFormatVersion = 1;
+
+// The Utils::Precision tag of the element types a snapshot can hold
+template <typename T>
+struct SnapshotPrecision;
+
+template <>
+struct SnapshotPrecision<double> {
+    static constexpr Utils::Precision value = Utils::Precision::Double;
+};
+
+template <>
+struct SnapshotPrecision<float> {
+    static constexpr Utils::Precision value = Utils::Precision::Float;
+};
+
+// Writes a snapshot of count calculators, taken from arrays in the layout of
+// CalculatorBank's getValues/getOperations/getOperands. The file is written
+// beside path, flushed to disk and renamed over it, so readers (and recovery
+// after a crash) see either the previous snapshot or the new one, never a
+// partial file. Throws std::runtime_error on I/O errors.
+void writeSnapshot(const std::string& path, std::size_t count, const double* values, const Operation* operations,
+                   const double* operands, std::uint64_t sequence = 0, std::uint64_t divisionErrors = 0);
+void writeSnapshot(const std::string& path, std::size_t count, const float* values, const Operation* operations,
+                   const float* operands, std::uint64_t sequence = 0, std::uint64_t divisionErrors = 0);
+
+// Writes a bank's calculators and division error count
+template <typename T>
+void writeSnapshot(const std::string& path, const BasicCalculatorBank<T>& bank, std::uint64_t sequence = 0);
+
+// Writes the value and last operation of count double calculators with a
+// recording trace policy (e.g. Calculator). Like journal replay, this leaves
+// out per-calculator division error counts and any compensation state.
+template <typename TracePolicy, typename AccumulatePolicy>
+void writeSnapshot(const std::string& path, const BasicCalculator<TracePolicy, AccumulatePolicy>* calculators,
+                   std::size_t count, std::uint64_t sequence = 0);
+
+// A snapshot file mapped into memory, checked against its header on open
+class MappedSnapshot {
+private:
+    MappedFile file;
+    const SnapshotHeader* header;
+    std::size_t count;
+
+    // Throws std::runtime_error unless the snapshot holds this precision
+    void requirePrecision(Utils::Precision precision) const;
+
+public:
+    // Maps and validates a snapshot; throws std::runtime_error if the file is
+    // not one, is truncated or corrupt (including unknown operation codes and
+    // Power exponents that are not integers in int range), or was written with
+    // another byte order
+    explicit MappedSnapshot(const std::string& path);
+
+    std::size_t size() const;
+    Utils::Precision getPrecision() const;
+    std::uint64_t getSequence() const;
+    std::uint64_t getDivisionErrorCount() const;
+
+    // The arrays, size() entries each, used in place and valid for the
+    // lifetime of this object. T must match getPrecision(); otherwise these
+    // throw std::runtime_error.
+    template <typename T>
+    const T* values() const;
+    template <typename T>
+    const T* operands() const;
+    const Operation* operations() const;
+
+    // Replaces the bank's calculators and division error count with the snapshot's
+    template <typename T>
+    void restoreInto(BasicCalculatorBank<T>& bank) const;
+    // Restores count double calculators; count must equal size()
+    template <typename TracePolicy, typename AccumulatePolicy>
+    void restoreInto(BasicCalculator<TracePolicy, AccumulatePolicy>* calculators, std::size_t count) const;
+    // Restores one calculator from a snapshot of exactly one
+    template <typename TracePolicy, typename AccumulatePolicy>
+    void restoreInto(BasicCalculator<TracePolicy, AccumulatePolicy>& calculator) const;
+};
+
+/**
+ * @brief Writes a snapshot of a whole bank
+ * @param path The snapshot file, replaced atomically
+ * @param bank The calculators to save
+ * @param sequence Journal position the bank's state corresponds to
+ */
+template <typename T>
+void writeSnapshot(const std::string& path, const BasicCalculatorBank<T>& bank, std::uint64_t sequence) {
+    writeSnapshot(path, bank.size(), bank.getValues(), bank.getOperations(), bank.getOperands(), sequence,
+                  bank.getDivisionErrorCount());
+}
+
+/**
+ * @brief Writes a snapshot of an array of calculators
+ * @param path The snapshot file, replaced atomically
+ * @param calculators The calculators to save
+ * @param count Number of calculators
+ * @param sequence Journal position their state corresponds to
+ * The states are gathered into the bank layout first
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void writeSnapshot(const std::string& path, const BasicCalculator<TracePolicy, AccumulatePolicy>* calculators,
+                   std::size_t count, std::uint64_t sequence) {
+    static_assert(std::is_same<typename AccumulatePolicy::value_type, double>::value,
+                  "Snapshots hold double calculators; use a bank for float");
+    std::vector<double> values(count);
+    std::vector<double> operands(count);
+    std::vector<Operation> operations(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        values[i] = calculators[i].getValue();
+        operations[i] = calculators[i].getOperation();
+        operands[i] = calculators[i].getOperand();
+    }
+    writeSnapshot(path, count, values.data(), operations.data(), operands.data(), sequence);
+}
+
+/**
+ * @brief Gets the saved values
+ * @return size() values of type T, in place in the mapping
+ */
+template <typename T>
+const T* MappedSnapshot::values() const {
+    requirePrecision(SnapshotPrecision<T>::value);
+    return reinterpret_cast<const T*>(file.data() + sizeof(SnapshotHeader));
+}
+
+/**
+ * @brief Gets the saved operands of the last operations
+ * @return size() operands of type T, in place in the mapping
+ */
+template <typename T>
+const T* MappedSnapshot::operands() const {
+    requirePrecision(SnapshotPrecision<T>::value);
+    return reinterpret_cast<const T*>(file.data() + sizeof(SnapshotHeader) + count * sizeof(T));
+}
+
+/**
+ * @brief Restores a bank from the snapshot
+ * @param bank Resized to size() calculators, each set to its saved state
+ */
+template <typename T>
+void MappedSnapshot::restoreInto(BasicCalculatorBank<T>& bank) const {
+    bank.assign(count, values<T>(), operations(), operands<T>(),
+                static_cast<std::size_t>(header->divisionErrors));
+}
+
+/**
+ * @brief Restores an array of calculators from the snapshot
+ * @param calculators Set through restore(), so journaling policies do not log it
+ * @param n Number of calculators; throws std::runtime_error unless it is size()
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void MappedSnapshot::restoreInto(BasicCalculator<TracePolicy, AccumulatePolicy>* calculators,
+                                 std::size_t n) const {
+    static_assert(std::is_same<typename AccumulatePolicy::value_type, double>::value,
+                  "Snapshots hold double calculators; use a bank for float");
+    if (n != count) {
+        throw std::runtime_error("Snapshot holds " + std::to_string(count) + " calculators, not " +
+                                 std::to_string(n));
+    }
+    const double* savedValues = values<double>();
+    const double* savedOperands = operands<double>();
+    const Operation* savedOperations = operations();
+    for (std::size_t i = 0; i < n; ++i) {
+        calculators[i].restore(savedValues[i], savedOperations[i], savedOperands[i]);
+    }
+}
+
+/**
+ * @brief Restores a single calculator from the snapshot
+ * @param calculator Set through restore(), so journaling policies do not log it
+ */
+template <typename TracePolicy, typename AccumulatePolicy>
+void MappedSnapshot::restoreInto(BasicCalculator<TracePolicy, AccumulatePolicy>& calculator) const {
+    restoreInto(&calculator, 1);
+}
+
+#endif // SNAPSHOT_H
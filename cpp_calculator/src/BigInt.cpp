@@ -0,0 +1,673 @@
+#include "BigInt.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace Utils {
+    namespace {
+        typedef BigInt::Limb Limb;
+        typedef std::uint64_t Wide;
+
+        const int limbBits = 32;
+        // Below this many limbs in the shorter operand schoolbook multiplication
+        // is faster than Karatsuba's extra additions (measured with the
+        // BigInt benchmarks)
+        const std::size_t karatsubaThreshold = 40;
+        // The largest power of ten in a limb, for decimal conversion
+        const Limb decimalChunk = 1000000000u;
+        const int decimalChunkDigits = 9;
+
+        std::size_t trimmedLength(const Limb* limbs, std::size_t length) {
+            while (length != 0 && limbs[length - 1] == 0) {
+                --length;
+            }
+            return length;
+        }
+
+        int compareMagnitude(const Limb* a, std::size_t an, const Limb* b, std::size_t bn) {
+            if (an != bn) {
+                return an < bn ? -1 : 1;
+            }
+            for (std::size_t i = an; i-- != 0;) {
+                if (a[i] != b[i]) {
+                    return a[i] < b[i] ? -1 : 1;
+                }
+            }
+            return 0;
+        }
+
+        // out = a + b with an >= bn; out has an + 1 limbs and may alias a or b
+        void addMagnitude(const Limb* a, std::size_t an, const Limb* b, std::size_t bn, Limb* out) {
+            Wide carry = 0;
+            std::size_t i = 0;
+            for (; i < bn; ++i) {
+                const Wide sum = Wide(a[i]) + b[i] + carry;
+                out[i] = static_cast<Limb>(sum);
+                carry = sum >> limbBits;
+            }
+            for (; i < an; ++i) {
+                const Wide sum = Wide(a[i]) + carry;
+                out[i] = static_cast<Limb>(sum);
+                carry = sum >> limbBits;
+            }
+            out[an] = static_cast<Limb>(carry);
+        }
+
+        // out = a - b with a >= b; out has an limbs and may alias a or b
+        void subtractMagnitude(const Limb* a, std::size_t an, const Limb* b, std::size_t bn, Limb* out) {
+            Limb borrow = 0;
+            std::size_t i = 0;
+            for (; i < bn; ++i) {
+                const Wide difference = Wide(a[i]) - b[i] - borrow;
+                out[i] = static_cast<Limb>(difference);
+                borrow = static_cast<Limb>(difference >> limbBits) & 1u;
+            }
+            for (; i < an; ++i) {
+                const Wide difference = Wide(a[i]) - borrow;
+                out[i] = static_cast<Limb>(difference);
+                borrow = static_cast<Limb>(difference >> limbBits) & 1u;
+            }
+        }
+
+        // target += source, carrying as far as needed; the sum fits in targetLength limbs
+        void addInto(Limb* target, std::size_t targetLength, const Limb* source, std::size_t sourceLength) {
+            Wide carry = 0;
+            std::size_t i = 0;
+            for (; i < sourceLength; ++i) {
+                const Wide sum = Wide(target[i]) + source[i] + carry;
+                target[i] = static_cast<Limb>(sum);
+                carry = sum >> limbBits;
+            }
+            for (; carry != 0 && i < targetLength; ++i) {
+                const Wide sum = Wide(target[i]) + carry;
+                target[i] = static_cast<Limb>(sum);
+                carry = sum >> limbBits;
+            }
+        }
+
+        // target -= source; the difference is non-negative
+        void subtractFrom(Limb* target, std::size_t targetLength, const Limb* source, std::size_t sourceLength) {
+            Limb borrow = 0;
+            std::size_t i = 0;
+            for (; i < sourceLength; ++i) {
+                const Wide difference = Wide(target[i]) - source[i] - borrow;
+                target[i] = static_cast<Limb>(difference);
+                borrow = static_cast<Limb>(difference >> limbBits) & 1u;
+            }
+            for (; borrow != 0 && i < targetLength; ++i) {
+                const Wide difference = Wide(target[i]) - borrow;
+                target[i] = static_cast<Limb>(difference);
+                borrow = static_cast<Limb>(difference >> limbBits) & 1u;
+            }
+        }
+
+        // out[0, an + bn) = a * b; out does not alias the operands
+        void multiplySchoolbook(const Limb* a, std::size_t an, const Limb* b, std::size_t bn, Limb* out) {
+            std::fill(out, out + an + bn, Limb(0));
+            for (std::size_t j = 0; j < bn; ++j) {
+                const Wide factor = b[j];
+                if (factor == 0) {
+                    continue;
+                }
+                Wide carry = 0;
+                for (std::size_t i = 0; i < an; ++i) {
+                    const Wide product = Wide(a[i]) * factor + out[i + j] + carry;
+                    out[i + j] = static_cast<Limb>(product);
+                    carry = product >> limbBits;
+                }
+                out[an + j] = static_cast<Limb>(carry);
+            }
+        }
+
+        /**
+         * @brief Multiplies two magnitudes
+         * @param a First factor, an limbs
+         * @param b Second factor, bn limbs
+         * @param out Receives an + bn limbs; must not alias a or b
+         * Karatsuba above karatsubaThreshold: with a = a1*B^m + a0 and
+         * b = b1*B^m + b0, three half-size products replace four, as
+         * a*b = z2*B^2m + ((a0 + a1)(b0 + b1) - z2 - z0)*B^m + z0. Operands of
+         * very different lengths are multiplied in slices of the shorter one.
+         */
+        void multiplyMagnitude(const Limb* a, std::size_t an, const Limb* b, std::size_t bn, Limb* out) {
+            if (an < bn) {
+                std::swap(a, b);
+                std::swap(an, bn);
+            }
+            if (bn < karatsubaThreshold) {
+                multiplySchoolbook(a, an, b, bn, out);
+                return;
+            }
+            if (an >= 2 * bn) {
+                std::fill(out, out + an + bn, Limb(0));
+                std::vector<Limb> partial(2 * bn);
+                for (std::size_t start = 0; start < an; start += bn) {
+                    const std::size_t slice = std::min(bn, an - start);
+                    multiplyMagnitude(a + start, slice, b, bn, partial.data());
+                    addInto(out + start, an + bn - start, partial.data(), slice + bn);
+                }
+                return;
+            }
+
+            // bn > an / 2 >= m, so both high halves are non-empty
+            const std::size_t m = an / 2;
+            const std::size_t a1n = an - m;
+            const std::size_t b1n = bn - m;
+
+            std::vector<Limb> aSum(a1n + 1);
+            std::vector<Limb> bSum(std::max(m, b1n) + 1);
+            addMagnitude(a + m, a1n, a, m, aSum.data());
+            if (b1n >= m) {
+                addMagnitude(b + m, b1n, b, m, bSum.data());
+            } else {
+                addMagnitude(b, m, b + m, b1n, bSum.data());
+            }
+            const std::size_t aSumLength = trimmedLength(aSum.data(), aSum.size());
+            const std::size_t bSumLength = trimmedLength(bSum.data(), bSum.size());
+
+            std::vector<Limb> z0(2 * m);
+            std::vector<Limb> z2(a1n + b1n);
+            std::vector<Limb> z1(aSumLength + bSumLength);
+            multiplyMagnitude(a, m, b, m, z0.data());
+            multiplyMagnitude(a + m, a1n, b + m, b1n, z2.data());
+            multiplyMagnitude(aSum.data(), aSumLength, bSum.data(), bSumLength, z1.data());
+            // The halves may have leading zeros, so subtract only significant limbs
+            subtractFrom(z1.data(), z1.size(), z0.data(), trimmedLength(z0.data(), z0.size()));
+            subtractFrom(z1.data(), z1.size(), z2.data(), trimmedLength(z2.data(), z2.size()));
+
+            std::copy(z0.begin(), z0.end(), out);
+            std::fill(out + 2 * m, out + an + bn, Limb(0));
+            std::copy(z2.begin(), z2.end(), out + 2 * m);
+            addInto(out + m, an + bn - m, z1.data(), trimmedLength(z1.data(), z1.size()));
+        }
+
+        // Divides a magnitude by one limb in place and returns the remainder
+        Limb divideBySmall(Limb* limbs, std::size_t length, Limb divisor) {
+            Wide remainder = 0;
+            for (std::size_t i = length; i-- != 0;) {
+                const Wide current = (remainder << limbBits) | limbs[i];
+                limbs[i] = static_cast<Limb>(current / divisor);
+                remainder = current % divisor;
+            }
+            return static_cast<Limb>(remainder);
+        }
+
+        // value is non-zero
+        int leadingZeros(Limb value) {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_clz(value);
+#else
+            int count = 0;
+            while ((value & 0x80000000u) == 0) {
+                value <<= 1;
+                ++count;
+            }
+            return count;
+#endif
+        }
+
+        // A magnitude of at most two limbs as one integer
+        std::uint64_t toWord(const Limb* limbs, std::size_t length) {
+            return length == 0 ? 0 : length == 1 ? limbs[0] : (std::uint64_t(limbs[1]) << limbBits) | limbs[0];
+        }
+
+        /**
+         * @brief Long division of magnitudes (Knuth, TAOCP vol. 2, algorithm D)
+         * @param u Dividend, un limbs, un >= vn
+         * @param v Divisor, vn >= 2 limbs with a non-zero top limb
+         * @param quotient Receives un - vn + 1 limbs
+         * @param remainder Receives vn limbs
+         */
+        void divideMagnitude(const Limb* u, std::size_t un, const Limb* v, std::size_t vn, Limb* quotient,
+                             Limb* remainder) {
+            // Normalize so the divisor's top bit is set, which makes each
+            // estimated quotient digit at most two too large
+            const int shift = leadingZeros(v[vn - 1]);
+            std::vector<Limb> vs(vn);
+            std::vector<Limb> us(un + 1);
+            for (std::size_t i = vn - 1; i > 0; --i) {
+                vs[i] = shift == 0 ? v[i] : (v[i] << shift) | (v[i - 1] >> (limbBits - shift));
+            }
+            vs[0] = v[0] << shift;
+            us[un] = shift == 0 ? 0 : u[un - 1] >> (limbBits - shift);
+            for (std::size_t i = un - 1; i > 0; --i) {
+                us[i] = shift == 0 ? u[i] : (u[i] << shift) | (u[i - 1] >> (limbBits - shift));
+            }
+            us[0] = u[0] << shift;
+
+            const Wide base = Wide(1) << limbBits;
+            for (std::size_t j = un - vn + 1; j-- != 0;) {
+                const Wide top = (Wide(us[j + vn]) << limbBits) | us[j + vn - 1];
+                Wide estimate = top / vs[vn - 1];
+                Wide rest = top % vs[vn - 1];
+                while (estimate >= base || estimate * vs[vn - 2] > ((rest << limbBits) | us[j + vn - 2])) {
+                    --estimate;
+                    rest += vs[vn - 1];
+                    if (rest >= base) {
+                        break;
+                    }
+                }
+
+                // us[j, j + vn] -= estimate * vs
+                Wide carry = 0;
+                Limb borrow = 0;
+                for (std::size_t i = 0; i < vn; ++i) {
+                    const Wide product = estimate * vs[i] + carry;
+                    carry = product >> limbBits;
+                    const Wide difference = Wide(us[i + j]) - static_cast<Limb>(product) - borrow;
+                    us[i + j] = static_cast<Limb>(difference);
+                    borrow = static_cast<Limb>(difference >> limbBits) & 1u;
+                }
+                const Wide difference = Wide(us[j + vn]) - carry - borrow;
+                us[j + vn] = static_cast<Limb>(difference);
+
+                if ((difference >> limbBits) != 0) {
+                    // The estimate was one too large: add the divisor back
+                    --estimate;
+                    Wide sumCarry = 0;
+                    for (std::size_t i = 0; i < vn; ++i) {
+                        const Wide sum = Wide(us[i + j]) + vs[i] + sumCarry;
+                        us[i + j] = static_cast<Limb>(sum);
+                        sumCarry = sum >> limbBits;
+                    }
+                    us[j + vn] = static_cast<Limb>(us[j + vn] + sumCarry);
+                }
+                quotient[j] = static_cast<Limb>(estimate);
+            }
+
+            for (std::size_t i = 0; i < vn; ++i) {
+                remainder[i] = shift == 0 ? us[i] : (us[i] >> shift) | (us[i + 1] << (limbBits - shift));
+            }
+        }
+    }
+
+    /**
+     * @brief Constructor - Converts a 64-bit integer
+     * @param value Any int64 value, including INT64_MIN
+     * Never allocates
+     */
+    BigInt::BigInt(std::int64_t value) noexcept : length(0), capacity(inlineLimbs), negative(value < 0) {
+        std::uint64_t magnitude = value < 0 ? 0u - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value);
+        while (magnitude != 0) {
+            local[length++] = static_cast<Limb>(magnitude);
+            magnitude >>= limbBits;
+        }
+    }
+
+    BigInt::BigInt(const BigInt& other) : length(other.length), capacity(inlineLimbs), negative(other.negative) {
+        if (other.length <= inlineLimbs) {
+            // A fixed-size copy, cheaper than one sized by length
+            std::memcpy(local, other.limbs(), sizeof(local));
+        } else {
+            heap = new Limb[other.length];
+            capacity = other.length;
+            std::memcpy(heap, other.heap, other.length * sizeof(Limb));
+        }
+    }
+
+    BigInt::BigInt(BigInt&& other) noexcept : length(other.length), capacity(other.capacity), negative(other.negative) {
+        if (other.isInline()) {
+            std::memcpy(local, other.local, sizeof(local));
+        } else {
+            heap = other.heap;
+            other.capacity = inlineLimbs;
+        }
+        other.length = 0;
+        other.negative = false;
+    }
+
+    BigInt& BigInt::operator=(const BigInt& other) {
+        if (this != &other) {
+            allocate(other.length);
+            if (isInline()) {
+                std::memcpy(local, other.limbs(), sizeof(local));
+            } else {
+                std::memcpy(heap, other.limbs(), other.length * sizeof(Limb));
+            }
+            length = other.length;
+            negative = other.negative;
+        }
+        return *this;
+    }
+
+    BigInt& BigInt::operator=(BigInt&& other) noexcept {
+        if (this != &other) {
+            if (!isInline()) {
+                delete[] heap;
+            }
+            length = other.length;
+            capacity = other.capacity;
+            negative = other.negative;
+            if (other.isInline()) {
+                std::memcpy(local, other.local, sizeof(local));
+            } else {
+                heap = other.heap;
+                other.capacity = inlineLimbs;
+            }
+            other.length = 0;
+            other.negative = false;
+        }
+        return *this;
+    }
+
+    BigInt::~BigInt() {
+        if (!isInline()) {
+            delete[] heap;
+        }
+    }
+
+    void BigInt::allocate(std::size_t count) {
+        if (count <= capacity) {
+            return;
+        }
+        Limb* limbs = new Limb[count];
+        if (!isInline()) {
+            delete[] heap;
+        }
+        heap = limbs;
+        capacity = static_cast<std::uint32_t>(count);
+    }
+
+    void BigInt::trim() {
+        length = static_cast<std::uint32_t>(trimmedLength(limbs(), length));
+        if (length == 0) {
+            negative = false;
+        }
+    }
+
+    /**
+     * @brief Parses a decimal integer
+     * @param text Digits with an optional leading '+' or '-'
+     * @return The value
+     * Throws std::invalid_argument for anything else, including empty text
+     */
+    BigInt BigInt::fromString(const std::string& text) {
+        std::size_t position = 0;
+        bool negative = false;
+        if (position < text.size() && (text[position] == '-' || text[position] == '+')) {
+            negative = text[position] == '-';
+            ++position;
+        }
+        if (position == text.size()) {
+            throw std::invalid_argument("Invalid integer: " + text);
+        }
+
+        BigInt result;
+        // Each decimal digit adds at most 3.33 bits
+        result.allocate((text.size() - position) / 9 + 1);
+        Limb* limbs = result.limbs();
+        while (position < text.size()) {
+            Limb chunk = 0;
+            Limb scale = 1;
+            for (int digit = 0; digit < decimalChunkDigits && position < text.size(); ++digit, ++position) {
+                const char c = text[position];
+                if (c < '0' || c > '9') {
+                    throw std::invalid_argument("Invalid integer: " + text);
+                }
+                chunk = chunk * 10 + static_cast<Limb>(c - '0');
+                scale *= 10;
+            }
+            // result = result * scale + chunk
+            Wide carry = chunk;
+            for (std::size_t i = 0; i < result.length; ++i) {
+                const Wide product = Wide(limbs[i]) * scale + carry;
+                limbs[i] = static_cast<Limb>(product);
+                carry = product >> limbBits;
+            }
+            if (carry != 0) {
+                limbs[result.length++] = static_cast<Limb>(carry);
+            }
+        }
+        result.negative = negative;
+        result.trim();
+        return result;
+    }
+
+    /**
+     * @brief Formats the value in decimal
+     * @return The digits, with a leading '-' for negative values
+     * Peels off nine digits at a time by dividing a copy by 10^9
+     */
+    std::string BigInt::toString() const {
+        if (length == 0) {
+            return "0";
+        }
+        std::vector<Limb> magnitude(limbs(), limbs() + length);
+        std::size_t remaining = length;
+        std::vector<Limb> chunks;
+        while (remaining != 0) {
+            chunks.push_back(divideBySmall(magnitude.data(), remaining, decimalChunk));
+            remaining = trimmedLength(magnitude.data(), remaining);
+        }
+
+        std::string text = negative ? "-" : "";
+        text += std::to_string(chunks.back());
+        char digits[decimalChunkDigits + 1];
+        for (std::size_t i = chunks.size() - 1; i-- != 0;) {
+            Limb chunk = chunks[i];
+            for (int digit = decimalChunkDigits - 1; digit >= 0; --digit) {
+                digits[digit] = static_cast<char>('0' + chunk % 10);
+                chunk /= 10;
+            }
+            digits[decimalChunkDigits] = '\0';
+            text += digits;
+        }
+        return text;
+    }
+
+    /**
+     * @brief Converts to the nearest double
+     * @return The value rounded to nearest, ties to even; +-infinity when too large
+     * The top 64 bits are converted with any lower non-zero bits folded into a
+     * sticky bit, so the single rounding of that conversion is the correct one
+     */
+    double BigInt::toDouble() const {
+        if (length == 0) {
+            return 0.0;
+        }
+        const Limb* magnitude = limbs();
+        const std::size_t bits = bitLength();
+        std::uint64_t top = 0;
+        bool sticky = false;
+        if (bits <= 64) {
+            for (std::size_t i = length; i-- != 0;) {
+                top = (top << limbBits) | magnitude[i];
+            }
+        } else {
+            // Bits [bits - 64, bits) of the magnitude
+            const std::size_t low = bits - 64;
+            const std::size_t limb = low / limbBits;
+            const int offset = static_cast<int>(low % limbBits);
+            for (std::size_t i = 0; i < 3 && limb + i < length; ++i) {
+                const std::uint64_t part = magnitude[limb + i];
+                const int position = static_cast<int>(i) * limbBits - offset;
+                if (position >= 64) {
+                    break;
+                }
+                top |= position >= 0 ? part << position : part >> -position;
+            }
+            sticky = offset != 0 && (magnitude[limb] & ((Limb(1) << offset) - 1u)) != 0;
+            for (std::size_t i = 0; i < limb && !sticky; ++i) {
+                sticky = magnitude[i] != 0;
+            }
+        }
+        const double rounded = static_cast<double>(top | (sticky ? 1u : 0u));
+        if (bits <= 64) {
+            return negative ? -rounded : rounded;
+        }
+        // Beyond 2^1024 ldexp gives infinity; clamp so the int cannot overflow
+        const int scale = static_cast<int>(std::min<std::size_t>(bits - 64, 2048));
+        const double value = std::ldexp(rounded, scale);
+        return negative ? -value : value;
+    }
+
+    std::size_t BigInt::bitLength() const {
+        if (length == 0) {
+            return 0;
+        }
+        return length * limbBits - static_cast<std::size_t>(leadingZeros(limbs()[length - 1]));
+    }
+
+    int BigInt::compare(const BigInt& other) const {
+        if (negative != other.negative) {
+            return negative ? -1 : 1;
+        }
+        const int magnitude = compareMagnitude(limbs(), length, other.limbs(), other.length);
+        return negative ? -magnitude : magnitude;
+    }
+
+    BigInt BigInt::operator-() const {
+        BigInt result(*this);
+        result.negative = length != 0 && !negative;
+        return result;
+    }
+
+    /**
+     * @brief Adds or subtracts two values in sign-magnitude form
+     * @param a First operand
+     * @param b Second operand
+     * @param subtract True for a - b
+     * @return The result; allocation-free when it fits in inlineLimbs
+     */
+    BigInt BigInt::addSigned(const BigInt& a, const BigInt& b, bool subtract) {
+        const bool bNegative = b.negative != subtract;
+        BigInt result;
+        if (a.length <= 2 && b.length <= 2) {
+            // Both fit in 64 bits: one word operation into the inline limbs
+            const std::uint64_t x = toWord(a.limbs(), a.length);
+            const std::uint64_t y = toWord(b.limbs(), b.length);
+            std::uint64_t word;
+            if (a.negative == bNegative) {
+                word = x + y;
+                result.local[2] = word < x ? 1u : 0u;
+                result.length = 3;
+                result.negative = a.negative;
+            } else {
+                word = x >= y ? x - y : y - x;
+                result.length = 2;
+                result.negative = x >= y ? a.negative : bNegative;
+            }
+            result.local[0] = static_cast<Limb>(word);
+            result.local[1] = static_cast<Limb>(word >> limbBits);
+            result.trim();
+            return result;
+        }
+
+        const BigInt& larger = compareMagnitude(a.limbs(), a.length, b.limbs(), b.length) >= 0 ? a : b;
+        const BigInt& smaller = &larger == &a ? b : a;
+        if (a.negative == bNegative) {
+            result.allocate(larger.length + 1u);
+            addMagnitude(larger.limbs(), larger.length, smaller.limbs(), smaller.length, result.limbs());
+            result.length = larger.length + 1u;
+            result.negative = a.negative;
+        } else {
+            result.allocate(larger.length);
+            subtractMagnitude(larger.limbs(), larger.length, smaller.limbs(), smaller.length, result.limbs());
+            result.length = larger.length;
+            result.negative = &larger == &a ? a.negative : bNegative;
+        }
+        result.trim();
+        return result;
+    }
+
+    BigInt operator+(const BigInt& a, const BigInt& b) {
+        return BigInt::addSigned(a, b, false);
+    }
+
+    BigInt operator-(const BigInt& a, const BigInt& b) {
+        return BigInt::addSigned(a, b, true);
+    }
+
+    BigInt operator*(const BigInt& a, const BigInt& b) {
+        BigInt result;
+        if (a.length == 0 || b.length == 0) {
+            return result;
+        }
+        // A fresh result never aliases the operands, as multiplyMagnitude requires
+        result.allocate(a.length + b.length);
+        multiplyMagnitude(a.limbs(), a.length, b.limbs(), b.length, result.limbs());
+        result.length = a.length + b.length;
+        result.negative = a.negative != b.negative;
+        result.trim();
+        return result;
+    }
+
+    /**
+     * @brief Truncating division with remainder
+     * @param dividend The dividend
+     * @param divisor The divisor
+     * @param quotient Receives dividend / divisor, rounded toward zero
+     * @param remainder Receives dividend - quotient * divisor
+     * Throws std::runtime_error for a zero divisor. quotient and remainder must
+     * be distinct objects from the operands.
+     */
+    void BigInt::divide(const BigInt& dividend, const BigInt& divisor, BigInt& quotient, BigInt& remainder) {
+        if (divisor.length == 0) {
+            throw std::runtime_error("Division by zero error");
+        }
+        if (compareMagnitude(dividend.limbs(), dividend.length, divisor.limbs(), divisor.length) < 0) {
+            remainder = dividend;
+            quotient = BigInt();
+            return;
+        }
+
+        quotient.allocate(dividend.length);
+        if (divisor.length == 1) {
+            std::memcpy(quotient.limbs(), dividend.limbs(), dividend.length * sizeof(Limb));
+            const Limb rest = divideBySmall(quotient.limbs(), dividend.length, divisor.limbs()[0]);
+            remainder = BigInt(static_cast<std::int64_t>(rest));
+        } else {
+            remainder.allocate(divisor.length);
+            divideMagnitude(dividend.limbs(), dividend.length, divisor.limbs(), divisor.length, quotient.limbs(),
+                            remainder.limbs());
+            remainder.length = divisor.length;
+        }
+        quotient.length = dividend.length - divisor.length + 1u;
+        quotient.negative = dividend.negative != divisor.negative;
+        quotient.trim();
+        remainder.negative = dividend.negative;
+        remainder.trim();
+    }
+
+    BigInt operator/(const BigInt& a, const BigInt& b) {
+        BigInt quotient;
+        BigInt remainder;
+        BigInt::divide(a, b, quotient, remainder);
+        return quotient;
+    }
+
+    BigInt operator%(const BigInt& a, const BigInt& b) {
+        BigInt quotient;
+        BigInt remainder;
+        BigInt::divide(a, b, quotient, remainder);
+        return remainder;
+    }
+
+    /**
+     * @brief Raises a value to a non-negative integer power
+     * @param base The base
+     * @param exponent The exponent; base^0 is 1, including 0^0
+     * @return base^exponent, computed by squaring so that the largest
+     *         multiplications are balanced and run on Karatsuba
+     */
+    BigInt BigInt::power(const BigInt& base, unsigned int exponent) {
+        BigInt result(1);
+        BigInt square(base);
+        while (exponent != 0) {
+            if (exponent & 1u) {
+                result = result * square;
+            }
+            exponent >>= 1;
+            if (exponent != 0) {
+                square = square * square;
+            }
+        }
+        return result;
+    }
+
+    std::ostream& operator<<(std::ostream& out, const BigInt& value) {
+        return out << value.toString();
+    }
+}
@@ -0,0 +1,376 @@
+#include "CalculationService.h"
+#include <climits>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+// One queued calculation; also the node of the intrusive request queue
+struct CalculationService::Request {
+    std::atomic<Request*> next;
+    Operation operation;
+    double lhs;
+    double rhs;
+    CalculationService::Callback callback;
+    // Engaged only for submissions that return a future
+    std::optional<std::promise<Utils::MathResult> > promise;
+};
+
+namespace {
+    typedef CalculationService::Callback Callback;
+
+    /**
+     * @brief Intrusive multi-producer single-consumer queue (Vyukov)
+     *
+     * push is one atomic exchange and never waits on other producers or on
+     * the consumer. pop belongs to the owning worker and can briefly return
+     * nullptr while a producer is between its exchange and its link; empty()
+     * stays false during that window, so the worker retries instead of sleeping.
+     */
+    template <typename Node>
+    class RequestQueue {
+    public:
+        RequestQueue() : head(&stub), tail(&stub) {
+            stub.next.store(nullptr, std::memory_order_relaxed);
+        }
+
+        RequestQueue(const RequestQueue&) = delete;
+        RequestQueue& operator=(const RequestQueue&) = delete;
+
+        void push(Node* node) {
+            node->next.store(nullptr, std::memory_order_relaxed);
+            Node* previous = head.exchange(node, std::memory_order_seq_cst);
+            previous->next.store(node, std::memory_order_release);
+        }
+
+        Node* pop() {
+            Node* first = tail;
+            Node* next = first->next.load(std::memory_order_acquire);
+            if (first == &stub) {
+                if (next == nullptr) {
+                    return nullptr;
+                }
+                tail = next;
+                first = next;
+                next = next->next.load(std::memory_order_acquire);
+            }
+            if (next != nullptr) {
+                tail = next;
+                return first;
+            }
+            if (first != head.load(std::memory_order_acquire)) {
+                return nullptr; // a producer has not linked its node yet
+            }
+            // first is the only node; put the stub behind it so it can be unlinked
+            push(&stub);
+            next = first->next.load(std::memory_order_acquire);
+            if (next != nullptr) {
+                tail = next;
+                return first;
+            }
+            return nullptr;
+        }
+
+        // Consumer side only
+        bool empty() const {
+            return tail == &stub && head.load(std::memory_order_seq_cst) == &stub;
+        }
+
+    private:
+        std::atomic<Node*> head; // last pushed node, shared by producers
+        Node* tail;              // next node to pop, owned by the consumer
+        Node stub;
+    };
+
+    bool toExponent(double value, int& exponent) {
+        if (!(value >= INT_MIN && value <= INT_MAX) || std::trunc(value) != value) {
+            return false;
+        }
+        exponent = static_cast<int>(value);
+        return true;
+    }
+
+    bool isBatchable(Operation operation) {
+        return operation == Operation::Add || operation == Operation::Subtract ||
+               operation == Operation::Multiply || operation == Operation::Divide;
+    }
+}
+
+// A worker thread with its own request queue and batch scratch space
+struct CalculationService::Worker {
+    RequestQueue<Request> queue;
+    std::mutex mutex;
+    std::condition_variable wake;
+    // Set while the worker is about to wait or waiting, so producers know to notify
+    std::atomic<bool> sleeping;
+    bool quit; // guarded by mutex
+    std::atomic<std::uint64_t> requests;
+    std::atomic<std::uint64_t> batches;
+
+    // Written only by the worker thread
+    std::vector<Request*> batch;
+    std::vector<Request*> grouped;
+    std::vector<double> lhs;
+    std::vector<double> rhs;
+    std::vector<double> out;
+
+    std::thread thread;
+
+    explicit Worker(std::size_t maxBatch)
+        : sleeping(false), quit(false), requests(0), batches(0),
+          batch(maxBatch), grouped(maxBatch), lhs(maxBatch), rhs(maxBatch), out(maxBatch) {}
+};
+
+/**
+ * @brief Starts the worker threads
+ * @param options Worker count and largest batch size
+ * @throws std::system_error if not even one worker thread can be started
+ */
+CalculationService::CalculationService(const ServiceOptions& options)
+    : maxBatch(options.maxBatch != 0 ? options.maxBatch : 1), nextWorker(0), activeSubmits(0),
+      stopping(false), stopped(false) {
+    unsigned count = options.workers != 0 ? options.workers : std::thread::hardware_concurrency();
+    if (count == 0) {
+        count = 1;
+    }
+
+    workers.reserve(count);
+    for (unsigned i = 0; i < count; ++i) {
+        workers.emplace_back(new Worker(maxBatch));
+        Worker& worker = *workers.back();
+        try {
+            worker.thread = std::thread(&CalculationService::run, std::ref(worker), maxBatch);
+        } catch (const std::system_error&) {
+            workers.pop_back();
+            if (workers.empty()) {
+                throw;
+            }
+            // Out of threads: run with the workers already started
+            break;
+        }
+    }
+}
+
+CalculationService::~CalculationService() {
+    shutdown();
+}
+
+/**
+ * @brief Queues a calculation whose result is delivered through a future
+ * @param operation Add, Subtract, Multiply, Divide or Power
+ * @param lhs The left operand (the base for Power)
+ * @param rhs The right operand (the integer exponent for Power)
+ * @return A future for the checked result
+ * @throws std::invalid_argument for any other operation
+ * @throws std::runtime_error after shutdown()
+ */
+std::future<Utils::MathResult> CalculationService::submit(Operation operation, double lhs, double rhs) {
+    std::unique_ptr<Request> request(new Request());
+    request->operation = operation;
+    request->lhs = lhs;
+    request->rhs = rhs;
+    request->promise.emplace();
+    std::future<Utils::MathResult> result = request->promise->get_future();
+    enqueue(request.get());
+    request.release();
+    return result;
+}
+
+/**
+ * @brief Queues a calculation whose result is passed to a callback
+ * @param operation Add, Subtract, Multiply, Divide or Power
+ * @param lhs The left operand (the base for Power)
+ * @param rhs The right operand (the integer exponent for Power)
+ * @param callback Called once on a worker thread with the checked result
+ * @throws std::invalid_argument for any other operation
+ * @throws std::runtime_error after shutdown()
+ */
+void CalculationService::submit(Operation operation, double lhs, double rhs, Callback callback) {
+    std::unique_ptr<Request> request(new Request());
+    request->operation = operation;
+    request->lhs = lhs;
+    request->rhs = rhs;
+    request->callback = std::move(callback);
+    enqueue(request.get());
+    request.release();
+}
+
+/**
+ * @brief Hands a request to the next worker in round-robin order
+ * @param request The request; ownership passes to the worker only if this returns
+ */
+void CalculationService::enqueue(Request* request) {
+    if (!isBatchable(request->operation) && request->operation != Operation::Power) {
+        throw std::invalid_argument("CalculationService only runs add, subtract, multiply, divide and power");
+    }
+
+    // Announce the submission before checking stopping, so shutdown() either
+    // waits for this push or this call sees the flag
+    activeSubmits.fetch_add(1, std::memory_order_seq_cst);
+    if (stopping.load(std::memory_order_seq_cst)) {
+        activeSubmits.fetch_sub(1, std::memory_order_release);
+        throw std::runtime_error("CalculationService is shut down");
+    }
+
+    Worker& worker = *workers[nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size()];
+    worker.queue.push(request);
+    if (worker.sleeping.load(std::memory_order_seq_cst)) {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.wake.notify_one();
+    }
+    activeSubmits.fetch_sub(1, std::memory_order_release);
+}
+
+/**
+ * @brief Worker loop: runs whatever has arrived as one batch, sleeps when idle
+ * @param worker The worker this thread serves
+ * @param maxBatch Most requests taken per batch
+ */
+void CalculationService::run(Worker& worker, std::size_t maxBatch) {
+    for (;;) {
+        std::size_t count = 0;
+        while (count < maxBatch) {
+            Request* request = worker.queue.pop();
+            if (request == nullptr) {
+                break;
+            }
+            worker.batch[count++] = request;
+        }
+        if (count != 0) {
+            process(worker, count);
+            continue;
+        }
+        if (!worker.queue.empty()) {
+            // A producer is mid-push; its node is linked momentarily
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        worker.sleeping.store(true, std::memory_order_seq_cst);
+        worker.wake.wait(lock, [&worker]() { return worker.quit || !worker.queue.empty(); });
+        worker.sleeping.store(false, std::memory_order_relaxed);
+        if (worker.quit && worker.queue.empty()) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Runs one batch grouped by operation and delivers the results
+ * @param worker The worker whose batch and scratch arrays are used
+ * @param count Number of requests in worker.batch
+ */
+void CalculationService::process(Worker& worker, std::size_t count) {
+    static const Operation batched[] = {Operation::Add, Operation::Subtract, Operation::Multiply, Operation::Divide};
+
+    std::size_t grouped = 0;
+    // Partition the batch so each operation runs as one contiguous kernel call
+    for (Operation operation : batched) {
+        const std::size_t begin = grouped;
+        for (std::size_t i = 0; i < count; ++i) {
+            Request* request = worker.batch[i];
+            if (request->operation == operation) {
+                worker.grouped[grouped] = request;
+                worker.lhs[grouped] = request->lhs;
+                // Zero divisors are reported per request, so keep them out of the kernel
+                worker.rhs[grouped] = operation == Operation::Divide && request->rhs == 0 ? 1.0 : request->rhs;
+                ++grouped;
+            }
+        }
+
+        const std::size_t n = grouped - begin;
+        const double* lhs = worker.lhs.data() + begin;
+        const double* rhs = worker.rhs.data() + begin;
+        double* out = worker.out.data() + begin;
+        switch (operation) {
+        case Operation::Add:
+            Utils::MathUtils::add(lhs, rhs, out, n);
+            break;
+        case Operation::Subtract:
+            Utils::MathUtils::subtract(lhs, rhs, out, n);
+            break;
+        case Operation::Multiply:
+            Utils::MathUtils::multiply(lhs, rhs, out, n);
+            break;
+        default:
+            Utils::MathUtils::divide(lhs, rhs, out, n);
+            break;
+        }
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        Request* request = worker.batch[i];
+        if (request->operation == Operation::Power) {
+            int exponent = 0;
+            worker.grouped[grouped] = request;
+            worker.out[grouped] = toExponent(request->rhs, exponent) ? Utils::MathUtils::power(request->lhs, exponent)
+                                                                     : 0.0;
+            ++grouped;
+        }
+    }
+
+    for (std::size_t i = 0; i < grouped; ++i) {
+        std::unique_ptr<Request> request(worker.grouped[i]);
+        int exponent = 0;
+        Utils::MathResult result = {worker.out[i], Utils::MathStatus::Ok};
+        if (request->operation == Operation::Divide && request->rhs == 0) {
+            result = Utils::MathResult{0.0, Utils::MathStatus::DivisionByZero};
+        } else if (request->operation == Operation::Power && !toExponent(request->rhs, exponent)) {
+            result = Utils::MathResult{0.0, Utils::MathStatus::InvalidExponent};
+        }
+
+        if (request->promise) {
+            request->promise->set_value(result);
+        } else {
+            request->callback(result);
+        }
+    }
+
+    worker.requests.store(worker.requests.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    worker.batches.store(worker.batches.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Stops accepting requests, finishes the accepted ones and joins the workers
+ */
+void CalculationService::shutdown() {
+    if (stopped) {
+        return;
+    }
+    stopped = true;
+
+    stopping.store(true, std::memory_order_seq_cst);
+    // A submit that saw stopping clear is still pushing; let it finish
+    while (activeSubmits.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+
+    for (std::size_t i = 0; i < workers.size(); ++i) {
+        std::lock_guard<std::mutex> lock(workers[i]->mutex);
+        workers[i]->quit = true;
+        workers[i]->wake.notify_one();
+    }
+    for (std::size_t i = 0; i < workers.size(); ++i) {
+        workers[i]->thread.join();
+    }
+}
+
+unsigned CalculationService::getWorkerCount() const {
+    return static_cast<unsigned>(workers.size());
+}
+
+/**
+ * @brief Counts requests and batches run so far
+ * @return The totals over all workers; requests / batches is the mean batch size
+ */
+ServiceStats CalculationService::getStats() const {
+    ServiceStats stats = {0, 0};
+    for (std::size_t i = 0; i < workers.size(); ++i) {
+        stats.requests += workers[i]->requests.load(std::memory_order_relaxed);
+        stats.batches += workers[i]->batches.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
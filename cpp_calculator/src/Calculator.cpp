@@ -1,137 +1,104 @@
 #include "Calculator.h"
-#include <iostream>
-#include <sstream>
+#include <cstdio>
 
-/**
- * @brief Constructor - Initializes the calculator with default values
- * Sets currentValue to 0.0 and lastOperation to "initialized"
- */
-Calculator::Calculator() : currentValue(0.0), lastOperation("initialized") {}
+// Without tracing a calculator is nothing but its value and can live in a register
+static_assert(sizeof(BasicCalculator<NoTrace>) == sizeof(double),
+              "BasicCalculator<NoTrace> must hold only its current value");
 
-/**
- * @brief Adds a value to the current calculator result
- * @param value The value to add to currentValue
- * Uses MathUtils::add for the arithmetic operation
- */
-void Calculator::add(double value) {
-    currentValue = Utils::MathUtils::add(currentValue, value);
-    std::ostringstream oss;
-    oss << "Added " << value;
-    lastOperation = oss.str();
-}
-
-/**
- * @brief Subtracts a value from the current calculator result
- * @param value The value to subtract from currentValue
- * Uses MathUtils::subtract for the arithmetic operation
- */
-void Calculator::subtract(double value) {
-    currentValue = Utils::MathUtils::subtract(currentValue, value);
-    std::ostringstream oss;
-    oss << "Subtracted " << value;
-    lastOperation = oss.str();
-}
-
-/**
- * @brief Multiplies the current calculator result by a value
- * @param value The value to multiply currentValue by
- * Uses MathUtils::multiply for the arithmetic operation
- */
-void Calculator::multiply(double value) {
-    currentValue = Utils::MathUtils::multiply(currentValue, value);
-    std::ostringstream oss;
-    oss << "Multiplied by " << value;
-    lastOperation = oss.str();
-}
-
-/**
- * @brief Divides the current calculator result by a value
- * @param value The divisor (cannot be zero)
- * Uses MathUtils::divide and handles division by zero errors
- * Sets lastOperation to "Division error" if an exception occurs
- */
-void Calculator::divide(double value) {
-    try {
-        currentValue = Utils::MathUtils::divide(currentValue, value);
-        std::ostringstream oss;
-        oss << "Divided by " << value;
-        lastOperation = oss.str();
-    } catch (const std::runtime_error& e) {
-        std::cerr << "Error: " << e.what() << std::endl;
-        lastOperation = "Division error";
+namespace {
+    /**
+     * @brief Gets the text that goes before the operand of a value operation
+     * @param operation The kind of operation that was performed
+     * @return "Added " and so on, or nullptr if the operation has no value operand
+     */
+    const char* operandPrefix(Operation operation) {
+        switch (operation) {
+        case Operation::Add:
+            return "Added ";
+        case Operation::Subtract:
+            return "Subtracted ";
+        case Operation::Multiply:
+            return "Multiplied by ";
+        case Operation::Divide:
+            return "Divided by ";
+        default:
+            return nullptr;
+        }
     }
-}
 
-/**
- * @brief Raises the current calculator result to a power
- * @param exponent The exponent to raise currentValue to
- * Uses MathUtils::power for the calculation
- */
-void Calculator::powerOf(int exponent) {
-    currentValue = Utils::MathUtils::power(currentValue, exponent);
-    std::ostringstream oss;
-    oss << "Raised to power " << exponent;
-    lastOperation = oss.str();
-}
-
-/**
- * @brief Resets the calculator to its initial state
- * Sets currentValue to 0.0 and lastOperation to "reset"
- */
-void Calculator::reset() {
-    currentValue = 0.0;
-    lastOperation = "reset";
-}
-
-/**
- * @brief Gets the current calculator result
- * @return The current value stored in the calculator
- */
-double Calculator::getValue() const {
-    return currentValue;
-}
-
-/**
- * @brief Gets the description of the last operation performed
- * @return A string describing the last operation executed
- */
-std::string Calculator::getLastOperation() const {
-    return lastOperation;
+    /**
+     * @brief Formats an operation record into a caller-supplied buffer
+     * @param operation The kind of operation that was performed
+     * @param operand The value the operation was applied with (the exponent for Power)
+     * @param buffer Receives the NUL-terminated text
+     * @return Length of the text
+     * Numbers are printed like a default-formatted std::ostream would print them
+     */
+    std::size_t formatOperation(Operation operation, double operand, char (&buffer)[64]) {
+        int length;
+        switch (operation) {
+        case Operation::Initialized:
+            length = std::snprintf(buffer, sizeof(buffer), "initialized");
+            break;
+        case Operation::Add:
+        case Operation::Subtract:
+        case Operation::Multiply:
+        case Operation::Divide:
+            length = std::snprintf(buffer, sizeof(buffer), "%s%g", operandPrefix(operation), operand);
+            break;
+        case Operation::Power:
+            length = std::snprintf(buffer, sizeof(buffer), "Raised to power %d", static_cast<int>(operand));
+            break;
+        case Operation::Reset:
+            length = std::snprintf(buffer, sizeof(buffer), "reset");
+            break;
+        case Operation::DivisionError:
+            length = std::snprintf(buffer, sizeof(buffer), "Division error");
+            break;
+        default:
+            length = std::snprintf(buffer, sizeof(buffer), "unknown");
+            break;
+        }
+        return static_cast<std::size_t>(length);
+    }
 }
 
 /**
- * @brief Checks if the current result is an even number
- * Casts currentValue to an integer and uses MathUtils::isEven
- * Prints the result to stdout
+ * @brief Formats an operation record as a human-readable description
+ * @param operation The kind of operation that was performed
+ * @param operand The value the operation was applied with (the exponent for Power)
+ * @return A string such as "Added 10" or "Raised to power 2"
  */
-void Calculator::checkIfResultIsEven() {
-    int intValue = static_cast<int>(currentValue);
-    if (Utils::MathUtils::isEven(intValue)) {
-        std::cout << "Current value " << intValue << " is even" << std::endl;
-    } else {
-        std::cout << "Current value " << intValue << " is odd" << std::endl;
-    }
+std::string describeOperation(Operation operation, double operand) {
+    char buffer[64];
+    const std::size_t length = formatOperation(operation, operand, buffer);
+    return std::string(buffer, length);
 }
 
 /**
- * @brief Helper function to check if a value is positive
- * @param value The value to check
- * @return true if value is greater than 0, false otherwise
+ * @brief Formats an operation record into a string from a memory resource
+ * @param operation The kind of operation that was performed
+ * @param operand The value the operation was applied with (the exponent for Power)
+ * @param resource Supplies the memory for the string, if it needs any
+ * @return The same text as describeOperation(operation, operand)
  */
-bool Calculator::isPositive(double value) const {
-    return value > 0;
+std::pmr::string describeOperation(Operation operation, double operand, std::pmr::memory_resource* resource) {
+    char buffer[64];
+    const std::size_t length = formatOperation(operation, operand, buffer);
+    return std::pmr::string(buffer, length, resource);
 }
 
 /**
- * @brief Checks if the current result is positive
- * Calls the helper function isPositive and prints the result
+ * @brief Formats a value operation whose operand is already text
+ * @param operation Add, Subtract, Multiply or Divide
+ * @param operand The operand as it should be printed, e.g. every digit of a BigInt
+ * @return A string such as "Added 12345678901234567890"; other operations are
+ * described as by describeOperation(operation, 0.0)
  */
-void Calculator::checkIfPositive() {
-    if (isPositive(currentValue)) {
-        std::cout << "Current value " << currentValue << " is positive" << std::endl;
-    } else if (currentValue == 0) {
-        std::cout << "Current value is zero" << std::endl;
-    } else {
-        std::cout << "Current value " << currentValue << " is negative" << std::endl;
+std::string describeOperation(Operation operation, const std::string& operand) {
+    const char* prefix = operandPrefix(operation);
+    if (prefix == nullptr) {
+        return describeOperation(operation, 0.0);
     }
+    return prefix + operand;
 }
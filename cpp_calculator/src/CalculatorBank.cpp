@@ -0,0 +1,346 @@
+#include "CalculatorBank.h"
+#include "MathUtils.h"
+#include <stdexcept>
+
+namespace {
+    const std::size_t maskBits = 64;
+
+    inline unsigned lowestSetBit(std::uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_ctzll(bits));
+#else
+        unsigned bit = 0;
+        while ((bits & 1u) == 0) {
+            bits >>= 1;
+            ++bit;
+        }
+        return bit;
+#endif
+    }
+
+    /**
+     * @brief Calls apply(begin, count) over the calculators a mask selects
+     * @param n Number of calculators
+     * @param mask Selection bitmask, or null for all
+     * @param apply Called with contiguous runs: the whole bank, whole 64-bit
+     *              words that are fully set, or single calculators
+     */
+    template <typename Apply>
+    void forEachSelected(std::size_t n, const std::uint64_t* mask, Apply apply) {
+        if (mask == nullptr) {
+            apply(std::size_t(0), n);
+            return;
+        }
+        for (std::size_t word = 0; word * maskBits < n; ++word) {
+            const std::size_t start = word * maskBits;
+            const std::size_t count = n - start < maskBits ? n - start : maskBits;
+            std::uint64_t bits = mask[word];
+            if (count < maskBits) {
+                bits &= (std::uint64_t(1) << count) - 1;
+            }
+            if (bits == ~std::uint64_t(0)) {
+                apply(start, maskBits);
+                continue;
+            }
+            while (bits != 0) {
+                apply(start + lowestSetBit(bits), std::size_t(1));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    template <typename T>
+    void fill(T* target, T value, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            target[i] = value;
+        }
+    }
+
+    template <typename T>
+    void copy(T* target, const T* source, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            target[i] = source[i];
+        }
+    }
+}
+
+/**
+ * @brief Constructor - Creates count calculators
+ * @param count Number of calculators
+ * @param initialValue Starting value of each one
+ * @param resource Supplies the arrays
+ */
+template <typename T>
+BasicCalculatorBank<T>::BasicCalculatorBank(std::size_t count, T initialValue, std::pmr::memory_resource* resource)
+    : values(count, initialValue, resource),
+      operands(count, T(0), resource),
+      operations(count, Operation::Initialized, resource),
+      divisionErrors(0) {}
+
+template <typename T>
+std::size_t BasicCalculatorBank<T>::size() const {
+    return values.size();
+}
+
+template <typename T>
+void BasicCalculatorBank<T>::resize(std::size_t count, T initialValue) {
+    values.resize(count, initialValue);
+    operands.resize(count, T(0));
+    operations.resize(count, Operation::Initialized);
+}
+
+/**
+ * @brief Adds a value to every selected calculator
+ * @param value The value to add
+ * @param mask Selection bitmask, or null for all calculators
+ */
+template <typename T>
+void BasicCalculatorBank<T>::add(T value, const std::uint64_t* mask) {
+    forEachSelected(size(), mask, [&](std::size_t begin, std::size_t count) {
+        T* v = &values[begin];
+        for (std::size_t i = 0; i < count; ++i) {
+            v[i] = v[i] + value;
+        }
+        fill(&operands[begin], value, count);
+        fill(&operations[begin], Operation::Add, count);
+    });
+}
+
+template <typename T>
+void BasicCalculatorBank<T>::subtract(T value, const std::uint64_t* mask) {
+    forEachSelected(size(), mask, [&](std::size_t begin, std::size_t count) {
+        T* v = &values[begin];
+        for (std::size_t i = 0; i < count; ++i) {
+            v[i] = v[i] - value;
+        }
+        fill(&operands[begin], value, count);
+        fill(&operations[begin], Operation::Subtract, count);
+    });
+}
+
+template <typename T>
+void BasicCalculatorBank<T>::multiply(T value, const std::uint64_t* mask) {
+    forEachSelected(size(), mask, [&](std::size_t begin, std::size_t count) {
+        T* v = &values[begin];
+        for (std::size_t i = 0; i < count; ++i) {
+            v[i] = v[i] * value;
+        }
+        fill(&operands[begin], value, count);
+        fill(&operations[begin], Operation::Multiply, count);
+    });
+}
+
+/**
+ * @brief Divides every selected calculator by a value
+ * @param value The divisor; zero only records a division error in each calculator
+ * @param mask Selection bitmask, or null for all calculators
+ */
+template <typename T>
+void BasicCalculatorBank<T>::divide(T value, const std::uint64_t* mask) {
+    const bool rejected = value == 0;
+    forEachSelected(size(), mask, [&](std::size_t begin, std::size_t count) {
+        if (!rejected) {
+            T* v = &values[begin];
+            for (std::size_t i = 0; i < count; ++i) {
+                v[i] = v[i] / value;
+            }
+        } else {
+            divisionErrors += count;
+        }
+        fill(&operands[begin], value, count);
+        fill(&operations[begin], rejected ? Operation::DivisionError : Operation::Divide, count);
+    });
+}
+
+/**
+ * @brief Raises every selected calculator to a power
+ * @param exponent The exponent
+ * @param mask Selection bitmask, or null for all calculators
+ * Uses the batch MathUtils::power, which matches the scalar one bit-for-bit
+ */
+template <typename T>
+void BasicCalculatorBank<T>::powerOf(int exponent, const std::uint64_t* mask) {
+    forEachSelected(size(), mask, [&](std::size_t begin, std::size_t count) {
+        Utils::MathUtils::power(&values[begin], exponent, count);
+        fill(&operands[begin], static_cast<T>(exponent), count);
+        fill(&operations[begin], Operation::Power, count);
+    });
+}
+
+template <typename T>
+void BasicCalculatorBank<T>::reset(const std::uint64_t* mask) {
+    forEachSelected(size(), mask, [&](std::size_t begin, std::size_t count) {
+        fill(&values[begin], T(0), count);
+        fill(&operands[begin], T(0), count);
+        fill(&operations[begin], Operation::Reset, count);
+    });
+}
+
+/**
+ * @brief Adds a separate operand to each selected calculator
+ * @param addends addends[i] is added to calculator i
+ * @param mask Selection bitmask, or null for all calculators
+ * Runs on the MathUtils batch kernels
+ */
+template <typename T>
+void BasicCalculatorBank<T>::addEach(const T* addends, const std::uint64_t* mask) {
+    forEachSelected(size(), mask, [&](std::size_t begin, std::size_t count) {
+        Utils::MathUtils::add(&values[begin], addends + begin, count);
+        copy(&operands[begin], addends + begin, count);
+        fill(&operations[begin], Operation::Add, count);
+    });
+}
+
+template <typename T>
+void BasicCalculatorBank<T>::subtractEach(const T* subtrahends, const std::uint64_t* mask) {
+    forEachSelected(size(), mask, [&](std::size_t begin, std::size_t count) {
+        Utils::MathUtils::subtract(&values[begin], subtrahends + begin, count);
+        copy(&operands[begin], subtrahends + begin, count);
+        fill(&operations[begin], Operation::Subtract, count);
+    });
+}
+
+template <typename T>
+void BasicCalculatorBank<T>::multiplyEach(const T* factors, const std::uint64_t* mask) {
+    forEachSelected(size(), mask, [&](std::size_t begin, std::size_t count) {
+        Utils::MathUtils::multiply(&values[begin], factors + begin, count);
+        copy(&operands[begin], factors + begin, count);
+        fill(&operations[begin], Operation::Multiply, count);
+    });
+}
+
+/**
+ * @brief Divides each selected calculator by its own divisor
+ * @param divisors divisors[i] divides calculator i
+ * @param mask Selection bitmask, or null for all calculators
+ * Zero divisors are blended out rather than branched on: those calculators
+ * divide by 1, keep their old value and record a division error
+ */
+template <typename T>
+void BasicCalculatorBank<T>::divideEach(const T* divisors, const std::uint64_t* mask) {
+    forEachSelected(size(), mask, [&](std::size_t begin, std::size_t count) {
+        T* v = &values[begin];
+        const T* d = divisors + begin;
+        Operation* ops = &operations[begin];
+        std::size_t errors = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            const bool zero = d[i] == 0;
+            const T quotient = v[i] / (zero ? T(1) : d[i]);
+            v[i] = zero ? v[i] : quotient;
+            ops[i] = zero ? Operation::DivisionError : Operation::Divide;
+            errors += zero;
+        }
+        divisionErrors += errors;
+        copy(&operands[begin], d, count);
+    });
+}
+
+template <typename T>
+void BasicCalculatorBank<T>::parityMasks(std::uint64_t* even, std::uint64_t* odd) const {
+    Utils::MathUtils::parityMasks(values.data(), values.size(), even, odd);
+}
+
+template <typename T>
+void BasicCalculatorBank<T>::signMasks(std::uint64_t* positive, std::uint64_t* zero, std::uint64_t* negative) const {
+    Utils::MathUtils::signMasks(values.data(), values.size(), positive, zero, negative);
+}
+
+/**
+ * @brief Sets one calculator without applying an operation
+ * @param index The calculator
+ * @param value Its new value
+ * @param operation The operation to report as its last one
+ * @param operand The operand to report with it
+ */
+template <typename T>
+void BasicCalculatorBank<T>::restore(std::size_t index, T value, Operation operation, T operand) {
+    values[index] = value;
+    operations[index] = operation;
+    operands[index] = operand;
+}
+
+/**
+ * @brief Replaces every calculator in one pass per array
+ * @param count Number of calculators afterwards
+ * @param newValues Their values
+ * @param newOperations Their last operations
+ * @param newOperands The operands of those operations
+ * @param errorCount The bank's division error count
+ */
+template <typename T>
+void BasicCalculatorBank<T>::assign(std::size_t count, const T* newValues, const Operation* newOperations,
+                                    const T* newOperands, std::size_t errorCount) {
+    values.assign(newValues, newValues + count);
+    operations.assign(newOperations, newOperations + count);
+    operands.assign(newOperands, newOperands + count);
+    divisionErrors = errorCount;
+}
+
+template <typename T>
+T BasicCalculatorBank<T>::getValue(std::size_t index) const {
+    return values[index];
+}
+
+template <typename T>
+const T* BasicCalculatorBank<T>::getValues() const {
+    return values.data();
+}
+
+template <typename T>
+Operation BasicCalculatorBank<T>::getOperation(std::size_t index) const {
+    return operations[index];
+}
+
+template <typename T>
+T BasicCalculatorBank<T>::getOperand(std::size_t index) const {
+    return operands[index];
+}
+
+template <typename T>
+const Operation* BasicCalculatorBank<T>::getOperations() const {
+    return operations.data();
+}
+
+template <typename T>
+const T* BasicCalculatorBank<T>::getOperands() const {
+    return operands.data();
+}
+
+/**
+ * @brief Describes the last operation of one calculator
+ * @param index The calculator
+ * @return The same text Calculator::getLastOperation would give
+ */
+template <typename T>
+std::string BasicCalculatorBank<T>::getLastOperation(std::size_t index) const {
+    return describeOperation(operations[index], operands[index]);
+}
+
+template <typename T>
+std::size_t BasicCalculatorBank<T>::getDivisionErrorCount() const {
+    return divisionErrors;
+}
+
+template class BasicCalculatorBank<double>;
+template class BasicCalculatorBank<float>;
+
+/**
+ * @brief Creates a bank whose element type is chosen at runtime
+ * @param precision Double or Float
+ * @param count Number of calculators
+ * @param initialValue Starting value of each one, rounded to the precision
+ * @param resource Supplies the arrays
+ * @return The bank, as a CalculatorBank or a FloatCalculatorBank
+ */
+AnyCalculatorBank makeCalculatorBank(Utils::Precision precision, std::size_t count, double initialValue,
+                                     std::pmr::memory_resource* resource) {
+    switch (precision) {
+    case Utils::Precision::Double:
+        return AnyCalculatorBank(std::in_place_type<CalculatorBank>, count, initialValue, resource);
+    case Utils::Precision::Float:
+        return AnyCalculatorBank(std::in_place_type<FloatCalculatorBank>, count, static_cast<float>(initialValue),
+                                 resource);
+    default:
+        throw std::invalid_argument("CalculatorBank supports double and float precision only");
+    }
+}
@@ -0,0 +1,182 @@
+#include "ChainScheduler.h"
+#include <stdexcept>
+#include <utility>
+
+Chain& Chain::operator=(Chain&& other) noexcept {
+    if (this != &other) {
+        if (handle) {
+            handle.destroy();
+        }
+        handle = other.handle;
+        other.handle = nullptr;
+    }
+    return *this;
+}
+
+Chain::~Chain() {
+    if (handle) {
+        handle.destroy();
+    }
+}
+
+/**
+ * @brief Parks the awaiting chain until the scheduler runs this step's batch
+ * @param handle The chain awaiting the step
+ */
+void ChainStep::await_suspend(std::coroutine_handle<> handle) {
+    waiter = handle;
+    scheduler->steps.push_back(this);
+}
+
+/**
+ * @brief Hands the step's result to the resumed chain
+ * @return The result of lhs op rhs
+ * @throws std::runtime_error if the step divided by zero
+ */
+double ChainStep::await_resume() const {
+    if (operation == Operation::Divide && rhs == 0) {
+        throw std::runtime_error("Division by zero error");
+    }
+    return result;
+}
+
+/**
+ * @brief Provides the input's value
+ * @param v The value
+ * Makes the chain awaiting this input runnable in the scheduler's current or next run()
+ */
+void ChainInput::set(double v) {
+    value = v;
+    ready = true;
+    if (waiter) {
+        scheduler->runnable.push_back(waiter);
+        waiter = nullptr;
+    }
+}
+
+ChainScheduler::~ChainScheduler() {
+    for (std::size_t i = 0; i < chains.size(); ++i) {
+        chains[i].destroy();
+    }
+}
+
+/**
+ * @brief Takes ownership of a chain and queues it to start in the next run()
+ * @param chain A chain that has not been spawned before
+ */
+void ChainScheduler::spawn(Chain chain) {
+    if (!chain.handle) {
+        throw std::invalid_argument("Chain has no coroutine");
+    }
+    chains.push_back(chain.handle);
+    runnable.push_back(chain.handle);
+    chain.handle = nullptr;
+}
+
+/**
+ * @brief Alternates between resuming runnable chains and batch-executing their steps
+ * @return The number of chains that have not finished (all waiting on inputs)
+ */
+std::size_t ChainScheduler::run() {
+    for (;;) {
+        while (!runnable.empty()) {
+            std::coroutine_handle<> next = runnable.front();
+            runnable.pop_front();
+            next.resume();
+        }
+        if (steps.empty()) {
+            break;
+        }
+        executeSteps();
+    }
+
+    std::exception_ptr error = collectFinished();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return chains.size();
+}
+
+/**
+ * @brief Runs all suspended steps, grouped by operation, and makes their chains runnable
+ */
+void ChainScheduler::executeSteps() {
+    static const Operation batched[] = {Operation::Add, Operation::Subtract, Operation::Multiply, Operation::Divide};
+
+    const std::size_t count = steps.size();
+    if (grouped.size() < count) {
+        grouped.resize(count);
+        lhs.resize(count);
+        rhs.resize(count);
+        out.resize(count);
+    }
+
+    for (Operation operation : batched) {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            ChainStep* step = steps[i];
+            if (step->operation == operation) {
+                grouped[n] = step;
+                lhs[n] = step->lhs;
+                // A zero divisor makes await_resume throw; keep it out of the kernel
+                rhs[n] = operation == Operation::Divide && step->rhs == 0 ? 1.0 : step->rhs;
+                ++n;
+            }
+        }
+        if (n == 0) {
+            continue;
+        }
+
+        switch (operation) {
+        case Operation::Add:
+            Utils::MathUtils::add(lhs.data(), rhs.data(), out.data(), n);
+            break;
+        case Operation::Subtract:
+            Utils::MathUtils::subtract(lhs.data(), rhs.data(), out.data(), n);
+            break;
+        case Operation::Multiply:
+            Utils::MathUtils::multiply(lhs.data(), rhs.data(), out.data(), n);
+            break;
+        default:
+            Utils::MathUtils::divide(lhs.data(), rhs.data(), out.data(), n);
+            break;
+        }
+        ++batches;
+        for (std::size_t i = 0; i < n; ++i) {
+            grouped[i]->result = out[i];
+        }
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        ChainStep* step = steps[i];
+        if (step->operation == Operation::Power) {
+            // Exponents differ between chains, so powers are not one kernel call
+            step->result = Utils::MathUtils::power(step->lhs, static_cast<int>(step->rhs));
+        }
+        runnable.push_back(step->waiter);
+    }
+    // Resumed chains queue their next steps here
+    steps.clear();
+}
+
+/**
+ * @brief Destroys finished chains
+ * @return The first exception that escaped one of them, if any
+ */
+std::exception_ptr ChainScheduler::collectFinished() {
+    std::exception_ptr first;
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < chains.size(); ++i) {
+        std::coroutine_handle<Chain::promise_type> chain = chains[i];
+        if (!chain.done()) {
+            chains[kept++] = chain;
+            continue;
+        }
+        if (!first && chain.promise().error) {
+            first = chain.promise().error;
+        }
+        chain.destroy();
+    }
+    chains.resize(kept);
+    return first;
+}
@@ -0,0 +1,90 @@
+#include "ConcurrentCalculator.h"
+#include "MathUtils.h"
+#include <thread>
+
+namespace {
+    // Hands out shard slots to threads in the order they first touch any accumulator
+    std::atomic<std::size_t> nextThreadSlot(0);
+
+    std::size_t threadSlot() {
+        thread_local const std::size_t slot = nextThreadSlot.fetch_add(1, std::memory_order_relaxed);
+        return slot;
+    }
+
+    /**
+     * @brief Atomically adds a value to an atomic double
+     * @param target The shard value to update
+     * @param value The value to add
+     * Uses a compare-and-swap loop since fetch_add on double needs C++20
+     */
+    void atomicAdd(std::atomic<double>& target, double value) {
+        double current = target.load(std::memory_order_relaxed);
+        while (!target.compare_exchange_weak(current, Utils::MathUtils::add(current, value),
+                                             std::memory_order_relaxed)) {
+        }
+    }
+}
+
+/**
+ * @brief Constructor - Creates an accumulator with zeroed shards
+ * @param shardCount Number of shards; 0 picks one per hardware thread
+ */
+ConcurrentCalculator::ConcurrentCalculator(std::size_t shardCount)
+    : shards(shardCount != 0 ? shardCount
+                             : (std::thread::hardware_concurrency() != 0 ? std::thread::hardware_concurrency() : 1)) {
+    reset();
+}
+
+/**
+ * @brief Picks the calling thread's shard
+ * @return The shard this thread accumulates into
+ * Threads are assigned round-robin, so up to getShardCount() threads never contend
+ */
+ConcurrentCalculator::Shard& ConcurrentCalculator::localShard() {
+    return shards[threadSlot() % shards.size()];
+}
+
+/**
+ * @brief Adds a value to the shared result
+ * @param value The value to add
+ */
+void ConcurrentCalculator::add(double value) {
+    atomicAdd(localShard().value, value);
+}
+
+/**
+ * @brief Subtracts a value from the shared result
+ * @param value The value to subtract
+ */
+void ConcurrentCalculator::subtract(double value) {
+    atomicAdd(localShard().value, -value);
+}
+
+/**
+ * @brief Gets the current result by combining all shards
+ * @return The sum of the shard values, added in shard order
+ */
+double ConcurrentCalculator::getValue() const {
+    double total = 0.0;
+    for (std::size_t i = 0; i < shards.size(); ++i) {
+        total = Utils::MathUtils::add(total, shards[i].value.load(std::memory_order_acquire));
+    }
+    return total;
+}
+
+/**
+ * @brief Resets every shard to 0.0
+ */
+void ConcurrentCalculator::reset() {
+    for (std::size_t i = 0; i < shards.size(); ++i) {
+        shards[i].value.store(0.0, std::memory_order_release);
+    }
+}
+
+/**
+ * @brief Gets the number of shards
+ * @return How many independent sub-accumulators this calculator uses
+ */
+std::size_t ConcurrentCalculator::getShardCount() const {
+    return shards.size();
+}
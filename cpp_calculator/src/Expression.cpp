@@ -0,0 +1,584 @@
+#include "Expression.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+
+namespace Expr {
+    namespace {
+        // Rows evaluated together by the batch evaluator
+        const std::size_t blockSize = 256;
+
+        // Parenthesis/unary nesting allowed before the parser gives up
+        const int maxNesting = 256;
+
+        enum class TokenKind {
+            Number,
+            Identifier,
+            Operator,
+            LeftParen,
+            RightParen,
+            End
+        };
+
+        struct Token {
+            TokenKind kind;
+            char symbol;
+            double number;
+            std::string text;
+            std::size_t position;
+        };
+
+        std::runtime_error syntaxError(const std::string& message, std::size_t position) {
+            return std::runtime_error("Syntax error at position " + std::to_string(position) + ": " + message);
+        }
+
+        /**
+         * @brief Splits an infix formula into numbers, identifiers, operators and parentheses
+         * @param source The formula text
+         * @return The tokens, always terminated by an End token
+         */
+        std::vector<Token> tokenize(const std::string& source) {
+            std::vector<Token> tokens;
+            std::size_t i = 0;
+            while (i < source.size()) {
+                const unsigned char c = static_cast<unsigned char>(source[i]);
+                if (std::isspace(c)) {
+                    ++i;
+                    continue;
+                }
+
+                Token token = {TokenKind::End, '\0', 0.0, std::string(), i};
+                if (std::isdigit(c) || c == '.') {
+                    const char* begin = source.c_str() + i;
+                    char* end = nullptr;
+                    token.kind = TokenKind::Number;
+                    token.number = std::strtod(begin, &end);
+                    if (end == begin) {
+                        throw syntaxError("malformed number", i);
+                    }
+                    i += static_cast<std::size_t>(end - begin);
+                } else if (std::isalpha(c) || c == '_') {
+                    const std::size_t start = i;
+                    while (i < source.size() &&
+                           (std::isalnum(static_cast<unsigned char>(source[i])) || source[i] == '_')) {
+                        ++i;
+                    }
+                    token.kind = TokenKind::Identifier;
+                    token.text = source.substr(start, i - start);
+                } else if (c == '+' || c == '-' || c == '*' || c == '/' || c == '^') {
+                    token.kind = TokenKind::Operator;
+                    token.symbol = static_cast<char>(c);
+                    ++i;
+                } else if (c == '(') {
+                    token.kind = TokenKind::LeftParen;
+                    ++i;
+                } else if (c == ')') {
+                    token.kind = TokenKind::RightParen;
+                    ++i;
+                } else {
+                    throw syntaxError(std::string("unexpected character '") + source[i] + "'", i);
+                }
+                tokens.push_back(token);
+            }
+
+            Token end = {TokenKind::End, '\0', 0.0, std::string(), source.size()};
+            tokens.push_back(end);
+            return tokens;
+        }
+
+        /**
+         * @brief Converts an evaluated exponent to the int MathUtils::power expects
+         * @param value The exponent produced by the expression
+         * @param exponent Receives the converted exponent
+         * @return false if value is not an integer representable as int
+         */
+        bool toExponent(double value, int& exponent) {
+            if (!(value >= INT_MIN && value <= INT_MAX) || std::trunc(value) != value) {
+                return false;
+            }
+            exponent = static_cast<int>(value);
+            return true;
+        }
+
+        /**
+         * @brief Applies a binary opcode to two scalars
+         * @return The checked result; only Divide and Power can fail
+         */
+        Utils::MathResult applyBinary(OpCode op, double a, double b) {
+            switch (op) {
+            case OpCode::Add:
+                return Utils::MathResult{Utils::MathUtils::add(a, b), Utils::MathStatus::Ok};
+            case OpCode::Subtract:
+                return Utils::MathResult{Utils::MathUtils::subtract(a, b), Utils::MathStatus::Ok};
+            case OpCode::Multiply:
+                return Utils::MathResult{Utils::MathUtils::multiply(a, b), Utils::MathStatus::Ok};
+            case OpCode::Divide:
+                return Utils::MathUtils::tryDivide(a, b);
+            default: {
+                int exponent = 0;
+                if (!toExponent(b, exponent)) {
+                    return Utils::MathResult{0.0, Utils::MathStatus::InvalidExponent};
+                }
+                return Utils::MathResult{Utils::MathUtils::power(a, exponent), Utils::MathStatus::Ok};
+            }
+            }
+        }
+
+        void throwOnError(Utils::MathStatus status) {
+            if (status == Utils::MathStatus::DivisionByZero) {
+                throw std::runtime_error("Division by zero error");
+            }
+            if (status == Utils::MathStatus::InvalidExponent) {
+                throw std::runtime_error("Exponent must be an integer");
+            }
+        }
+    }
+
+    /**
+     * Recursive-descent parser that emits bytecode as it goes:
+     *   expression := term (('+' | '-') term)*
+     *   term       := unary (('*' | '/') unary)*
+     *   unary      := ('-' | '+') unary | power
+     *   power      := primary ('^' unary)?        (right-associative)
+     *   primary    := number | identifier | '(' expression ')'
+     * Operations on constant operands are folded at compile time.
+     */
+    class CompiledExpression::Compiler {
+    public:
+        Compiler(const std::string& source, CompiledExpression& target, bool fixedVariables)
+            : tokens(tokenize(source)), current(0), nesting(0), result(target), allowNewVariables(!fixedVariables) {}
+
+        void compile() {
+            parseExpression();
+            if (peek().kind != TokenKind::End) {
+                throw syntaxError("unexpected trailing input", peek().position);
+            }
+            result.depth = measureDepth();
+            if (result.depth > maxStackDepth) {
+                throw std::runtime_error("Expression needs too deep an evaluation stack");
+            }
+        }
+
+    private:
+        std::vector<Token> tokens;
+        std::size_t current;
+        int nesting;
+        CompiledExpression& result;
+        bool allowNewVariables;
+
+        const Token& peek() const {
+            return tokens[current];
+        }
+
+        bool acceptOperator(char symbol) {
+            if (peek().kind == TokenKind::Operator && peek().symbol == symbol) {
+                ++current;
+                return true;
+            }
+            return false;
+        }
+
+        void enter() {
+            if (++nesting > maxNesting) {
+                throw syntaxError("expression is nested too deeply", peek().position);
+            }
+        }
+
+        void parseExpression() {
+            parseTerm();
+            for (;;) {
+                if (acceptOperator('+')) {
+                    parseTerm();
+                    emitBinary(OpCode::Add);
+                } else if (acceptOperator('-')) {
+                    parseTerm();
+                    emitBinary(OpCode::Subtract);
+                } else {
+                    return;
+                }
+            }
+        }
+
+        void parseTerm() {
+            parseUnary();
+            for (;;) {
+                if (acceptOperator('*')) {
+                    parseUnary();
+                    emitBinary(OpCode::Multiply);
+                } else if (acceptOperator('/')) {
+                    parseUnary();
+                    emitBinary(OpCode::Divide);
+                } else {
+                    return;
+                }
+            }
+        }
+
+        void parseUnary() {
+            enter();
+            if (acceptOperator('-')) {
+                parseUnary();
+                emitNegate();
+            } else if (acceptOperator('+')) {
+                parseUnary();
+            } else {
+                parsePower();
+            }
+            --nesting;
+        }
+
+        void parsePower() {
+            parsePrimary();
+            if (acceptOperator('^')) {
+                parseUnary();
+                emitBinary(OpCode::Power);
+            }
+        }
+
+        void parsePrimary() {
+            const Token& token = peek();
+            switch (token.kind) {
+            case TokenKind::Number:
+                ++current;
+                emitConstant(token.number);
+                return;
+            case TokenKind::Identifier:
+                ++current;
+                emitVariable(token);
+                return;
+            case TokenKind::LeftParen:
+                ++current;
+                enter();
+                parseExpression();
+                --nesting;
+                if (peek().kind != TokenKind::RightParen) {
+                    throw syntaxError("expected ')'", peek().position);
+                }
+                ++current;
+                return;
+            case TokenKind::End:
+                throw syntaxError("unexpected end of expression", token.position);
+            default:
+                throw syntaxError("expected a number, variable or '('", token.position);
+            }
+        }
+
+        void emit(OpCode op, std::uint32_t operand) {
+            Instruction instruction = {op, operand};
+            result.code.push_back(instruction);
+        }
+
+        void emitConstant(double value) {
+            emit(OpCode::PushConstant, static_cast<std::uint32_t>(result.constantPool.size()));
+            result.constantPool.push_back(value);
+        }
+
+        void emitVariable(const Token& token) {
+            int index = result.variableIndex(token.text);
+            if (index < 0) {
+                if (!allowNewVariables) {
+                    throw syntaxError("unknown variable '" + token.text + "'", token.position);
+                }
+                index = static_cast<int>(result.variableNames.size());
+                result.variableNames.push_back(token.text);
+            }
+            emit(OpCode::PushVariable, static_cast<std::uint32_t>(index));
+        }
+
+        bool endsWithConstants(std::size_t count) const {
+            if (result.code.size() < count) {
+                return false;
+            }
+            for (std::size_t i = result.code.size() - count; i < result.code.size(); ++i) {
+                if (result.code[i].op != OpCode::PushConstant) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // A complete operand that ends in PushConstant is exactly that push, and
+        // folded constants are always the newest entries of the pool.
+        void emitBinary(OpCode op) {
+            if (endsWithConstants(2)) {
+                const std::size_t last = result.constantPool.size() - 1;
+                const Utils::MathResult folded =
+                    applyBinary(op, result.constantPool[last - 1], result.constantPool[last]);
+                // Errors are left for evaluation time so they surface where expected
+                if (folded.ok()) {
+                    result.code.resize(result.code.size() - 2);
+                    result.constantPool.resize(last - 1);
+                    emitConstant(folded.value);
+                    return;
+                }
+            }
+            emit(op, 0);
+        }
+
+        void emitNegate() {
+            if (endsWithConstants(1)) {
+                double& constant = result.constantPool.back();
+                constant = -constant;
+                return;
+            }
+            emit(OpCode::Negate, 0);
+        }
+
+        std::size_t measureDepth() const {
+            std::size_t size = 0;
+            std::size_t deepest = 0;
+            for (std::size_t i = 0; i < result.code.size(); ++i) {
+                const OpCode op = result.code[i].op;
+                if (op == OpCode::PushConstant || op == OpCode::PushVariable) {
+                    deepest = std::max(deepest, ++size);
+                } else if (op != OpCode::Negate) {
+                    --size;
+                }
+            }
+            return deepest;
+        }
+    };
+
+    CompiledExpression::CompiledExpression() : depth(0) {}
+
+    /**
+     * @brief Compiles a formula, discovering its variables
+     * @param source Infix formula using numbers, identifiers, + - * / ^ and parentheses
+     * @return The compiled expression; variables are numbered by first appearance
+     */
+    CompiledExpression CompiledExpression::compile(const std::string& source) {
+        CompiledExpression expression;
+        Compiler(source, expression, false).compile();
+        return expression;
+    }
+
+    /**
+     * @brief Compiles a formula against a fixed list of variables
+     * @param source Infix formula using numbers, identifiers, + - * / ^ and parentheses
+     * @param variables The allowed variable names; their order defines the binding order
+     * @return The compiled expression; unknown identifiers are a syntax error
+     */
+    CompiledExpression CompiledExpression::compile(const std::string& source,
+                                                   const std::vector<std::string>& variables) {
+        CompiledExpression expression;
+        expression.variableNames = variables;
+        Compiler(source, expression, true).compile();
+        return expression;
+    }
+
+    /**
+     * @brief Evaluates the bytecode without throwing
+     * @param variables Values of the variables, indexed like variables()
+     * @return The value, or a DivisionByZero/InvalidExponent status
+     */
+    Utils::MathResult CompiledExpression::tryEvaluate(const double* variables) const noexcept {
+        double stack[maxStackDepth];
+        std::size_t top = 0;
+        for (std::size_t i = 0; i < code.size(); ++i) {
+            const Instruction& instruction = code[i];
+            switch (instruction.op) {
+            case OpCode::PushConstant:
+                stack[top++] = constantPool[instruction.operand];
+                break;
+            case OpCode::PushVariable:
+                stack[top++] = variables[instruction.operand];
+                break;
+            case OpCode::Negate:
+                stack[top - 1] = -stack[top - 1];
+                break;
+            default: {
+                --top;
+                const Utils::MathResult step = applyBinary(instruction.op, stack[top - 1], stack[top]);
+                if (!step.ok()) {
+                    return step;
+                }
+                stack[top - 1] = step.value;
+                break;
+            }
+            }
+        }
+        return Utils::MathResult{stack[0], Utils::MathStatus::Ok};
+    }
+
+    /**
+     * @brief Evaluates the expression for one set of variable bindings
+     * @param variables Values of the variables, indexed like variables()
+     * @return The value of the expression
+     */
+    double CompiledExpression::evaluate(const double* variables) const {
+        const Utils::MathResult result = tryEvaluate(variables);
+        throwOnError(result.status);
+        return result.value;
+    }
+
+    double CompiledExpression::evaluate(const std::vector<double>& variables) const {
+        if (variables.size() < variableNames.size()) {
+            throw std::runtime_error("Not enough variable bindings for expression");
+        }
+        return evaluate(variables.data());
+    }
+
+    /**
+     * @brief Evaluates the expression for many rows of bindings
+     * @param columns columns[i] holds n values of variable i
+     * @param out Receives n results
+     * @param n Number of rows
+     * Each instruction is applied to a whole block of rows, so interpretive
+     * dispatch is paid once per block rather than once per row. On error the
+     * contents of out are unspecified.
+     */
+    void CompiledExpression::evaluate(const double* const* columns, double* out, std::size_t n) const {
+        std::vector<double> scratch(depth * blockSize);
+        const double* stack[maxStackDepth];
+
+        for (std::size_t row = 0; row < n; row += blockSize) {
+            const std::size_t count = std::min(blockSize, n - row);
+            std::size_t top = 0;
+            for (std::size_t i = 0; i < code.size(); ++i) {
+                const Instruction& instruction = code[i];
+                if (instruction.op == OpCode::PushVariable) {
+                    // Variables are read straight from the caller's columns
+                    stack[top++] = columns[instruction.operand] + row;
+                    continue;
+                }
+
+                if (instruction.op == OpCode::PushConstant) {
+                    double* slot = &scratch[top * blockSize];
+                    std::fill(slot, slot + count, constantPool[instruction.operand]);
+                    stack[top++] = slot;
+                    continue;
+                }
+
+                if (instruction.op == OpCode::Negate) {
+                    double* slot = &scratch[(top - 1) * blockSize];
+                    const double* a = stack[top - 1];
+                    for (std::size_t j = 0; j < count; ++j) {
+                        slot[j] = -a[j];
+                    }
+                    stack[top - 1] = slot;
+                    continue;
+                }
+
+                --top;
+                double* slot = &scratch[(top - 1) * blockSize];
+                const double* a = stack[top - 1];
+                const double* b = stack[top];
+                switch (instruction.op) {
+                case OpCode::Add:
+                    Utils::MathUtils::add(a, b, slot, count);
+                    break;
+                case OpCode::Subtract:
+                    Utils::MathUtils::subtract(a, b, slot, count);
+                    break;
+                case OpCode::Multiply:
+                    Utils::MathUtils::multiply(a, b, slot, count);
+                    break;
+                case OpCode::Divide:
+                    Utils::MathUtils::divide(a, b, slot, count);
+                    break;
+                default:
+                    for (std::size_t j = 0; j < count; ++j) {
+                        const Utils::MathResult step = applyBinary(OpCode::Power, a[j], b[j]);
+                        throwOnError(step.status);
+                        slot[j] = step.value;
+                    }
+                    break;
+                }
+                stack[top - 1] = slot;
+            }
+            std::copy(stack[0], stack[0] + count, out + row);
+        }
+    }
+
+    const std::vector<std::string>& CompiledExpression::variables() const {
+        return variableNames;
+    }
+
+    int CompiledExpression::variableIndex(const std::string& name) const {
+        for (std::size_t i = 0; i < variableNames.size(); ++i) {
+            if (variableNames[i] == name) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    const std::vector<Instruction>& CompiledExpression::instructions() const {
+        return code;
+    }
+
+    const std::vector<double>& CompiledExpression::constants() const {
+        return constantPool;
+    }
+
+    std::size_t CompiledExpression::stackDepth() const {
+        return depth;
+    }
+
+    bool CachedExpression::Key::operator==(const Key& other) const {
+        return std::equal(bits, bits + maxCachedVariables, other.bits);
+    }
+
+    std::uint64_t CachedExpression::Key::hash() const {
+        std::uint64_t h = 0;
+        for (std::size_t i = 0; i < maxCachedVariables; ++i) {
+            h = Utils::mixHash(h ^ bits[i]);
+        }
+        return h;
+    }
+
+    /**
+     * @brief Constructor - Wraps a compiled expression with an empty cache
+     * @param expression The expression to evaluate
+     * @param capacity Most variable bindings to remember
+     * @param shards Number of independently locked cache shards
+     */
+    CachedExpression::CachedExpression(CompiledExpression expression, std::size_t capacity, std::size_t shards)
+        : compiled(std::move(expression)), cache(capacity, shards) {}
+
+    /**
+     * @brief Evaluates without throwing, reusing a cached result for the same bindings
+     * @param variables Values of the variables, indexed like expression().variables()
+     * @return The value, or a DivisionByZero/InvalidExponent status
+     */
+    Utils::MathResult CachedExpression::tryEvaluate(const double* variables) const {
+        const std::size_t count = compiled.variables().size();
+        if (count > maxCachedVariables) {
+            return compiled.tryEvaluate(variables);
+        }
+        Key key = {};
+        for (std::size_t i = 0; i < count; ++i) {
+            key.bits[i] = Utils::doubleBits(variables[i]);
+        }
+        return cache.getOrCompute(key, [this, variables]() { return compiled.tryEvaluate(variables); });
+    }
+
+    double CachedExpression::evaluate(const double* variables) const {
+        const Utils::MathResult result = tryEvaluate(variables);
+        throwOnError(result.status);
+        return result.value;
+    }
+
+    double CachedExpression::evaluate(const std::vector<double>& variables) const {
+        if (variables.size() < compiled.variables().size()) {
+            throw std::runtime_error("Not enough variable bindings for expression");
+        }
+        return evaluate(variables.data());
+    }
+
+    const CompiledExpression& CachedExpression::expression() const {
+        return compiled;
+    }
+
+    Utils::CacheStats CachedExpression::getStats() const {
+        return cache.getStats();
+    }
+
+    void CachedExpression::clearCache() {
+        cache.clear();
+    }
+}
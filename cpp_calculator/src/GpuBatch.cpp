@@ -0,0 +1,128 @@
+#include "GpuBatch.h"
+#include "GpuDevice.h"
+#include <stdexcept>
+
+namespace Utils {
+#if !defined(CALCULATOR_CUDA)
+    // Built without the CUDA backend: there is never a device
+    namespace Gpu {
+        bool available() {
+            return false;
+        }
+
+        const char* name() {
+            return "cpu";
+        }
+
+        bool run(Job&) {
+            return false;
+        }
+    }
+#endif
+
+    namespace {
+        Gpu::Job makeJob(Gpu::Operation operation, std::size_t n, const GpuOptions& options) {
+            Gpu::Job job = {};
+            job.operation = operation;
+            job.n = n;
+            // Whole mask words per chunk
+            job.chunkElements = (options.chunkElements + 63) / 64 * 64;
+            return job;
+        }
+
+        /**
+         * @brief Runs a job on the device when that is worthwhile
+         * @param job The job
+         * @param options Supplies the size threshold
+         * @return True if the device ran it; false means the caller uses MathUtils
+         */
+        bool offload(Gpu::Job& job, const GpuOptions& options) {
+            if (job.n == 0 || job.n < options.minimumElements || !Gpu::available()) {
+                return false;
+            }
+            return Gpu::run(job);
+        }
+
+        bool offloadBinary(Gpu::Operation operation, const double* a, const double* b, double* out, std::size_t n,
+                           const GpuOptions& options) {
+            Gpu::Job job = makeJob(operation, n, options);
+            job.a = a;
+            job.b = b;
+            job.out = out;
+            if (!offload(job, options)) {
+                return false;
+            }
+            if (job.zeroDivisor) {
+                throw std::runtime_error("Division by zero error");
+            }
+            return true;
+        }
+    }
+
+    bool GpuBatch::isAvailable() {
+        return Gpu::available();
+    }
+
+    const char* GpuBatch::deviceName() {
+        return Gpu::available() ? Gpu::name() : "cpu";
+    }
+
+    void GpuBatch::add(const double* a, const double* b, double* out, std::size_t n, const GpuOptions& options) {
+        if (!offloadBinary(Gpu::Operation::Add, a, b, out, n, options)) {
+            MathUtils::add(a, b, out, n);
+        }
+    }
+
+    void GpuBatch::subtract(const double* a, const double* b, double* out, std::size_t n,
+                            const GpuOptions& options) {
+        if (!offloadBinary(Gpu::Operation::Subtract, a, b, out, n, options)) {
+            MathUtils::subtract(a, b, out, n);
+        }
+    }
+
+    void GpuBatch::multiply(const double* a, const double* b, double* out, std::size_t n,
+                            const GpuOptions& options) {
+        if (!offloadBinary(Gpu::Operation::Multiply, a, b, out, n, options)) {
+            MathUtils::multiply(a, b, out, n);
+        }
+    }
+
+    void GpuBatch::divide(const double* a, const double* b, double* out, std::size_t n, const GpuOptions& options) {
+        if (!offloadBinary(Gpu::Operation::Divide, a, b, out, n, options)) {
+            MathUtils::divide(a, b, out, n);
+        }
+    }
+
+    void GpuBatch::power(const double* base, int exponent, double* out, std::size_t n, const GpuOptions& options) {
+        Gpu::Job job = makeJob(Gpu::Operation::Power, n, options);
+        job.a = base;
+        job.exponent = exponent;
+        job.out = out;
+        if (!offload(job, options)) {
+            MathUtils::power(base, exponent, out, n);
+        }
+    }
+
+    void GpuBatch::parityMasks(const double* values, std::size_t n, std::uint64_t* even, std::uint64_t* odd,
+                               const GpuOptions& options) {
+        Gpu::Job job = makeJob(Gpu::Operation::ParityMasks, n, options);
+        job.a = values;
+        job.masks[0] = even;
+        job.masks[1] = odd;
+        if (!offload(job, options)) {
+            MathUtils::parityMasks(values, n, even, odd);
+        }
+    }
+
+    void GpuBatch::signMasks(const double* values, std::size_t n, std::uint64_t* positive, std::uint64_t* zero,
+                             std::uint64_t* negative, const GpuOptions& options) {
+        Gpu::Job job = makeJob(Gpu::Operation::SignMasks, n, options);
+        job.a = values;
+        job.masks[0] = positive;
+        job.masks[1] = zero;
+        job.masks[2] = negative;
+        if (!offload(job, options)) {
+            MathUtils::signMasks(values, n, positive, zero, negative);
+        }
+    }
+}
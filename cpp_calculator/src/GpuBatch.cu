@@ -0,0 +1,364 @@
+#include "GpuDevice.h"
+#include <cuda_runtime.h>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+// CUDA backend of GpuBatch: element-wise kernels plus the staging pipeline
+// that streams host arrays through them.
+
+namespace Utils {
+    namespace Gpu {
+        namespace {
+            const int streamCount = 2;
+            const int threadsPerBlock = 256;
+
+            void check(cudaError_t status, const char* what) {
+                if (status != cudaSuccess) {
+                    throw std::runtime_error(std::string("CUDA ") + what + ": " + cudaGetErrorString(status));
+                }
+            }
+
+            // The explicit round-to-nearest intrinsics are never contracted or
+            // approximated, whatever math flags nvcc is given, which keeps the
+            // results identical to the CPU kernels
+            template <Operation op>
+            __global__ void binaryKernel(const double* a, const double* b, double* out, std::size_t n,
+                                         int* zeroDivisor) {
+                const std::size_t i = blockIdx.x * static_cast<std::size_t>(blockDim.x) + threadIdx.x;
+                if (i >= n) {
+                    return;
+                }
+                if (op == Operation::Add) {
+                    out[i] = __dadd_rn(a[i], b[i]);
+                } else if (op == Operation::Subtract) {
+                    out[i] = __dsub_rn(a[i], b[i]);
+                } else if (op == Operation::Multiply) {
+                    out[i] = __dmul_rn(a[i], b[i]);
+                } else {
+                    if (b[i] == 0) {
+                        *zeroDivisor = 1;
+                    }
+                    out[i] = __ddiv_rn(a[i], b[i]);
+                }
+            }
+
+            // The square-and-multiply sequence of MathUtils::power, per element
+            __global__ void powerKernel(const double* base, unsigned int magnitude, bool reciprocal, double* out,
+                                        std::size_t n) {
+                const std::size_t i = blockIdx.x * static_cast<std::size_t>(blockDim.x) + threadIdx.x;
+                if (i >= n) {
+                    return;
+                }
+                double square = base[i];
+                double result = 1.0;
+                unsigned int remaining = magnitude;
+                while (remaining != 0) {
+                    if (remaining & 1u) {
+                        result = __dmul_rn(result, square);
+                    }
+                    remaining >>= 1;
+                    if (remaining != 0) {
+                        square = __dmul_rn(square, square);
+                    }
+                }
+                out[i] = reciprocal ? __ddiv_rn(1.0, result) : result;
+            }
+
+            /**
+             * @brief Writes one bit per element for up to three predicates
+             * @param limit Threads to run: n rounded up to a multiple of 64, so
+             *              that whole warps exit together and every 32-bit half
+             *              of a mask word is written
+             * Each warp's ballot is one 32-bit half of a 64-bit mask word; the
+             * halves are stored little-endian, as on every CUDA host.
+             */
+            template <Operation op>
+            __global__ void maskKernel(const double* values, std::size_t n, std::size_t limit, unsigned int* first,
+                                       unsigned int* second, unsigned int* third) {
+                const std::size_t i = blockIdx.x * static_cast<std::size_t>(blockDim.x) + threadIdx.x;
+                if (i >= limit) {
+                    return;
+                }
+                const bool valid = i < n;
+                const double value = valid ? values[i] : 0.0;
+                bool p0;
+                bool p1;
+                bool p2 = false;
+                if (op == Operation::ParityMasks) {
+                    // MathUtils::isEven/isOdd
+                    const double half = trunc(value) * 0.5;
+                    const bool finite = valid && isfinite(value);
+                    p0 = finite && trunc(half) == half;
+                    p1 = finite && trunc(half) != half;
+                } else {
+                    p0 = valid && value > 0;
+                    p1 = valid && value == 0;
+                    p2 = valid && value < 0;
+                }
+                const unsigned int bits0 = __ballot_sync(0xffffffffu, p0);
+                const unsigned int bits1 = __ballot_sync(0xffffffffu, p1);
+                const unsigned int bits2 = __ballot_sync(0xffffffffu, p2);
+                if ((threadIdx.x & 31u) == 0) {
+                    first[i / 32] = bits0;
+                    second[i / 32] = bits1;
+                    if (third != nullptr) {
+                        third[i / 32] = bits2;
+                    }
+                }
+            }
+
+            // Buffers of one stream: pinned host staging and their device copies
+            struct Stream {
+                cudaStream_t stream;
+                double* hostIn[2];
+                double* hostOut;
+                std::uint64_t* hostMasks[3];
+                double* deviceIn[2];
+                double* deviceOut;
+                unsigned int* deviceMasks[3];
+                int* deviceZeroDivisor;
+                // The chunk in flight on this stream, if any
+                bool pending;
+                std::size_t start;
+                std::size_t count;
+            };
+
+            struct Device {
+                bool ready;
+                cudaDeviceProp properties;
+                // Elements each stream's buffers hold
+                std::size_t capacity;
+                Stream streams[streamCount];
+                // One job at a time owns the buffers
+                std::mutex mutex;
+            };
+
+            void releaseBuffers(Stream& s) {
+                for (int k = 0; k < 2; ++k) {
+                    cudaFreeHost(s.hostIn[k]);
+                    cudaFree(s.deviceIn[k]);
+                    s.hostIn[k] = nullptr;
+                    s.deviceIn[k] = nullptr;
+                }
+                cudaFreeHost(s.hostOut);
+                cudaFree(s.deviceOut);
+                s.hostOut = nullptr;
+                s.deviceOut = nullptr;
+                for (int k = 0; k < 3; ++k) {
+                    cudaFreeHost(s.hostMasks[k]);
+                    cudaFree(s.deviceMasks[k]);
+                    s.hostMasks[k] = nullptr;
+                    s.deviceMasks[k] = nullptr;
+                }
+            }
+
+            /**
+             * @brief Makes every stream's buffers hold at least elements values
+             * @return False if pinned or device memory ran out, leaving no buffers
+             */
+            bool reserve(Device& d, std::size_t elements) {
+                if (elements <= d.capacity) {
+                    return true;
+                }
+                const std::size_t bytes = elements * sizeof(double);
+                const std::size_t maskBytes = elements / 64 * sizeof(std::uint64_t);
+                bool ok = true;
+                for (Stream& s : d.streams) {
+                    releaseBuffers(s);
+                    for (int k = 0; k < 2; ++k) {
+                        ok = ok && cudaHostAlloc(&s.hostIn[k], bytes, cudaHostAllocDefault) == cudaSuccess;
+                        ok = ok && cudaMalloc(&s.deviceIn[k], bytes) == cudaSuccess;
+                    }
+                    ok = ok && cudaHostAlloc(&s.hostOut, bytes, cudaHostAllocDefault) == cudaSuccess;
+                    ok = ok && cudaMalloc(&s.deviceOut, bytes) == cudaSuccess;
+                    for (int k = 0; k < 3; ++k) {
+                        ok = ok && cudaHostAlloc(&s.hostMasks[k], maskBytes, cudaHostAllocDefault) == cudaSuccess;
+                        ok = ok && cudaMalloc(&s.deviceMasks[k], maskBytes) == cudaSuccess;
+                    }
+                }
+                if (!ok) {
+                    for (Stream& s : d.streams) {
+                        releaseBuffers(s);
+                    }
+                    d.capacity = 0;
+                    cudaGetLastError(); // clear the allocation error
+                    return false;
+                }
+                d.capacity = elements;
+                return true;
+            }
+
+            Device& device() {
+                static Device d;
+                static std::once_flag initialized;
+                std::call_once(initialized, [] {
+                    d.ready = false;
+                    d.capacity = 0;
+                    std::memset(d.streams, 0, sizeof(d.streams));
+                    int count = 0;
+                    if (cudaGetDeviceCount(&count) != cudaSuccess || count == 0 || cudaSetDevice(0) != cudaSuccess ||
+                        cudaGetDeviceProperties(&d.properties, 0) != cudaSuccess) {
+                        cudaGetLastError();
+                        return;
+                    }
+                    for (Stream& s : d.streams) {
+                        if (cudaStreamCreateWithFlags(&s.stream, cudaStreamNonBlocking) != cudaSuccess ||
+                            cudaMalloc(&s.deviceZeroDivisor, sizeof(int)) != cudaSuccess) {
+                            cudaGetLastError();
+                            return;
+                        }
+                    }
+                    d.ready = true;
+                });
+                return d;
+            }
+
+            bool isMaskJob(const Job& job) {
+                return job.operation == Operation::ParityMasks || job.operation == Operation::SignMasks;
+            }
+
+            void launch(const Job& job, Stream& s, std::size_t count) {
+                const std::size_t threads = isMaskJob(job) ? (count + 63) / 64 * 64 : count;
+                const unsigned int blocks = static_cast<unsigned int>((threads + threadsPerBlock - 1) / threadsPerBlock);
+                switch (job.operation) {
+                case Operation::Add:
+                    binaryKernel<Operation::Add><<<blocks, threadsPerBlock, 0, s.stream>>>(
+                        s.deviceIn[0], s.deviceIn[1], s.deviceOut, count, s.deviceZeroDivisor);
+                    break;
+                case Operation::Subtract:
+                    binaryKernel<Operation::Subtract><<<blocks, threadsPerBlock, 0, s.stream>>>(
+                        s.deviceIn[0], s.deviceIn[1], s.deviceOut, count, s.deviceZeroDivisor);
+                    break;
+                case Operation::Multiply:
+                    binaryKernel<Operation::Multiply><<<blocks, threadsPerBlock, 0, s.stream>>>(
+                        s.deviceIn[0], s.deviceIn[1], s.deviceOut, count, s.deviceZeroDivisor);
+                    break;
+                case Operation::Divide:
+                    binaryKernel<Operation::Divide><<<blocks, threadsPerBlock, 0, s.stream>>>(
+                        s.deviceIn[0], s.deviceIn[1], s.deviceOut, count, s.deviceZeroDivisor);
+                    break;
+                case Operation::Power: {
+                    const unsigned int magnitude = job.exponent < 0 ? 0u - static_cast<unsigned int>(job.exponent)
+                                                                    : static_cast<unsigned int>(job.exponent);
+                    powerKernel<<<blocks, threadsPerBlock, 0, s.stream>>>(s.deviceIn[0], magnitude, job.exponent < 0,
+                                                                          s.deviceOut, count);
+                    break;
+                }
+                case Operation::ParityMasks:
+                    maskKernel<Operation::ParityMasks><<<blocks, threadsPerBlock, 0, s.stream>>>(
+                        s.deviceIn[0], count, threads, s.deviceMasks[0], s.deviceMasks[1], nullptr);
+                    break;
+                case Operation::SignMasks:
+                    maskKernel<Operation::SignMasks><<<blocks, threadsPerBlock, 0, s.stream>>>(
+                        s.deviceIn[0], count, threads, s.deviceMasks[0], s.deviceMasks[1], s.deviceMasks[2]);
+                    break;
+                }
+                check(cudaGetLastError(), "kernel launch");
+            }
+
+            // Waits for the stream's chunk and copies its results out of staging
+            void finish(const Job& job, Stream& s) {
+                if (!s.pending) {
+                    return;
+                }
+                check(cudaStreamSynchronize(s.stream), "stream synchronize");
+                if (isMaskJob(job)) {
+                    const std::size_t words = (s.count + 63) / 64;
+                    const int outputs = job.operation == Operation::SignMasks ? 3 : 2;
+                    for (int k = 0; k < outputs; ++k) {
+                        std::memcpy(job.masks[k] + s.start / 64, s.hostMasks[k], words * sizeof(std::uint64_t));
+                    }
+                } else {
+                    std::memcpy(job.out + s.start, s.hostOut, s.count * sizeof(double));
+                }
+                s.pending = false;
+            }
+        }
+
+        bool available() {
+            return device().ready;
+        }
+
+        const char* name() {
+            return device().properties.name;
+        }
+
+        /**
+         * @brief Streams a job through the device in chunks
+         * @param job The job; zeroDivisor is set for a Divide with a zero divisor
+         * @return False if the staging buffers could not be allocated
+         * Chunk c goes to stream c % 2. While one stream copies in, computes
+         * and copies out on the device, the host stages the next chunk into
+         * the other stream's pinned buffers and unloads the finished one.
+         */
+        bool run(Job& job) {
+            Device& d = device();
+            std::lock_guard<std::mutex> lock(d.mutex);
+            if (!reserve(d, job.chunkElements)) {
+                return false;
+            }
+
+            const bool binary = job.operation == Operation::Add || job.operation == Operation::Subtract ||
+                                job.operation == Operation::Multiply || job.operation == Operation::Divide;
+            const bool masks = isMaskJob(job);
+            for (Stream& s : d.streams) {
+                s.pending = false;
+                check(cudaMemsetAsync(s.deviceZeroDivisor, 0, sizeof(int), s.stream), "memset");
+            }
+
+            try {
+                for (std::size_t start = 0, c = 0; start < job.n; start += job.chunkElements, ++c) {
+                    Stream& s = d.streams[c % streamCount];
+                    finish(job, s);
+
+                    const std::size_t count = job.n - start < job.chunkElements ? job.n - start : job.chunkElements;
+                    const std::size_t bytes = count * sizeof(double);
+                    std::memcpy(s.hostIn[0], job.a + start, bytes);
+                    check(cudaMemcpyAsync(s.deviceIn[0], s.hostIn[0], bytes, cudaMemcpyHostToDevice, s.stream), "copy in");
+                    if (binary) {
+                        std::memcpy(s.hostIn[1], job.b + start, bytes);
+                        check(cudaMemcpyAsync(s.deviceIn[1], s.hostIn[1], bytes, cudaMemcpyHostToDevice, s.stream),
+                              "copy in");
+                    }
+                    launch(job, s, count);
+                    if (masks) {
+                        const std::size_t maskBytes = (count + 63) / 64 * sizeof(std::uint64_t);
+                        const int outputs = job.operation == Operation::SignMasks ? 3 : 2;
+                        for (int k = 0; k < outputs; ++k) {
+                            check(cudaMemcpyAsync(s.hostMasks[k], s.deviceMasks[k], maskBytes, cudaMemcpyDeviceToHost,
+                                                  s.stream),
+                                  "copy out");
+                        }
+                    } else {
+                        check(cudaMemcpyAsync(s.hostOut, s.deviceOut, bytes, cudaMemcpyDeviceToHost, s.stream), "copy out");
+                    }
+                    s.pending = true;
+                    s.start = start;
+                    s.count = count;
+                }
+                for (Stream& s : d.streams) {
+                    finish(job, s);
+                }
+
+                job.zeroDivisor = false;
+                if (job.operation == Operation::Divide) {
+                    for (Stream& s : d.streams) {
+                        int flag = 0;
+                        check(cudaMemcpy(&flag, s.deviceZeroDivisor, sizeof(int), cudaMemcpyDeviceToHost), "copy flag");
+                        job.zeroDivisor = job.zeroDivisor || flag != 0;
+                    }
+                }
+            } catch (...) {
+                // Leave the streams idle for the next job
+                for (Stream& s : d.streams) {
+                    cudaStreamSynchronize(s.stream);
+                    s.pending = false;
+                }
+                throw;
+            }
+            return true;
+        }
+    }
+}
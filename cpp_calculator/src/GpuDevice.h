@@ -0,0 +1,47 @@
+#ifndef GPUDEVICE_H
+#define GPUDEVICE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Interface between GpuBatch and the CUDA backend in GpuBatch.cu. Without
+// CALCULATOR_CUDA, GpuBatch.cpp defines these to report no device.
+
+namespace Utils {
+    namespace Gpu {
+        enum class Operation : std::uint8_t {
+            Add,
+            Subtract,
+            Multiply,
+            Divide,
+            Power,
+            ParityMasks,
+            SignMasks
+        };
+
+        // One batch operation over host arrays; the unused pointers are null
+        struct Job {
+            Operation operation;
+            const double* a;
+            const double* b;
+            int exponent;
+            double* out;
+            // Mask outputs: even/odd, or positive/zero/negative
+            std::uint64_t* masks[3];
+            std::size_t n;
+            std::size_t chunkElements;
+            // Set by run() when a Divide job met a zero divisor
+            bool zeroDivisor;
+        };
+
+        // Initializes the first CUDA device on first use
+        bool available();
+        const char* name();
+        // Streams the job through the device. Returns false if the device
+        // failed before writing any output, in which case the caller runs the
+        // job on the CPU; later failures throw std::runtime_error.
+        bool run(Job& job);
+    }
+}
+
+#endif // GPUDEVICE_H
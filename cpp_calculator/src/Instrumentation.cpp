@@ -0,0 +1,193 @@
+#include "Instrumentation.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace Instrumentation {
+    namespace {
+        std::atomic<std::uint32_t> sampleInterval(64);
+
+        // Metric label for each Operation
+        const char* const operationNames[operationCount] = {
+            "initialized", "add", "subtract", "multiply", "divide", "power", "reset", "division_error"
+        };
+
+        struct Registry {
+            std::mutex mutex;
+            std::vector<const detail::ThreadStats*> live;
+            Snapshot retired;
+        };
+
+        // Never destroyed, so threads that exit during static destruction can still retire
+        Registry& registry() {
+            static Registry* const instance = new Registry();
+            return *instance;
+        }
+
+        void addInto(Snapshot& total, const detail::ThreadStats& stats) {
+            for (std::size_t op = 0; op < operationCount; ++op) {
+                total.calls[op] += stats.calls[op].load(std::memory_order_relaxed);
+                total.samples[op] += stats.samples[op].load(std::memory_order_relaxed);
+                total.sampledNanoseconds[op] += stats.sampledNanoseconds[op].load(std::memory_order_relaxed);
+                for (std::size_t bucket = 0; bucket < latencyBuckets; ++bucket) {
+                    total.latency[op][bucket] += stats.latency[op][bucket].load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Owns one thread's counters for the lifetime of the thread
+        struct ThreadSlot {
+            detail::ThreadStats stats;
+
+            ThreadSlot() {
+                for (std::size_t op = 0; op < operationCount; ++op) {
+                    stats.calls[op].store(0, std::memory_order_relaxed);
+                    stats.samples[op].store(0, std::memory_order_relaxed);
+                    stats.sampledNanoseconds[op].store(0, std::memory_order_relaxed);
+                    for (std::size_t bucket = 0; bucket < latencyBuckets; ++bucket) {
+                        stats.latency[op][bucket].store(0, std::memory_order_relaxed);
+                    }
+                }
+                // Any non-zero seed works; the address differs between threads
+                stats.jitter = static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(this) >> 4) | 1u;
+                detail::rearm(stats);
+                Registry& r = registry();
+                std::lock_guard<std::mutex> lock(r.mutex);
+                r.live.push_back(&stats);
+            }
+
+            ~ThreadSlot() {
+                Registry& r = registry();
+                std::lock_guard<std::mutex> lock(r.mutex);
+                addInto(r.retired, stats);
+                r.live.erase(std::find(r.live.begin(), r.live.end(), &stats));
+            }
+        };
+
+        /**
+         * @brief Picks the histogram bucket for a latency
+         * @param nanoseconds The measured time
+         * @return floor(log2(nanoseconds)), clamped to the bucket range
+         */
+        std::size_t bucketFor(std::uint64_t nanoseconds) {
+            std::size_t bucket = 0;
+            while (nanoseconds > 1 && bucket + 1 < latencyBuckets) {
+                nanoseconds >>= 1;
+                ++bucket;
+            }
+            return bucket;
+        }
+    }
+
+    namespace detail {
+        ThreadStats* registerThread() {
+            thread_local ThreadSlot slot;
+            return &slot.stats;
+        }
+
+        /**
+         * @brief Chooses the gap until the thread's next sample
+         * @param stats The thread's counters
+         * The gap is uniform in [1, 2 * interval - 1], so it averages interval
+         */
+        void rearm(ThreadStats& stats) {
+            const std::uint32_t interval = sampleInterval.load(std::memory_order_relaxed);
+            std::uint32_t x = stats.jitter;
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            stats.jitter = x;
+            stats.untilSample = 1 + x % (2 * interval - 1);
+        }
+
+        void recordLatency(ThreadStats& stats, std::size_t slot, std::uint64_t nanoseconds) {
+            bump(stats.samples[slot]);
+            bump(stats.sampledNanoseconds[slot], nanoseconds);
+            bump(stats.latency[slot][bucketFor(nanoseconds)]);
+        }
+    }
+
+    /**
+     * @brief Sets how often operations are timed
+     * @param interval One call in every interval is timed on each thread
+     * Threads pick up the new interval after their next sample
+     */
+    void setSampleInterval(std::uint32_t interval) {
+        sampleInterval.store(interval != 0 ? interval : 1, std::memory_order_relaxed);
+    }
+
+    std::uint32_t getSampleInterval() {
+        return sampleInterval.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Aggregates every thread's counters
+     * @return Totals over live threads and threads that have exited
+     * Counters of running threads are read without stopping them, so a
+     * snapshot taken under load is a close, not exact, point-in-time view
+     */
+    Snapshot snapshot() {
+        Snapshot total = {};
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        total = r.retired;
+        for (const detail::ThreadStats* stats : r.live) {
+            addInto(total, *stats);
+        }
+        return total;
+    }
+
+    /**
+     * @brief Writes a snapshot for a Prometheus scraper
+     * @param out The stream to write to; it is not flushed
+     * @param snapshot The counters to export
+     * Exports calculator_operations_total and calculator_division_errors_total
+     * counters and a calculator_operation_duration_seconds histogram of the
+     * sampled calls
+     */
+    void writePrometheus(std::ostream& out, const Snapshot& snapshot) {
+        const std::size_t first = static_cast<std::size_t>(Operation::Add);
+        const std::size_t last = static_cast<std::size_t>(Operation::Reset);
+        const std::size_t errors = static_cast<std::size_t>(Operation::DivisionError);
+
+        out << "# HELP calculator_operations_total Calculator operations performed.\n"
+            << "# TYPE calculator_operations_total counter\n";
+        for (std::size_t op = first; op <= last; ++op) {
+            out << "calculator_operations_total{operation=\"" << operationNames[op] << "\"} "
+                << snapshot.calls[op] << '\n';
+        }
+
+        out << "# HELP calculator_division_errors_total Divisions by zero rejected.\n"
+            << "# TYPE calculator_division_errors_total counter\n"
+            << "calculator_division_errors_total " << snapshot.calls[errors] << '\n';
+
+        out << "# HELP calculator_operation_duration_seconds Latency of sampled calculator operations.\n"
+            << "# TYPE calculator_operation_duration_seconds histogram\n";
+        char bound[32];
+        for (std::size_t op = first; op <= last; ++op) {
+            std::uint64_t cumulative = 0;
+            for (std::size_t bucket = 0; bucket + 1 < latencyBuckets; ++bucket) {
+                cumulative += snapshot.latency[op][bucket];
+                std::snprintf(bound, sizeof(bound), "%.9g", static_cast<double>(std::uint64_t(2) << bucket) * 1e-9);
+                out << "calculator_operation_duration_seconds_bucket{operation=\"" << operationNames[op]
+                    << "\",le=\"" << bound << "\"} " << cumulative << '\n';
+            }
+            std::snprintf(bound, sizeof(bound), "%.9g", static_cast<double>(snapshot.sampledNanoseconds[op]) * 1e-9);
+            out << "calculator_operation_duration_seconds_bucket{operation=\"" << operationNames[op]
+                << "\",le=\"+Inf\"} " << snapshot.samples[op] << '\n'
+                << "calculator_operation_duration_seconds_sum{operation=\"" << operationNames[op] << "\"} "
+                << bound << '\n'
+                << "calculator_operation_duration_seconds_count{operation=\"" << operationNames[op] << "\"} "
+                << snapshot.samples[op] << '\n';
+        }
+    }
+
+    std::string toPrometheus(const Snapshot& snapshot) {
+        std::ostringstream out;
+        writePrometheus(out, snapshot);
+        return out.str();
+    }
+}
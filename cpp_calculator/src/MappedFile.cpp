@@ -0,0 +1,153 @@
+#include "MappedFile.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Constructor - Opens and maps a file read-only
+ * @param path The file to map
+ * Throws std::runtime_error naming the path if any step fails
+ */
+MappedFile::MappedFile(const std::string& path)
+    : bytes(nullptr),
+      length(0),
+#ifdef _WIN32
+      fileHandle(INVALID_HANDLE_VALUE),
+      mappingHandle(nullptr) {
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                             OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        release();
+        throw std::runtime_error("Cannot stat " + path);
+    }
+    length = static_cast<std::size_t>(fileSize.QuadPart);
+    if (length == 0) {
+        return;
+    }
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle == nullptr) {
+        release();
+        throw std::runtime_error("Cannot map " + path);
+    }
+    bytes = static_cast<const unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (bytes == nullptr) {
+        release();
+        throw std::runtime_error("Cannot map " + path);
+    }
+}
+#else
+      descriptor(-1) {
+    descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat status;
+    if (::fstat(descriptor, &status) != 0) {
+        release();
+        throw std::runtime_error("Cannot stat " + path);
+    }
+    length = static_cast<std::size_t>(status.st_size);
+    if (length == 0) {
+        return;
+    }
+    void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, descriptor, 0);
+    if (mapping == MAP_FAILED) {
+        release();
+        throw std::runtime_error("Cannot map " + path);
+    }
+    bytes = static_cast<const unsigned char*>(mapping);
+    // Replay reads front to back
+    ::madvise(mapping, length, MADV_SEQUENTIAL);
+}
+#endif
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : bytes(other.bytes),
+      length(other.length),
+#ifdef _WIN32
+      fileHandle(other.fileHandle),
+      mappingHandle(other.mappingHandle) {
+    other.fileHandle = INVALID_HANDLE_VALUE;
+    other.mappingHandle = nullptr;
+#else
+      descriptor(other.descriptor) {
+    other.descriptor = -1;
+#endif
+    other.bytes = nullptr;
+    other.length = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        bytes = other.bytes;
+        length = other.length;
+#ifdef _WIN32
+        fileHandle = other.fileHandle;
+        mappingHandle = other.mappingHandle;
+        other.fileHandle = INVALID_HANDLE_VALUE;
+        other.mappingHandle = nullptr;
+#else
+        descriptor = other.descriptor;
+        other.descriptor = -1;
+#endif
+        other.bytes = nullptr;
+        other.length = 0;
+    }
+    return *this;
+}
+
+/**
+ * @brief Unmaps the file and closes its handles
+ */
+void MappedFile::release() {
+#ifdef _WIN32
+    if (bytes != nullptr) {
+        UnmapViewOfFile(bytes);
+    }
+    if (mappingHandle != nullptr) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle != INVALID_HANDLE_VALUE) {
+        CloseHandle(fileHandle);
+    }
+    mappingHandle = nullptr;
+    fileHandle = INVALID_HANDLE_VALUE;
+#else
+    if (bytes != nullptr) {
+        ::munmap(const_cast<unsigned char*>(bytes), length);
+    }
+    if (descriptor >= 0) {
+        ::close(descriptor);
+    }
+    descriptor = -1;
+#endif
+    bytes = nullptr;
+    length = 0;
+}
+
+const unsigned char* MappedFile::data() const {
+    return bytes;
+}
+
+std::size_t MappedFile::size() const {
+    return length;
+}
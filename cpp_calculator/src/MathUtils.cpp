@@ -1,32 +1,793 @@
 #include "MathUtils.h"
+#include "SimdTarget.h"
 #include <stdexcept>
-#include <cmath>
 
 namespace Utils {
-    double MathUtils::add(double a, double b) {
-        return a + b;
+    namespace {
+        typedef void (*BinaryKernel)(const double*, const double*, double*, std::size_t);
+        typedef bool (*ScanKernel)(const double*, std::size_t);
+        // Runs compensated summation over blocks of compensatedLanes values,
+        // value j of each block going to lane j of sums/carries
+        typedef void (*CompensatedKernel)(const double*, std::size_t, double*, double*);
+        // Classify n values into bitmask words, maskBits values per word
+        typedef void (*ParityMaskKernel)(const double*, std::size_t, std::uint64_t*, std::uint64_t*);
+        typedef void (*SignMaskKernel)(const double*, std::size_t, std::uint64_t*, std::uint64_t*, std::uint64_t*);
+
+        // Lanes used by compensated summation on every instruction set, so the
+        // result does not depend on which kernels the CPU selected
+        const std::size_t compensatedLanes = 8;
+
+        const std::size_t maskBits = 64;
+
+        // One complete set of batch kernels for a given instruction set
+        struct BatchKernels {
+            const char* name;
+            BinaryKernel add;
+            BinaryKernel subtract;
+            BinaryKernel multiply;
+            BinaryKernel divide;
+            ScanKernel containsZero;
+            CompensatedKernel compensatedSum;
+            ParityMaskKernel parityMasks;
+            SignMaskKernel signMasks;
+        };
+
+        // Every kernel performs exactly one IEEE-754 operation per element, so the
+        // vector and scalar paths round identically and produce the same bits.
+#define MATHUTILS_SCALAR_KERNEL(name, op)                                               \
+        void name##Scalar(const double* a, const double* b, double* out, std::size_t n) { \
+            for (std::size_t i = 0; i < n; ++i) {                                         \
+                out[i] = a[i] op b[i];                                                    \
+            }                                                                             \
+        }
+
+        MATHUTILS_SCALAR_KERNEL(add, +)
+        MATHUTILS_SCALAR_KERNEL(subtract, -)
+        MATHUTILS_SCALAR_KERNEL(multiply, *)
+        MATHUTILS_SCALAR_KERNEL(divide, /)
+
+        bool containsZeroScalar(const double* values, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                if (values[i] == 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void compensatedSumScalar(const double* values, std::size_t blocks, double* sums, double* carries) {
+            for (std::size_t block = 0; block < blocks; ++block) {
+                for (std::size_t lane = 0; lane < compensatedLanes; ++lane) {
+                    MathUtils::compensatedAdd(sums[lane], carries[lane], values[block * compensatedLanes + lane]);
+                }
+            }
+        }
+
+        // The mask kernels handle any n, so the vector versions finish with these
+        void parityMasksScalar(const double* values, std::size_t n, std::uint64_t* even, std::uint64_t* odd) {
+            for (std::size_t word = 0; word * maskBits < n; ++word) {
+                const std::size_t start = word * maskBits;
+                const std::size_t count = n - start < maskBits ? n - start : maskBits;
+                std::uint64_t evenBits = 0;
+                std::uint64_t oddBits = 0;
+                for (std::size_t bit = 0; bit < count; ++bit) {
+                    evenBits |= static_cast<std::uint64_t>(MathUtils::isEven(values[start + bit])) << bit;
+                    oddBits |= static_cast<std::uint64_t>(MathUtils::isOdd(values[start + bit])) << bit;
+                }
+                even[word] = evenBits;
+                odd[word] = oddBits;
+            }
+        }
+
+        void signMasksScalar(const double* values, std::size_t n, std::uint64_t* positive, std::uint64_t* zero,
+                             std::uint64_t* negative) {
+            for (std::size_t word = 0; word * maskBits < n; ++word) {
+                const std::size_t start = word * maskBits;
+                const std::size_t count = n - start < maskBits ? n - start : maskBits;
+                std::uint64_t positiveBits = 0;
+                std::uint64_t zeroBits = 0;
+                std::uint64_t negativeBits = 0;
+                for (std::size_t bit = 0; bit < count; ++bit) {
+                    const double value = values[start + bit];
+                    positiveBits |= static_cast<std::uint64_t>(value > 0) << bit;
+                    zeroBits |= static_cast<std::uint64_t>(value == 0) << bit;
+                    negativeBits |= static_cast<std::uint64_t>(value < 0) << bit;
+                }
+                positive[word] = positiveBits;
+                zero[word] = zeroBits;
+                negative[word] = negativeBits;
+            }
+        }
+
+        const BatchKernels scalarKernels = {
+            "scalar", addScalar, subtractScalar, multiplyScalar, divideScalar, containsZeroScalar,
+            compensatedSumScalar, parityMasksScalar, signMasksScalar
+        };
+
+#if defined(MATHUTILS_HAVE_SSE2)
+#define MATHUTILS_SSE2_KERNEL(name, op, intrinsic)                                      \
+        void name##Sse2(const double* a, const double* b, double* out, std::size_t n) { \
+            std::size_t i = 0;                                                          \
+            for (; i + 2 <= n; i += 2) {                                                \
+                _mm_storeu_pd(out + i, intrinsic(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i))); \
+            }                                                                           \
+            for (; i < n; ++i) {                                                        \
+                out[i] = a[i] op b[i];                                                  \
+            }                                                                           \
+        }
+
+        MATHUTILS_SSE2_KERNEL(add, +, _mm_add_pd)
+        MATHUTILS_SSE2_KERNEL(subtract, -, _mm_sub_pd)
+        MATHUTILS_SSE2_KERNEL(multiply, *, _mm_mul_pd)
+        MATHUTILS_SSE2_KERNEL(divide, /, _mm_div_pd)
+
+        bool containsZeroSse2(const double* values, std::size_t n) {
+            const __m128d zero = _mm_setzero_pd();
+            __m128d found = _mm_setzero_pd();
+            std::size_t i = 0;
+            for (; i + 2 <= n; i += 2) {
+                found = _mm_or_pd(found, _mm_cmpeq_pd(_mm_loadu_pd(values + i), zero));
+            }
+            return _mm_movemask_pd(found) != 0 || containsZeroScalar(values + i, n - i);
+        }
+
+        // Same steps as MathUtils::compensatedAdd, with the branch turned into a blend
+        void compensatedStepSse2(__m128d& s, __m128d& c, __m128d v) {
+            const __m128d absMask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+            const __m128d t = _mm_add_pd(s, v);
+            const __m128d sBigger = _mm_cmpge_pd(_mm_and_pd(s, absMask), _mm_and_pd(v, absMask));
+            const __m128d ifBigger = _mm_add_pd(_mm_sub_pd(s, t), v);
+            const __m128d ifSmaller = _mm_add_pd(_mm_sub_pd(v, t), s);
+            c = _mm_add_pd(c, _mm_or_pd(_mm_and_pd(sBigger, ifBigger), _mm_andnot_pd(sBigger, ifSmaller)));
+            s = t;
+        }
+
+        void compensatedSumSse2(const double* values, std::size_t blocks, double* sums, double* carries) {
+            __m128d s[4];
+            __m128d c[4];
+            for (int j = 0; j < 4; ++j) {
+                s[j] = _mm_loadu_pd(sums + 2 * j);
+                c[j] = _mm_loadu_pd(carries + 2 * j);
+            }
+            for (std::size_t block = 0; block < blocks; ++block) {
+                const double* v = values + block * compensatedLanes;
+                for (int j = 0; j < 4; ++j) {
+                    compensatedStepSse2(s[j], c[j], _mm_loadu_pd(v + 2 * j));
+                }
+            }
+            for (int j = 0; j < 4; ++j) {
+                _mm_storeu_pd(sums + 2 * j, s[j]);
+                _mm_storeu_pd(carries + 2 * j, c[j]);
+            }
+        }
+
+        // SSE2 has no truncating round, so parity comes from the bits instead. For
+        // |x| < 2^52, |x| + 2^52 rounds |x| to an integer r held in the lowest
+        // significand bits; floor(|x|) is r, or r - 1 when r > |x|. For
+        // 2^52 <= |x| < 2^53 the lowest significand bit of |x| is the parity,
+        // and from 2^53 on every double is even.
+        void parityMasksSse2(const double* values, std::size_t n, std::uint64_t* even, std::uint64_t* odd) {
+            const __m128d absMask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+            const __m128d two52 = _mm_set1_pd(4503599627370496.0);
+            const __m128d two53 = _mm_set1_pd(9007199254740992.0);
+            const __m128d largest = _mm_set1_pd(1.7976931348623157e308);
+            const std::size_t words = n / maskBits;
+            for (std::size_t word = 0; word < words; ++word) {
+                const double* v = values + word * maskBits;
+                std::uint64_t evenBits = 0;
+                std::uint64_t oddBits = 0;
+                for (std::size_t bit = 0; bit < maskBits; bit += 2) {
+                    const __m128d a = _mm_and_pd(_mm_loadu_pd(v + bit), absMask);
+                    const __m128d r = _mm_add_pd(a, two52);
+                    const __m128d roundedUp = _mm_cmpgt_pd(_mm_sub_pd(r, two52), a);
+                    // Parity bits moved to the sign position, where movemask reads them
+                    const __m128d rLow = _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(r), 63));
+                    const __m128d aLow = _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(a), 63));
+                    const __m128d small = _mm_cmplt_pd(a, two52);
+                    const __m128d exact = _mm_andnot_pd(small, _mm_cmplt_pd(a, two53));
+                    const __m128d isOdd = _mm_or_pd(_mm_and_pd(small, _mm_xor_pd(rLow, roundedUp)),
+                                                    _mm_and_pd(exact, aLow));
+                    const std::uint64_t finite = static_cast<std::uint64_t>(_mm_movemask_pd(_mm_cmple_pd(a, largest)));
+                    const std::uint64_t oddLanes = static_cast<std::uint64_t>(_mm_movemask_pd(isOdd));
+                    evenBits |= (finite & ~oddLanes) << bit;
+                    oddBits |= oddLanes << bit;
+                }
+                even[word] = evenBits;
+                odd[word] = oddBits;
+            }
+            parityMasksScalar(values + words * maskBits, n - words * maskBits, even + words, odd + words);
+        }
+
+        void signMasksSse2(const double* values, std::size_t n, std::uint64_t* positive, std::uint64_t* zero,
+                           std::uint64_t* negative) {
+            const __m128d zeroValue = _mm_setzero_pd();
+            const std::size_t words = n / maskBits;
+            for (std::size_t word = 0; word < words; ++word) {
+                const double* v = values + word * maskBits;
+                std::uint64_t positiveBits = 0;
+                std::uint64_t zeroBits = 0;
+                std::uint64_t negativeBits = 0;
+                for (std::size_t bit = 0; bit < maskBits; bit += 2) {
+                    const __m128d x = _mm_loadu_pd(v + bit);
+                    positiveBits |= static_cast<std::uint64_t>(_mm_movemask_pd(_mm_cmpgt_pd(x, zeroValue))) << bit;
+                    zeroBits |= static_cast<std::uint64_t>(_mm_movemask_pd(_mm_cmpeq_pd(x, zeroValue))) << bit;
+                    negativeBits |= static_cast<std::uint64_t>(_mm_movemask_pd(_mm_cmplt_pd(x, zeroValue))) << bit;
+                }
+                positive[word] = positiveBits;
+                zero[word] = zeroBits;
+                negative[word] = negativeBits;
+            }
+            signMasksScalar(values + words * maskBits, n - words * maskBits, positive + words, zero + words,
+                            negative + words);
+        }
+
+        const BatchKernels sse2Kernels = {
+            "sse2", addSse2, subtractSse2, multiplySse2, divideSse2, containsZeroSse2,
+            compensatedSumSse2, parityMasksSse2, signMasksSse2
+        };
+#endif
+
+#if defined(MATHUTILS_X86_DISPATCH)
+#define MATHUTILS_AVX2_KERNEL(name, op, intrinsic)                                      \
+        __attribute__((target("avx2")))                                                 \
+        void name##Avx2(const double* a, const double* b, double* out, std::size_t n) { \
+            std::size_t i = 0;                                                          \
+            for (; i + 4 <= n; i += 4) {                                                \
+                _mm256_storeu_pd(out + i, intrinsic(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i))); \
+            }                                                                           \
+            for (; i < n; ++i) {                                                        \
+                out[i] = a[i] op b[i];                                                  \
+            }                                                                           \
+        }
+
+        MATHUTILS_AVX2_KERNEL(add, +, _mm256_add_pd)
+        MATHUTILS_AVX2_KERNEL(subtract, -, _mm256_sub_pd)
+        MATHUTILS_AVX2_KERNEL(multiply, *, _mm256_mul_pd)
+        MATHUTILS_AVX2_KERNEL(divide, /, _mm256_div_pd)
+
+        __attribute__((target("avx2")))
+        bool containsZeroAvx2(const double* values, std::size_t n) {
+            const __m256d zero = _mm256_setzero_pd();
+            __m256d found = _mm256_setzero_pd();
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                found = _mm256_or_pd(found, _mm256_cmp_pd(_mm256_loadu_pd(values + i), zero, _CMP_EQ_OQ));
+            }
+            return _mm256_movemask_pd(found) != 0 || containsZeroScalar(values + i, n - i);
+        }
+
+        __attribute__((target("avx2")))
+        inline void compensatedStepAvx2(__m256d& s, __m256d& c, __m256d v) {
+            const __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+            const __m256d t = _mm256_add_pd(s, v);
+            const __m256d sBigger = _mm256_cmp_pd(_mm256_and_pd(s, absMask), _mm256_and_pd(v, absMask), _CMP_GE_OQ);
+            const __m256d ifBigger = _mm256_add_pd(_mm256_sub_pd(s, t), v);
+            const __m256d ifSmaller = _mm256_add_pd(_mm256_sub_pd(v, t), s);
+            c = _mm256_add_pd(c, _mm256_blendv_pd(ifSmaller, ifBigger, sBigger));
+            s = t;
+        }
+
+        __attribute__((target("avx2")))
+        void compensatedSumAvx2(const double* values, std::size_t blocks, double* sums, double* carries) {
+            __m256d s0 = _mm256_loadu_pd(sums);
+            __m256d s1 = _mm256_loadu_pd(sums + 4);
+            __m256d c0 = _mm256_loadu_pd(carries);
+            __m256d c1 = _mm256_loadu_pd(carries + 4);
+            for (std::size_t block = 0; block < blocks; ++block) {
+                const double* v = values + block * compensatedLanes;
+                compensatedStepAvx2(s0, c0, _mm256_loadu_pd(v));
+                compensatedStepAvx2(s1, c1, _mm256_loadu_pd(v + 4));
+            }
+            _mm256_storeu_pd(sums, s0);
+            _mm256_storeu_pd(sums + 4, s1);
+            _mm256_storeu_pd(carries, c0);
+            _mm256_storeu_pd(carries + 4, c1);
+        }
+
+        __attribute__((target("avx2")))
+        void parityMasksAvx2(const double* values, std::size_t n, std::uint64_t* even, std::uint64_t* odd) {
+            const __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+            const __m256d largest = _mm256_set1_pd(1.7976931348623157e308);
+            const __m256d half = _mm256_set1_pd(0.5);
+            const std::size_t words = n / maskBits;
+            for (std::size_t word = 0; word < words; ++word) {
+                const double* v = values + word * maskBits;
+                std::uint64_t evenBits = 0;
+                std::uint64_t oddBits = 0;
+                for (std::size_t bit = 0; bit < maskBits; bit += 4) {
+                    const __m256d x = _mm256_loadu_pd(v + bit);
+                    const __m256d h = _mm256_mul_pd(_mm256_round_pd(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC), half);
+                    const __m256d halfIsInteger =
+                        _mm256_cmp_pd(_mm256_round_pd(h, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC), h, _CMP_EQ_OQ);
+                    const __m256d finite = _mm256_cmp_pd(_mm256_and_pd(x, absMask), largest, _CMP_LE_OQ);
+                    evenBits |= static_cast<std::uint64_t>(_mm256_movemask_pd(_mm256_and_pd(finite, halfIsInteger))) << bit;
+                    oddBits |= static_cast<std::uint64_t>(_mm256_movemask_pd(_mm256_andnot_pd(halfIsInteger, finite))) << bit;
+                }
+                even[word] = evenBits;
+                odd[word] = oddBits;
+            }
+            parityMasksScalar(values + words * maskBits, n - words * maskBits, even + words, odd + words);
+        }
+
+        __attribute__((target("avx2")))
+        void signMasksAvx2(const double* values, std::size_t n, std::uint64_t* positive, std::uint64_t* zero,
+                           std::uint64_t* negative) {
+            const __m256d zeroValue = _mm256_setzero_pd();
+            const std::size_t words = n / maskBits;
+            for (std::size_t word = 0; word < words; ++word) {
+                const double* v = values + word * maskBits;
+                std::uint64_t positiveBits = 0;
+                std::uint64_t zeroBits = 0;
+                std::uint64_t negativeBits = 0;
+                for (std::size_t bit = 0; bit < maskBits; bit += 4) {
+                    const __m256d x = _mm256_loadu_pd(v + bit);
+                    positiveBits |= static_cast<std::uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(x, zeroValue, _CMP_GT_OQ))) << bit;
+                    zeroBits |= static_cast<std::uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(x, zeroValue, _CMP_EQ_OQ))) << bit;
+                    negativeBits |= static_cast<std::uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(x, zeroValue, _CMP_LT_OQ))) << bit;
+                }
+                positive[word] = positiveBits;
+                zero[word] = zeroBits;
+                negative[word] = negativeBits;
+            }
+            signMasksScalar(values + words * maskBits, n - words * maskBits, positive + words, zero + words,
+                            negative + words);
+        }
+
+        const BatchKernels avx2Kernels = {
+            "avx2", addAvx2, subtractAvx2, multiplyAvx2, divideAvx2, containsZeroAvx2,
+            compensatedSumAvx2, parityMasksAvx2, signMasksAvx2
+        };
+
+        // AVX-512 handles the tail with masked loads, a zero-masked operation and a
+        // masked store instead of a scalar loop; masked-off lanes raise no exceptions
+#define MATHUTILS_AVX512_KERNEL(name, intrinsic, maskedIntrinsic)                       \
+        __attribute__((target("avx512f")))                                              \
+        void name##Avx512(const double* a, const double* b, double* out, std::size_t n) { \
+            std::size_t i = 0;                                                          \
+            for (; i + 8 <= n; i += 8) {                                                \
+                _mm512_storeu_pd(out + i, intrinsic(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i))); \
+            }                                                                           \
+            if (i < n) {                                                                \
+                const __mmask8 tail = static_cast<__mmask8>((1u << (n - i)) - 1u);     \
+                const __m512d va = _mm512_maskz_loadu_pd(tail, a + i);                  \
+                const __m512d vb = _mm512_maskz_loadu_pd(tail, b + i);                  \
+                _mm512_mask_storeu_pd(out + i, tail, maskedIntrinsic(tail, va, vb));    \
+            }                                                                           \
+        }
+
+        MATHUTILS_AVX512_KERNEL(add, _mm512_add_pd, _mm512_maskz_add_pd)
+        MATHUTILS_AVX512_KERNEL(subtract, _mm512_sub_pd, _mm512_maskz_sub_pd)
+        MATHUTILS_AVX512_KERNEL(multiply, _mm512_mul_pd, _mm512_maskz_mul_pd)
+        MATHUTILS_AVX512_KERNEL(divide, _mm512_div_pd, _mm512_maskz_div_pd)
+
+        __attribute__((target("avx512f")))
+        bool containsZeroAvx512(const double* values, std::size_t n) {
+            const __m512d zero = _mm512_setzero_pd();
+            __mmask8 found = 0;
+            std::size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                found |= _mm512_cmp_pd_mask(_mm512_loadu_pd(values + i), zero, _CMP_EQ_OQ);
+            }
+            return found != 0 || containsZeroScalar(values + i, n - i);
+        }
+
+        __attribute__((target("avx512f")))
+        void compensatedSumAvx512(const double* values, std::size_t blocks, double* sums, double* carries) {
+            __m512d s = _mm512_loadu_pd(sums);
+            __m512d c = _mm512_loadu_pd(carries);
+            for (std::size_t block = 0; block < blocks; ++block) {
+                const __m512d v = _mm512_loadu_pd(values + block * compensatedLanes);
+                const __m512d t = _mm512_add_pd(s, v);
+                const __mmask8 sBigger = _mm512_cmp_pd_mask(_mm512_abs_pd(s), _mm512_abs_pd(v), _CMP_GE_OQ);
+                const __m512d ifBigger = _mm512_add_pd(_mm512_sub_pd(s, t), v);
+                const __m512d ifSmaller = _mm512_add_pd(_mm512_sub_pd(v, t), s);
+                c = _mm512_add_pd(c, _mm512_mask_blend_pd(sBigger, ifSmaller, ifBigger));
+                s = t;
+            }
+            _mm512_storeu_pd(sums, s);
+            _mm512_storeu_pd(carries, c);
+        }
+
+        // AVX-512 comparisons produce the mask bits directly, eight lanes at a time
+        __attribute__((target("avx512f")))
+        void parityMasksAvx512(const double* values, std::size_t n, std::uint64_t* even, std::uint64_t* odd) {
+            const __m512d largest = _mm512_set1_pd(1.7976931348623157e308);
+            const __m512d half = _mm512_set1_pd(0.5);
+            const std::size_t words = n / maskBits;
+            for (std::size_t word = 0; word < words; ++word) {
+                const double* v = values + word * maskBits;
+                std::uint64_t evenBits = 0;
+                std::uint64_t oddBits = 0;
+                for (std::size_t bit = 0; bit < maskBits; bit += 8) {
+                    // The zero-masked form with all lanes enabled avoids a spurious
+                    // -Wmaybe-uninitialized from GCC's unmasked roundscale
+                    const __m512d x = _mm512_loadu_pd(v + bit);
+                    const __m512d h = _mm512_mul_pd(
+                        _mm512_maskz_roundscale_pd(0xff, x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC), half);
+                    const __mmask8 halfIsInteger = _mm512_cmp_pd_mask(
+                        _mm512_maskz_roundscale_pd(0xff, h, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC), h, _CMP_EQ_OQ);
+                    const __mmask8 finite = _mm512_cmp_pd_mask(_mm512_abs_pd(x), largest, _CMP_LE_OQ);
+                    evenBits |= static_cast<std::uint64_t>(finite & halfIsInteger) << bit;
+                    oddBits |= static_cast<std::uint64_t>(finite & static_cast<__mmask8>(~halfIsInteger)) << bit;
+                }
+                even[word] = evenBits;
+                odd[word] = oddBits;
+            }
+            parityMasksScalar(values + words * maskBits, n - words * maskBits, even + words, odd + words);
+        }
+
+        __attribute__((target("avx512f")))
+        void signMasksAvx512(const double* values, std::size_t n, std::uint64_t* positive, std::uint64_t* zero,
+                             std::uint64_t* negative) {
+            const __m512d zeroValue = _mm512_setzero_pd();
+            const std::size_t words = n / maskBits;
+            for (std::size_t word = 0; word < words; ++word) {
+                const double* v = values + word * maskBits;
+                std::uint64_t positiveBits = 0;
+                std::uint64_t zeroBits = 0;
+                std::uint64_t negativeBits = 0;
+                for (std::size_t bit = 0; bit < maskBits; bit += 8) {
+                    const __m512d x = _mm512_loadu_pd(v + bit);
+                    positiveBits |= static_cast<std::uint64_t>(_mm512_cmp_pd_mask(x, zeroValue, _CMP_GT_OQ)) << bit;
+                    zeroBits |= static_cast<std::uint64_t>(_mm512_cmp_pd_mask(x, zeroValue, _CMP_EQ_OQ)) << bit;
+                    negativeBits |= static_cast<std::uint64_t>(_mm512_cmp_pd_mask(x, zeroValue, _CMP_LT_OQ)) << bit;
+                }
+                positive[word] = positiveBits;
+                zero[word] = zeroBits;
+                negative[word] = negativeBits;
+            }
+            signMasksScalar(values + words * maskBits, n - words * maskBits, positive + words, zero + words,
+                            negative + words);
+        }
+
+        const BatchKernels avx512Kernels = {
+            "avx512", addAvx512, subtractAvx512, multiplyAvx512, divideAvx512, containsZeroAvx512,
+            compensatedSumAvx512, parityMasksAvx512, signMasksAvx512
+        };
+#endif
+
+#if defined(MATHUTILS_NEON)
+#define MATHUTILS_NEON_KERNEL(name, op, intrinsic)                                      \
+        void name##Neon(const double* a, const double* b, double* out, std::size_t n) { \
+            std::size_t i = 0;                                                          \
+            for (; i + 2 <= n; i += 2) {                                                \
+                vst1q_f64(out + i, intrinsic(vld1q_f64(a + i), vld1q_f64(b + i)));      \
+            }                                                                           \
+            for (; i < n; ++i) {                                                        \
+                out[i] = a[i] op b[i];                                                  \
+            }                                                                           \
+        }
+
+        MATHUTILS_NEON_KERNEL(add, +, vaddq_f64)
+        MATHUTILS_NEON_KERNEL(subtract, -, vsubq_f64)
+        MATHUTILS_NEON_KERNEL(multiply, *, vmulq_f64)
+        MATHUTILS_NEON_KERNEL(divide, /, vdivq_f64)
+
+        bool containsZeroNeon(const double* values, std::size_t n) {
+            uint64x2_t found = vdupq_n_u64(0);
+            std::size_t i = 0;
+            for (; i + 2 <= n; i += 2) {
+                found = vorrq_u64(found, vceqzq_f64(vld1q_f64(values + i)));
+            }
+            return (vgetq_lane_u64(found, 0) | vgetq_lane_u64(found, 1)) != 0
+                || containsZeroScalar(values + i, n - i);
+        }
+
+        void compensatedSumNeon(const double* values, std::size_t blocks, double* sums, double* carries) {
+            float64x2_t s[4];
+            float64x2_t c[4];
+            for (int j = 0; j < 4; ++j) {
+                s[j] = vld1q_f64(sums + 2 * j);
+                c[j] = vld1q_f64(carries + 2 * j);
+            }
+            for (std::size_t block = 0; block < blocks; ++block) {
+                const double* v = values + block * compensatedLanes;
+                for (int j = 0; j < 4; ++j) {
+                    const float64x2_t x = vld1q_f64(v + 2 * j);
+                    const float64x2_t t = vaddq_f64(s[j], x);
+                    const uint64x2_t sBigger = vcgeq_f64(vabsq_f64(s[j]), vabsq_f64(x));
+                    const float64x2_t ifBigger = vaddq_f64(vsubq_f64(s[j], t), x);
+                    const float64x2_t ifSmaller = vaddq_f64(vsubq_f64(x, t), s[j]);
+                    c[j] = vaddq_f64(c[j], vbslq_f64(sBigger, ifBigger, ifSmaller));
+                    s[j] = t;
+                }
+            }
+            for (int j = 0; j < 4; ++j) {
+                vst1q_f64(sums + 2 * j, s[j]);
+                vst1q_f64(carries + 2 * j, c[j]);
+            }
+        }
+
+        // NEON has no movemask, so each lane's compare result is narrowed to one bit
+        std::uint64_t laneBitsNeon(uint64x2_t mask) {
+            return (vgetq_lane_u64(mask, 0) & 1u) | ((vgetq_lane_u64(mask, 1) & 1u) << 1);
+        }
+
+        void parityMasksNeon(const double* values, std::size_t n, std::uint64_t* even, std::uint64_t* odd) {
+            const float64x2_t largest = vdupq_n_f64(1.7976931348623157e308);
+            const std::size_t words = n / maskBits;
+            for (std::size_t word = 0; word < words; ++word) {
+                const double* v = values + word * maskBits;
+                std::uint64_t evenBits = 0;
+                std::uint64_t oddBits = 0;
+                for (std::size_t bit = 0; bit < maskBits; bit += 2) {
+                    const float64x2_t x = vld1q_f64(v + bit);
+                    const float64x2_t h = vmulq_n_f64(vrndq_f64(x), 0.5);
+                    const std::uint64_t halfIsInteger = laneBitsNeon(vceqq_f64(vrndq_f64(h), h));
+                    const std::uint64_t finite = laneBitsNeon(vcleq_f64(vabsq_f64(x), largest));
+                    evenBits |= (finite & halfIsInteger) << bit;
+                    oddBits |= (finite & ~halfIsInteger) << bit;
+                }
+                even[word] = evenBits;
+                odd[word] = oddBits;
+            }
+            parityMasksScalar(values + words * maskBits, n - words * maskBits, even + words, odd + words);
+        }
+
+        void signMasksNeon(const double* values, std::size_t n, std::uint64_t* positive, std::uint64_t* zero,
+                           std::uint64_t* negative) {
+            const std::size_t words = n / maskBits;
+            for (std::size_t word = 0; word < words; ++word) {
+                const double* v = values + word * maskBits;
+                std::uint64_t positiveBits = 0;
+                std::uint64_t zeroBits = 0;
+                std::uint64_t negativeBits = 0;
+                for (std::size_t bit = 0; bit < maskBits; bit += 2) {
+                    const float64x2_t x = vld1q_f64(v + bit);
+                    positiveBits |= laneBitsNeon(vcgtzq_f64(x)) << bit;
+                    zeroBits |= laneBitsNeon(vceqzq_f64(x)) << bit;
+                    negativeBits |= laneBitsNeon(vcltzq_f64(x)) << bit;
+                }
+                positive[word] = positiveBits;
+                zero[word] = zeroBits;
+                negative[word] = negativeBits;
+            }
+            signMasksScalar(values + words * maskBits, n - words * maskBits, positive + words, zero + words,
+                            negative + words);
+        }
+
+        const BatchKernels neonKernels = {
+            "neon", addNeon, subtractNeon, multiplyNeon, divideNeon, containsZeroNeon,
+            compensatedSumNeon, parityMasksNeon, signMasksNeon
+        };
+#endif
+
+        const BatchKernels& selectKernels() {
+#if defined(MATHUTILS_X86_DISPATCH)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f")) {
+                return avx512Kernels;
+            }
+            if (__builtin_cpu_supports("avx2")) {
+                return avx2Kernels;
+            }
+#endif
+#if defined(MATHUTILS_HAVE_SSE2)
+            return sse2Kernels;
+#elif defined(MATHUTILS_NEON)
+            return neonKernels;
+#else
+            return scalarKernels;
+#endif
+        }
+
+        // Resolved once on first use; initialization of the local static is thread-safe
+        const BatchKernels& kernels() {
+            static const BatchKernels& selected = selectKernels();
+            return selected;
+        }
     }
-    
-    double MathUtils::subtract(double a, double b) {
-        return a - b;
+
+    void MathUtils::add(const double* a, const double* b, double* out, std::size_t n) {
+        kernels().add(a, b, out, n);
+    }
+
+    void MathUtils::subtract(const double* a, const double* b, double* out, std::size_t n) {
+        kernels().subtract(a, b, out, n);
     }
-    
-    double MathUtils::multiply(double a, double b) {
-        return a * b;
+
+    void MathUtils::multiply(const double* a, const double* b, double* out, std::size_t n) {
+        kernels().multiply(a, b, out, n);
     }
-    
-    double MathUtils::divide(double a, double b) {
-        if (b == 0) {
+
+    // Like the scalar divide, a zero divisor anywhere in the batch throws; the
+    // check runs first so that out is left untouched on error.
+    void MathUtils::divide(const double* a, const double* b, double* out, std::size_t n) {
+        const BatchKernels& k = kernels();
+        if (k.containsZero(b, n)) {
             throw std::runtime_error("Division by zero error");
         }
-        return a / b;
+        k.divide(a, b, out, n);
+    }
+
+    void MathUtils::add(double* a, const double* b, std::size_t n) {
+        add(a, b, a, n);
+    }
+
+    void MathUtils::subtract(double* a, const double* b, std::size_t n) {
+        subtract(a, b, a, n);
+    }
+
+    void MathUtils::multiply(double* a, const double* b, std::size_t n) {
+        multiply(a, b, a, n);
+    }
+
+    void MathUtils::divide(double* a, const double* b, std::size_t n) {
+        divide(a, b, a, n);
+    }
+
+    // Runs the same square-and-multiply sequence as the scalar power() on a
+    // block of elements at a time, so each step is one batch multiply.
+    void MathUtils::power(const double* base, int exponent, double* out, std::size_t n) {
+        const BatchKernels& k = kernels();
+        const std::size_t blockSize = 256;
+        double square[blockSize];
+        const unsigned int magnitude = exponent < 0 ? 0u - static_cast<unsigned int>(exponent)
+                                                    : static_cast<unsigned int>(exponent);
+
+        for (std::size_t start = 0; start < n; start += blockSize) {
+            const std::size_t count = n - start < blockSize ? n - start : blockSize;
+            double* result = out + start;
+            // base may alias out, so take the copy before overwriting the result
+            for (std::size_t i = 0; i < count; ++i) {
+                square[i] = base[start + i];
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                result[i] = 1.0;
+            }
+
+            unsigned int remaining = magnitude;
+            while (remaining != 0) {
+                if (remaining & 1u) {
+                    k.multiply(result, square, result, count);
+                }
+                remaining >>= 1;
+                if (remaining != 0) {
+                    k.multiply(square, square, square, count);
+                }
+            }
+
+            if (exponent < 0) {
+                for (std::size_t i = 0; i < count; ++i) {
+                    result[i] = 1.0 / result[i];
+                }
+            }
+        }
+    }
+
+    void MathUtils::power(double* base, int exponent, std::size_t n) {
+        power(base, exponent, base, n);
+    }
+
+    // The classification loops are written without branches so that the
+    // compiler can vectorize them
+    void MathUtils::parity(const int* values, Parity* out, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = static_cast<Parity>(values[i] & 1);
+        }
+    }
+
+    void MathUtils::sign(const double* values, Sign* out, std::size_t n) {
+        static_assert(static_cast<int>(Sign::Negative) == 0 && static_cast<int>(Sign::Zero) == 1 &&
+                          static_cast<int>(Sign::Positive) == 2 && static_cast<int>(Sign::NotANumber) == 3,
+                      "sign() computes the enumerator values directly");
+        for (std::size_t i = 0; i < n; ++i) {
+            const double value = values[i];
+            const int code = static_cast<int>(value == 0) + 2 * static_cast<int>(value > 0) +
+                             3 * static_cast<int>(value != value);
+            out[i] = static_cast<Sign>(code);
+        }
+    }
+
+    void MathUtils::parityMasks(const double* values, std::size_t n, std::uint64_t* even, std::uint64_t* odd) {
+        kernels().parityMasks(values, n, even, odd);
+    }
+
+    void MathUtils::signMasks(const double* values, std::size_t n, std::uint64_t* positive, std::uint64_t* zero,
+                              std::uint64_t* negative) {
+        kernels().signMasks(values, n, positive, zero, negative);
+    }
+
+    namespace {
+        // Blocks at or below this size are summed directly by pairwiseSum
+        const std::size_t pairwiseBlock = 128;
+
+        double pairwiseSum(const double* values, std::size_t n) {
+            if (n <= pairwiseBlock) {
+                // Eight interleaved partial sums keep the adder pipeline busy
+                double partial[8] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+                std::size_t i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    for (std::size_t lane = 0; lane < 8; ++lane) {
+                        partial[lane] += values[i + lane];
+                    }
+                }
+                double total = ((partial[0] + partial[1]) + (partial[2] + partial[3])) +
+                               ((partial[4] + partial[5]) + (partial[6] + partial[7]));
+                for (; i < n; ++i) {
+                    total += values[i];
+                }
+                return total;
+            }
+            const std::size_t half = n / 2;
+            return pairwiseSum(values, half) + pairwiseSum(values + half, n - half);
+        }
     }
-    
-    double MathUtils::power(double base, int exponent) {
-        return std::pow(base, exponent);
+
+    /**
+     * @brief Sums an array of values
+     * @param values The values to sum
+     * @param n Number of values
+     * @param mode Naive (bit-identical to repeated add), Compensated or Pairwise
+     * @return The sum, 0.0 for an empty array
+     */
+    double MathUtils::sum(const double* values, std::size_t n, Summation mode) {
+        switch (mode) {
+        case Summation::Compensated: {
+            double total = 0.0;
+            double carry = 0.0;
+            accumulateCompensated(values, n, total, carry);
+            return total + carry;
+        }
+        case Summation::Pairwise:
+            return n == 0 ? 0.0 : pairwiseSum(values, n);
+        default: {
+            double total = 0.0;
+            for (std::size_t i = 0; i < n; ++i) {
+                total += values[i];
+            }
+            return total;
+        }
+        }
     }
-    
-    bool MathUtils::isEven(int number) {
-        return number % 2 == 0;
+
+    /**
+     * @brief Multiplies an array of values together, left to right
+     * @param values The factors
+     * @param n Number of factors
+     * @return The product, 1.0 for an empty array
+     */
+    double MathUtils::product(const double* values, std::size_t n) {
+        double total = 1.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            total *= values[i];
+        }
+        return total;
+    }
+
+    /**
+     * @brief Adds values to a running Neumaier compensated sum
+     * @param values The values to add
+     * @param n Number of values
+     * @param sum The running sum, updated in place
+     * @param carry The accumulated rounding error, updated in place
+     * The low-order bits lost by each addition are collected in carry, so
+     * sum + carry stays accurate to about one rounding regardless of n.
+     * Values are spread over eight independent compensated lanes (run by the
+     * SIMD kernels) that are folded together at the end; the lane layout is
+     * the same on every instruction set, so results are too.
+     */
+    void MathUtils::accumulateCompensated(const double* values, std::size_t n, double& sum, double& carry) {
+        double sums[compensatedLanes] = {sum};
+        double carries[compensatedLanes] = {carry};
+        const std::size_t blocks = n / compensatedLanes;
+        kernels().compensatedSum(values, blocks, sums, carries);
+        for (std::size_t i = blocks * compensatedLanes; i < n; ++i) {
+            const std::size_t lane = i - blocks * compensatedLanes;
+            compensatedAdd(sums[lane], carries[lane], values[i]);
+        }
+
+        double s = sums[0];
+        double c = carries[0];
+        for (std::size_t lane = 1; lane < compensatedLanes; ++lane) {
+            compensatedAdd(s, c, sums[lane]);
+            c += carries[lane];
+        }
+        sum = s;
+        carry = c;
+    }
+
+    const char* MathUtils::batchInstructionSet() {
+        return kernels().name;
     }
 }
@@ -0,0 +1,648 @@
+#include "MathUtils.h"
+#include "SimdTarget.h"
+#include <cstring>
+#include <stdexcept>
+
+// Single- and half-precision batch kernels, dispatched like the double ones
+// in MathUtils.cpp but selected separately, since F16C is its own feature.
+
+namespace Utils {
+    namespace {
+        typedef void (*FloatBinaryKernel)(const float*, const float*, float*, std::size_t);
+        typedef bool (*FloatScanKernel)(const float*, std::size_t);
+        typedef void (*NarrowKernel)(const float*, std::uint16_t*, std::size_t);
+        typedef void (*WidenKernel)(const std::uint16_t*, float*, std::size_t);
+
+        struct FloatKernels {
+            const char* name;
+            FloatBinaryKernel add;
+            FloatBinaryKernel subtract;
+            FloatBinaryKernel multiply;
+            FloatBinaryKernel divide;
+            FloatScanKernel containsZero;
+            NarrowKernel toHalf;
+            WidenKernel fromHalf;
+            NarrowKernel toBFloat16;
+            WidenKernel fromBFloat16;
+        };
+
+        // 16-bit operands are widened a block at a time into stack buffers
+        const std::size_t blockSize = 256;
+
+        std::uint32_t floatBits(float value) {
+            std::uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        }
+
+        float bitsToFloat(std::uint32_t bits) {
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        // float -> binary16 with round-to-nearest-even. NaNs stay NaN, quieted,
+        // keeping the top payload bits, which is what F16C does.
+        std::uint16_t toHalfBits(float value) {
+            const std::uint32_t bits = floatBits(value);
+            const std::uint32_t sign = (bits >> 16) & 0x8000u;
+            const std::uint32_t magnitude = bits & 0x7fffffffu;
+            if (magnitude > 0x7f800000u) {
+                return static_cast<std::uint16_t>(sign | 0x7e00u | ((magnitude >> 13) & 0x3ffu));
+            }
+            if (magnitude >= 0x477ff000u) {
+                // 65520 and above round past the largest half, 65504
+                return static_cast<std::uint16_t>(sign | 0x7c00u);
+            }
+            if (magnitude < 0x38800000u) {
+                // Below 2^-14 the result is subnormal, in units of 2^-24
+                if (magnitude <= 0x33000000u) {
+                    return static_cast<std::uint16_t>(sign); // at most half a unit: ties to zero
+                }
+                const std::uint32_t significand = (magnitude & 0x7fffffu) | 0x800000u;
+                const unsigned shift = 126u - (magnitude >> 23);
+                std::uint32_t units = significand >> shift;
+                const std::uint32_t rest = significand & ((1u << shift) - 1u);
+                const std::uint32_t halfway = 1u << (shift - 1u);
+                if (rest > halfway || (rest == halfway && (units & 1u))) {
+                    ++units;
+                }
+                return static_cast<std::uint16_t>(sign | units);
+            }
+            // Rebias the exponent from 127 to 15; a carry out of the significand
+            // correctly moves to the next binade
+            std::uint32_t half = (magnitude - 0x38000000u) >> 13;
+            const std::uint32_t rest = magnitude & 0x1fffu;
+            if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+                ++half;
+            }
+            return static_cast<std::uint16_t>(sign | half);
+        }
+
+        float fromHalfBits(std::uint16_t half) {
+            const std::uint32_t sign = static_cast<std::uint32_t>(half & 0x8000u) << 16;
+            const std::uint32_t exponent = (half >> 10) & 0x1fu;
+            const std::uint32_t significand = half & 0x3ffu;
+            if (exponent == 0x1fu) {
+                return bitsToFloat(sign | 0x7f800000u | (significand << 13) | (significand != 0 ? 0x400000u : 0u));
+            }
+            if (exponent == 0) {
+                // Zero or subnormal: significand * 2^-24 is exact in float
+                const float magnitude = static_cast<float>(significand) * 5.9604644775390625e-8f;
+                return bitsToFloat(sign | floatBits(magnitude));
+            }
+            return bitsToFloat(sign | ((exponent + 112u) << 23) | (significand << 13));
+        }
+
+        void toHalfScalar(const float* in, std::uint16_t* out, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                out[i] = toHalfBits(in[i]);
+            }
+        }
+
+        void fromHalfScalar(const std::uint16_t* in, float* out, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                out[i] = fromHalfBits(in[i]);
+            }
+        }
+
+        // bfloat16 is the top half of a float, so narrowing is an integer
+        // round-to-nearest-even on the low 16 bits and widening is a shift. The
+        // loops are branch-free so that each tier's compiler vectorizes them.
+#define MATHUTILS_BFLOAT16_KERNELS(suffix, attributes)                                       \
+        attributes void toBFloat16##suffix(const float* in, std::uint16_t* out, std::size_t n) { \
+            for (std::size_t i = 0; i < n; ++i) {                                            \
+                std::uint32_t bits;                                                          \
+                std::memcpy(&bits, in + i, sizeof(bits));                                    \
+                const std::uint32_t rounded = (bits + 0x7fffu + ((bits >> 16) & 1u)) >> 16;   \
+                const std::uint32_t quietNan = (bits >> 16) | 0x40u;                         \
+                out[i] = static_cast<std::uint16_t>((bits & 0x7fffffffu) > 0x7f800000u ? quietNan : rounded); \
+            }                                                                                \
+        }                                                                                    \
+        attributes void fromBFloat16##suffix(const std::uint16_t* in, float* out, std::size_t n) { \
+            for (std::size_t i = 0; i < n; ++i) {                                            \
+                const std::uint32_t bits = static_cast<std::uint32_t>(in[i]) << 16;          \
+                std::memcpy(out + i, &bits, sizeof(bits));                                   \
+            }                                                                                \
+        }
+
+        MATHUTILS_BFLOAT16_KERNELS(Scalar, )
+
+        // One IEEE-754 single-precision operation per element on every tier
+#define MATHUTILS_FLOAT_SCALAR_KERNEL(name, op)                                        \
+        void name##Scalar(const float* a, const float* b, float* out, std::size_t n) { \
+            for (std::size_t i = 0; i < n; ++i) {                                      \
+                out[i] = a[i] op b[i];                                                 \
+            }                                                                          \
+        }
+
+        MATHUTILS_FLOAT_SCALAR_KERNEL(add, +)
+        MATHUTILS_FLOAT_SCALAR_KERNEL(subtract, -)
+        MATHUTILS_FLOAT_SCALAR_KERNEL(multiply, *)
+        MATHUTILS_FLOAT_SCALAR_KERNEL(divide, /)
+
+        bool containsZeroScalar(const float* values, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                if (values[i] == 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        const FloatKernels scalarKernels = {
+            "scalar", addScalar, subtractScalar, multiplyScalar, divideScalar, containsZeroScalar,
+            toHalfScalar, fromHalfScalar, toBFloat16Scalar, fromBFloat16Scalar
+        };
+
+#if defined(MATHUTILS_HAVE_SSE2)
+#define MATHUTILS_SSE_FLOAT_KERNEL(name, op, intrinsic)                               \
+        void name##Sse(const float* a, const float* b, float* out, std::size_t n) {   \
+            std::size_t i = 0;                                                        \
+            for (; i + 4 <= n; i += 4) {                                              \
+                _mm_storeu_ps(out + i, intrinsic(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i))); \
+            }                                                                         \
+            for (; i < n; ++i) {                                                      \
+                out[i] = a[i] op b[i];                                                \
+            }                                                                         \
+        }
+
+        MATHUTILS_SSE_FLOAT_KERNEL(add, +, _mm_add_ps)
+        MATHUTILS_SSE_FLOAT_KERNEL(subtract, -, _mm_sub_ps)
+        MATHUTILS_SSE_FLOAT_KERNEL(multiply, *, _mm_mul_ps)
+        MATHUTILS_SSE_FLOAT_KERNEL(divide, /, _mm_div_ps)
+
+        bool containsZeroSse(const float* values, std::size_t n) {
+            const __m128 zero = _mm_setzero_ps();
+            __m128 found = _mm_setzero_ps();
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                found = _mm_or_ps(found, _mm_cmpeq_ps(_mm_loadu_ps(values + i), zero));
+            }
+            return _mm_movemask_ps(found) != 0 || containsZeroScalar(values + i, n - i);
+        }
+
+        // The SSE2 baseline has no half conversion instructions
+        const FloatKernels sseKernels = {
+            "sse", addSse, subtractSse, multiplySse, divideSse, containsZeroSse,
+            toHalfScalar, fromHalfScalar, toBFloat16Scalar, fromBFloat16Scalar
+        };
+#endif
+
+#if defined(MATHUTILS_X86_DISPATCH)
+#define MATHUTILS_AVX2_FLOAT_KERNEL(name, op, intrinsic)                              \
+        __attribute__((target("avx2")))                                               \
+        void name##Avx2(const float* a, const float* b, float* out, std::size_t n) {  \
+            std::size_t i = 0;                                                        \
+            for (; i + 8 <= n; i += 8) {                                              \
+                _mm256_storeu_ps(out + i, intrinsic(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i))); \
+            }                                                                         \
+            for (; i < n; ++i) {                                                      \
+                out[i] = a[i] op b[i];                                                \
+            }                                                                         \
+        }
+
+        MATHUTILS_AVX2_FLOAT_KERNEL(add, +, _mm256_add_ps)
+        MATHUTILS_AVX2_FLOAT_KERNEL(subtract, -, _mm256_sub_ps)
+        MATHUTILS_AVX2_FLOAT_KERNEL(multiply, *, _mm256_mul_ps)
+        MATHUTILS_AVX2_FLOAT_KERNEL(divide, /, _mm256_div_ps)
+
+        __attribute__((target("avx2")))
+        bool containsZeroAvx2(const float* values, std::size_t n) {
+            const __m256 zero = _mm256_setzero_ps();
+            __m256 found = _mm256_setzero_ps();
+            std::size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                found = _mm256_or_ps(found, _mm256_cmp_ps(_mm256_loadu_ps(values + i), zero, _CMP_EQ_OQ));
+            }
+            return _mm256_movemask_ps(found) != 0 || containsZeroScalar(values + i, n - i);
+        }
+
+        __attribute__((target("avx2,f16c")))
+        void toHalfF16c(const float* in, std::uint16_t* out, std::size_t n) {
+            std::size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                const __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), half);
+            }
+            toHalfScalar(in + i, out + i, n - i);
+        }
+
+        __attribute__((target("avx2,f16c")))
+        void fromHalfF16c(const std::uint16_t* in, float* out, std::size_t n) {
+            std::size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                const __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                _mm256_storeu_ps(out + i, _mm256_cvtph_ps(half));
+            }
+            fromHalfScalar(in + i, out + i, n - i);
+        }
+
+        MATHUTILS_BFLOAT16_KERNELS(Avx2, __attribute__((target("avx2"))))
+
+        const FloatKernels avx2Kernels = {
+            "avx2+f16c", addAvx2, subtractAvx2, multiplyAvx2, divideAvx2, containsZeroAvx2,
+            toHalfF16c, fromHalfF16c, toBFloat16Avx2, fromBFloat16Avx2
+        };
+
+        // Like the double kernels, AVX-512 finishes with a zero-masked operation
+#define MATHUTILS_AVX512_FLOAT_KERNEL(name, intrinsic, maskedIntrinsic)               \
+        __attribute__((target("avx512f")))                                            \
+        void name##Avx512(const float* a, const float* b, float* out, std::size_t n) { \
+            std::size_t i = 0;                                                        \
+            for (; i + 16 <= n; i += 16) {                                            \
+                _mm512_storeu_ps(out + i, intrinsic(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i))); \
+            }                                                                         \
+            if (i < n) {                                                              \
+                const __mmask16 tail = static_cast<__mmask16>((1u << (n - i)) - 1u);  \
+                const __m512 va = _mm512_maskz_loadu_ps(tail, a + i);                 \
+                const __m512 vb = _mm512_maskz_loadu_ps(tail, b + i);                 \
+                _mm512_mask_storeu_ps(out + i, tail, maskedIntrinsic(tail, va, vb));  \
+            }                                                                         \
+        }
+
+        MATHUTILS_AVX512_FLOAT_KERNEL(add, _mm512_add_ps, _mm512_maskz_add_ps)
+        MATHUTILS_AVX512_FLOAT_KERNEL(subtract, _mm512_sub_ps, _mm512_maskz_sub_ps)
+        MATHUTILS_AVX512_FLOAT_KERNEL(multiply, _mm512_mul_ps, _mm512_maskz_mul_ps)
+        MATHUTILS_AVX512_FLOAT_KERNEL(divide, _mm512_div_ps, _mm512_maskz_div_ps)
+
+        __attribute__((target("avx512f")))
+        bool containsZeroAvx512(const float* values, std::size_t n) {
+            const __m512 zero = _mm512_setzero_ps();
+            __mmask16 found = 0;
+            std::size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                found |= _mm512_cmp_ps_mask(_mm512_loadu_ps(values + i), zero, _CMP_EQ_OQ);
+            }
+            if (i < n) {
+                const __mmask16 tail = static_cast<__mmask16>((1u << (n - i)) - 1u);
+                found |= _mm512_mask_cmp_ps_mask(tail, _mm512_maskz_loadu_ps(tail, values + i), zero, _CMP_EQ_OQ);
+            }
+            return found != 0;
+        }
+
+        __attribute__((target("avx512f")))
+        void toHalfAvx512(const float* in, std::uint16_t* out, std::size_t n) {
+            std::size_t i = 0;
+            // Zero-masked with all lanes enabled, as in MathUtils.cpp, to avoid a
+            // spurious -Wmaybe-uninitialized from GCC's unmasked conversions
+            for (; i + 16 <= n; i += 16) {
+                const __m256i half =
+                    _mm512_maskz_cvtps_ph(0xffff, _mm512_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), half);
+            }
+            toHalfScalar(in + i, out + i, n - i);
+        }
+
+        __attribute__((target("avx512f")))
+        void fromHalfAvx512(const std::uint16_t* in, float* out, std::size_t n) {
+            std::size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                const __m256i half = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+                _mm512_storeu_ps(out + i, _mm512_maskz_cvtph_ps(0xffff, half));
+            }
+            fromHalfScalar(in + i, out + i, n - i);
+        }
+
+        // AVX512-BF16's conversion flushes subnormals, so bfloat16 stays on the
+        // integer rounding, vectorized for this tier
+        MATHUTILS_BFLOAT16_KERNELS(Avx512, __attribute__((target("avx512f,avx512bw"))))
+
+        const FloatKernels avx512Kernels = {
+            "avx512", addAvx512, subtractAvx512, multiplyAvx512, divideAvx512, containsZeroAvx512,
+            toHalfAvx512, fromHalfAvx512, toBFloat16Avx512, fromBFloat16Avx512
+        };
+#endif
+
+#if defined(MATHUTILS_NEON)
+#define MATHUTILS_NEON_FLOAT_KERNEL(name, op, intrinsic)                              \
+        void name##Neon(const float* a, const float* b, float* out, std::size_t n) {  \
+            std::size_t i = 0;                                                        \
+            for (; i + 4 <= n; i += 4) {                                              \
+                vst1q_f32(out + i, intrinsic(vld1q_f32(a + i), vld1q_f32(b + i)));    \
+            }                                                                         \
+            for (; i < n; ++i) {                                                      \
+                out[i] = a[i] op b[i];                                                \
+            }                                                                         \
+        }
+
+        MATHUTILS_NEON_FLOAT_KERNEL(add, +, vaddq_f32)
+        MATHUTILS_NEON_FLOAT_KERNEL(subtract, -, vsubq_f32)
+        MATHUTILS_NEON_FLOAT_KERNEL(multiply, *, vmulq_f32)
+        MATHUTILS_NEON_FLOAT_KERNEL(divide, /, vdivq_f32)
+
+        bool containsZeroNeon(const float* values, std::size_t n) {
+            uint32x4_t found = vdupq_n_u32(0);
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                found = vorrq_u32(found, vceqzq_f32(vld1q_f32(values + i)));
+            }
+            return vmaxvq_u32(found) != 0 || containsZeroScalar(values + i, n - i);
+        }
+
+        void toHalfNeon(const float* in, std::uint16_t* out, std::size_t n) {
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                vst1_u16(out + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(in + i))));
+            }
+            toHalfScalar(in + i, out + i, n - i);
+        }
+
+        void fromHalfNeon(const std::uint16_t* in, float* out, std::size_t n) {
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                vst1q_f32(out + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(in + i))));
+            }
+            fromHalfScalar(in + i, out + i, n - i);
+        }
+
+        const FloatKernels neonKernels = {
+            "neon", addNeon, subtractNeon, multiplyNeon, divideNeon, containsZeroNeon,
+            toHalfNeon, fromHalfNeon, toBFloat16Scalar, fromBFloat16Scalar
+        };
+#endif
+
+        const FloatKernels& selectKernels() {
+#if defined(MATHUTILS_X86_DISPATCH)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+                return avx512Kernels;
+            }
+            if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c")) {
+                return avx2Kernels;
+            }
+#endif
+#if defined(MATHUTILS_HAVE_SSE2)
+            return sseKernels;
+#elif defined(MATHUTILS_NEON)
+            return neonKernels;
+#else
+            return scalarKernels;
+#endif
+        }
+
+        const FloatKernels& kernels() {
+            static const FloatKernels& selected = selectKernels();
+            return selected;
+        }
+
+        // Element access for the 16-bit formats, so one template serves both
+        void narrow(const FloatKernels& k, const float* in, Half* out, std::size_t n) {
+            k.toHalf(in, &out->bits, n);
+        }
+
+        void narrow(const FloatKernels& k, const float* in, BFloat16* out, std::size_t n) {
+            k.toBFloat16(in, &out->bits, n);
+        }
+
+        void widen(const FloatKernels& k, const Half* in, float* out, std::size_t n) {
+            k.fromHalf(&in->bits, out, n);
+        }
+
+        void widen(const FloatKernels& k, const BFloat16* in, float* out, std::size_t n) {
+            k.fromBFloat16(&in->bits, out, n);
+        }
+
+        /**
+         * @brief Applies a float kernel to 16-bit operands a block at a time
+         * @param a First operands
+         * @param b Second operands
+         * @param out Results; may alias a or b, since each block is widened first
+         * @param n Number of elements
+         * @param op Selects the float kernel from the kernel set
+         */
+        template <typename Format>
+        void narrowBinary(const Format* a, const Format* b, Format* out, std::size_t n,
+                          FloatBinaryKernel FloatKernels::*op) {
+            static_assert(sizeof(Format) == sizeof(std::uint16_t), "16-bit formats are stored as their bits");
+            const FloatKernels& k = kernels();
+            float wideA[blockSize];
+            float wideB[blockSize];
+            for (std::size_t start = 0; start < n; start += blockSize) {
+                const std::size_t count = n - start < blockSize ? n - start : blockSize;
+                widen(k, a + start, wideA, count);
+                widen(k, b + start, wideB, count);
+                (k.*op)(wideA, wideB, wideA, count);
+                narrow(k, wideA, out + start, count);
+            }
+        }
+
+        // Zero in either sign is all bits clear apart from the sign bit in both formats
+        template <typename Format>
+        void checkDivisors(const Format* divisors, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                if ((divisors[i].bits & 0x7fffu) == 0) {
+                    throw std::runtime_error("Division by zero error");
+                }
+            }
+        }
+
+        const std::size_t maskBits = 64;
+    }
+
+    void MathUtils::add(const float* a, const float* b, float* out, std::size_t n) {
+        kernels().add(a, b, out, n);
+    }
+
+    void MathUtils::subtract(const float* a, const float* b, float* out, std::size_t n) {
+        kernels().subtract(a, b, out, n);
+    }
+
+    void MathUtils::multiply(const float* a, const float* b, float* out, std::size_t n) {
+        kernels().multiply(a, b, out, n);
+    }
+
+    // A zero divisor anywhere throws before out is written, as for doubles
+    void MathUtils::divide(const float* a, const float* b, float* out, std::size_t n) {
+        const FloatKernels& k = kernels();
+        if (k.containsZero(b, n)) {
+            throw std::runtime_error("Division by zero error");
+        }
+        k.divide(a, b, out, n);
+    }
+
+    void MathUtils::add(float* a, const float* b, std::size_t n) {
+        add(a, b, a, n);
+    }
+
+    void MathUtils::subtract(float* a, const float* b, std::size_t n) {
+        subtract(a, b, a, n);
+    }
+
+    void MathUtils::multiply(float* a, const float* b, std::size_t n) {
+        multiply(a, b, a, n);
+    }
+
+    void MathUtils::divide(float* a, const float* b, std::size_t n) {
+        divide(a, b, a, n);
+    }
+
+    // The square-and-multiply sequence of the double version, in float
+    void MathUtils::power(const float* base, int exponent, float* out, std::size_t n) {
+        const FloatKernels& k = kernels();
+        float square[blockSize];
+        const unsigned int magnitude = exponent < 0 ? 0u - static_cast<unsigned int>(exponent)
+                                                    : static_cast<unsigned int>(exponent);
+
+        for (std::size_t start = 0; start < n; start += blockSize) {
+            const std::size_t count = n - start < blockSize ? n - start : blockSize;
+            float* result = out + start;
+            for (std::size_t i = 0; i < count; ++i) {
+                square[i] = base[start + i];
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                result[i] = 1.0f;
+            }
+
+            unsigned int remaining = magnitude;
+            while (remaining != 0) {
+                if (remaining & 1u) {
+                    k.multiply(result, square, result, count);
+                }
+                remaining >>= 1;
+                if (remaining != 0) {
+                    k.multiply(square, square, square, count);
+                }
+            }
+
+            if (exponent < 0) {
+                for (std::size_t i = 0; i < count; ++i) {
+                    result[i] = 1.0f / result[i];
+                }
+            }
+        }
+    }
+
+    void MathUtils::power(float* base, int exponent, std::size_t n) {
+        power(base, exponent, base, n);
+    }
+
+    // Every float is exactly a double, so these classify like the double masks
+    void MathUtils::parityMasks(const float* values, std::size_t n, std::uint64_t* even, std::uint64_t* odd) {
+        for (std::size_t word = 0; word * maskBits < n; ++word) {
+            const std::size_t start = word * maskBits;
+            const std::size_t count = n - start < maskBits ? n - start : maskBits;
+            std::uint64_t evenBits = 0;
+            std::uint64_t oddBits = 0;
+            for (std::size_t bit = 0; bit < count; ++bit) {
+                const double value = values[start + bit];
+                evenBits |= static_cast<std::uint64_t>(isEven(value)) << bit;
+                oddBits |= static_cast<std::uint64_t>(isOdd(value)) << bit;
+            }
+            even[word] = evenBits;
+            odd[word] = oddBits;
+        }
+    }
+
+    void MathUtils::signMasks(const float* values, std::size_t n, std::uint64_t* positive, std::uint64_t* zero,
+                              std::uint64_t* negative) {
+        for (std::size_t word = 0; word * maskBits < n; ++word) {
+            const std::size_t start = word * maskBits;
+            const std::size_t count = n - start < maskBits ? n - start : maskBits;
+            std::uint64_t positiveBits = 0;
+            std::uint64_t zeroBits = 0;
+            std::uint64_t negativeBits = 0;
+            for (std::size_t bit = 0; bit < count; ++bit) {
+                const float value = values[start + bit];
+                positiveBits |= static_cast<std::uint64_t>(value > 0) << bit;
+                zeroBits |= static_cast<std::uint64_t>(value == 0) << bit;
+                negativeBits |= static_cast<std::uint64_t>(value < 0) << bit;
+            }
+            positive[word] = positiveBits;
+            zero[word] = zeroBits;
+            negative[word] = negativeBits;
+        }
+    }
+
+    void MathUtils::add(const Half* a, const Half* b, Half* out, std::size_t n) {
+        narrowBinary(a, b, out, n, &FloatKernels::add);
+    }
+
+    void MathUtils::subtract(const Half* a, const Half* b, Half* out, std::size_t n) {
+        narrowBinary(a, b, out, n, &FloatKernels::subtract);
+    }
+
+    void MathUtils::multiply(const Half* a, const Half* b, Half* out, std::size_t n) {
+        narrowBinary(a, b, out, n, &FloatKernels::multiply);
+    }
+
+    void MathUtils::divide(const Half* a, const Half* b, Half* out, std::size_t n) {
+        checkDivisors(b, n);
+        narrowBinary(a, b, out, n, &FloatKernels::divide);
+    }
+
+    void MathUtils::add(const BFloat16* a, const BFloat16* b, BFloat16* out, std::size_t n) {
+        narrowBinary(a, b, out, n, &FloatKernels::add);
+    }
+
+    void MathUtils::subtract(const BFloat16* a, const BFloat16* b, BFloat16* out, std::size_t n) {
+        narrowBinary(a, b, out, n, &FloatKernels::subtract);
+    }
+
+    void MathUtils::multiply(const BFloat16* a, const BFloat16* b, BFloat16* out, std::size_t n) {
+        narrowBinary(a, b, out, n, &FloatKernels::multiply);
+    }
+
+    void MathUtils::divide(const BFloat16* a, const BFloat16* b, BFloat16* out, std::size_t n) {
+        checkDivisors(b, n);
+        narrowBinary(a, b, out, n, &FloatKernels::divide);
+    }
+
+    void MathUtils::convert(const float* in, Half* out, std::size_t n) {
+        narrow(kernels(), in, out, n);
+    }
+
+    void MathUtils::convert(const Half* in, float* out, std::size_t n) {
+        widen(kernels(), in, out, n);
+    }
+
+    void MathUtils::convert(const float* in, BFloat16* out, std::size_t n) {
+        narrow(kernels(), in, out, n);
+    }
+
+    void MathUtils::convert(const BFloat16* in, float* out, std::size_t n) {
+        widen(kernels(), in, out, n);
+    }
+
+    // Plain conversion loops, which compilers vectorize at any ISA level
+    void MathUtils::convert(const double* in, float* out, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = static_cast<float>(in[i]);
+        }
+    }
+
+    void MathUtils::convert(const float* in, double* out, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = in[i];
+        }
+    }
+
+#define MATHUTILS_PRECISION_DISPATCH(name)                                                              \
+    void MathUtils::name(Precision precision, const void* a, const void* b, void* out, std::size_t n) { \
+        switch (precision) {                                                                            \
+        case Precision::Double:                                                                         \
+            name(static_cast<const double*>(a), static_cast<const double*>(b), static_cast<double*>(out), n); \
+            break;                                                                                      \
+        case Precision::Float:                                                                          \
+            name(static_cast<const float*>(a), static_cast<const float*>(b), static_cast<float*>(out), n); \
+            break;                                                                                      \
+        case Precision::Half:                                                                           \
+            name(static_cast<const Half*>(a), static_cast<const Half*>(b), static_cast<Half*>(out), n); \
+            break;                                                                                      \
+        case Precision::BFloat16:                                                                       \
+            name(static_cast<const BFloat16*>(a), static_cast<const BFloat16*>(b), static_cast<BFloat16*>(out), n); \
+            break;                                                                                      \
+        default:                                                                                        \
+            throw std::invalid_argument("Unknown precision");                                           \
+        }                                                                                               \
+    }
+
+    MATHUTILS_PRECISION_DISPATCH(add)
+    MATHUTILS_PRECISION_DISPATCH(subtract)
+    MATHUTILS_PRECISION_DISPATCH(multiply)
+    MATHUTILS_PRECISION_DISPATCH(divide)
+
+    const char* MathUtils::floatInstructionSet() {
+        return kernels().name;
+    }
+}
@@ -0,0 +1,33 @@
+#include "MemoCache.h"
+#include "MathUtils.h"
+
+namespace Utils {
+    /**
+     * @brief Constructor - Creates an empty power cache
+     * @param capacity Most (base, exponent) pairs to remember
+     * @param shards Number of independently locked shards
+     */
+    PowerCache::PowerCache(std::size_t capacity, std::size_t shards) : cache(capacity, shards) {}
+
+    /**
+     * @brief Raises base to an integer power, reusing a cached result when there is one
+     * @param base The base
+     * @param exponent The exponent
+     * @return MathUtils::power(base, exponent)
+     */
+    double PowerCache::power(double base, int exponent) {
+        if (exponent >= -uncachedExponent && exponent <= uncachedExponent) {
+            return MathUtils::power(base, exponent);
+        }
+        const PowerKey key = {doubleBits(base), exponent};
+        return cache.getOrCompute(key, [base, exponent]() { return MathUtils::power(base, exponent); });
+    }
+
+    CacheStats PowerCache::getStats() const {
+        return cache.getStats();
+    }
+
+    void PowerCache::clear() {
+        cache.clear();
+    }
+}
@@ -0,0 +1,171 @@
+#include "OperationJournal.h"
+#include "MathUtils.h"
+#include <stdexcept>
+
+/**
+ * @brief Constructor - Allocates the ring buffer once
+ * @param capacity Maximum number of entries retained (at least 1)
+ * @param initialValue The value the journal replays from
+ * @param resource Supplies the ring buffer
+ */
+OperationJournal::OperationJournal(std::size_t capacity, double initialValue, std::pmr::memory_resource* resource)
+    : entries(capacity != 0 ? capacity : 1, JournalEntry(), resource),
+      capacity(capacity != 0 ? capacity : 1),
+      head(0),
+      count(0),
+      cursor(0),
+      baseValue(initialValue) {}
+
+/**
+ * @brief Maps a logical index to the ring buffer
+ * @param index 0 for the oldest retained entry
+ * @return The entry at that position
+ */
+const JournalEntry& OperationJournal::at(std::size_t index) const {
+    return entries[(head + index) % capacity];
+}
+
+/**
+ * @brief Appends an operation to the journal
+ * @param operation The operation performed
+ * @param operand The operand (the exponent for Power)
+ * Undone entries are dropped. If the buffer is full, the oldest entry is
+ * applied to the base value and its slot reused.
+ */
+void OperationJournal::record(Operation operation, double operand) {
+    if (operation == Operation::Power && !isValidExponent(operand)) {
+        throw std::invalid_argument("Exponent must be an integer");
+    }
+    count = cursor;
+    if (count == capacity) {
+        baseValue = replay(baseValue, &at(0), 1);
+        head = (head + 1) % capacity;
+        --count;
+        --cursor;
+    }
+
+    JournalEntry& slot = entries[(head + count) % capacity];
+    slot.operand = operand;
+    slot.operation = operation;
+    for (std::size_t i = 0; i < sizeof(slot.reserved); ++i) {
+        slot.reserved[i] = 0;
+    }
+    ++count;
+    ++cursor;
+}
+
+/**
+ * @brief Steps back over the most recently applied entry
+ * @return false if there is nothing left to undo
+ */
+bool OperationJournal::undo() {
+    if (cursor == 0) {
+        return false;
+    }
+    --cursor;
+    return true;
+}
+
+/**
+ * @brief Re-applies the most recently undone entry
+ * @return false if there is nothing to redo
+ */
+bool OperationJournal::redo() {
+    if (cursor == count) {
+        return false;
+    }
+    ++cursor;
+    return true;
+}
+
+bool OperationJournal::canUndo() const {
+    return cursor != 0;
+}
+
+bool OperationJournal::canRedo() const {
+    return cursor != count;
+}
+
+/**
+ * @brief Computes the value after all applied entries
+ * @return The replayed value; the ring is replayed as at most two contiguous runs
+ */
+double OperationJournal::value() const {
+    const std::size_t firstRun = capacity - head < cursor ? capacity - head : cursor;
+    const double partial = replay(baseValue, &entries[head], firstRun);
+    return replay(partial, &entries[0], cursor - firstRun);
+}
+
+/**
+ * @brief Empties the journal
+ * @param initialValue The new base value
+ */
+void OperationJournal::clear(double initialValue) {
+    head = 0;
+    count = 0;
+    cursor = 0;
+    baseValue = initialValue;
+}
+
+/**
+ * @brief Gets the number of applied entries
+ * @return Entries that value() replays
+ */
+std::size_t OperationJournal::size() const {
+    return cursor;
+}
+
+std::size_t OperationJournal::getCapacity() const {
+    return capacity;
+}
+
+double OperationJournal::getBaseValue() const {
+    return baseValue;
+}
+
+const JournalEntry& OperationJournal::entry(std::size_t index) const {
+    return at(index);
+}
+
+/**
+ * @brief Applies raw journal entries to a value
+ * @param initialValue The value before the first entry
+ * @param entries The entries to apply, oldest first
+ * @param n Number of entries
+ * @return The resulting value, bit-for-bit what a PlainAccumulate calculator holds
+ */
+double OperationJournal::replay(double initialValue, const JournalEntry* entries, std::size_t n) {
+    double value = initialValue;
+    for (std::size_t i = 0; i < n; ++i) {
+        const double operand = entries[i].operand;
+        switch (entries[i].operation) {
+        case Operation::Add:
+            value = Utils::MathUtils::add(value, operand);
+            break;
+        case Operation::Subtract:
+            value = Utils::MathUtils::subtract(value, operand);
+            break;
+        case Operation::Multiply:
+            value = Utils::MathUtils::multiply(value, operand);
+            break;
+        case Operation::Divide:
+            if (operand != 0) {
+                value = Utils::MathUtils::divide(value, operand);
+            }
+            break;
+        case Operation::Power:
+            if (!isValidExponent(operand)) {
+                throw std::runtime_error("Exponent must be an integer");
+            }
+            value = Utils::MathUtils::power(value, static_cast<int>(operand));
+            break;
+        case Operation::Reset:
+            value = 0.0;
+            break;
+        default:
+            // Initialized and DivisionError leave the value unchanged
+            break;
+        }
+    }
+    return value;
+}
@@ -0,0 +1,221 @@
+#include "ParallelReduce.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace Utils {
+    namespace {
+        // Helper threads kept for the life of the process, so a reduction
+        // wakes sleeping threads instead of creating and joining new ones.
+        // One reduction uses the pool at a time; a reduction that finds it
+        // busy runs on its caller alone, which gives the same result.
+        class ReducePool {
+        private:
+            std::mutex runMutex; // held by the reduction using the pool
+            std::mutex mutex;
+            std::condition_variable wake;
+            std::condition_variable idle;
+            std::vector<std::thread> threads;
+            const std::function<void()>* job; // guarded by mutex
+            unsigned wanted;                  // helpers still to join job, guarded by mutex
+            unsigned active;                  // helpers running job, guarded by mutex
+            std::uint64_t generation;         // guarded by mutex
+            bool quit;                        // guarded by mutex
+
+            void serve() {
+                std::unique_lock<std::mutex> lock(mutex);
+                std::uint64_t seen = generation;
+                for (;;) {
+                    wake.wait(lock, [&]() { return quit || (generation != seen && wanted != 0); });
+                    if (quit) {
+                        return;
+                    }
+                    seen = generation;
+                    --wanted;
+                    ++active;
+                    const std::function<void()>& current = *job;
+                    lock.unlock();
+                    current();
+                    lock.lock();
+                    if (--active == 0) {
+                        idle.notify_one();
+                    }
+                }
+            }
+
+        public:
+            ReducePool() : job(nullptr), wanted(0), active(0), generation(0), quit(false) {}
+
+            ~ReducePool() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    quit = true;
+                }
+                wake.notify_all();
+                for (std::size_t i = 0; i < threads.size(); ++i) {
+                    threads[i].join();
+                }
+            }
+
+            static ReducePool& instance() {
+                static ReducePool pool;
+                return pool;
+            }
+
+            /**
+             * @brief Runs a job on the caller and up to helpers pool threads
+             * @param work Claims and processes chunks until none are left
+             * @param helpers Threads wanted besides the caller; the pool grows to match
+             * Returns once every thread that joined has finished. A helper that
+             * joins late finds no chunks left and returns at once.
+             */
+            void run(const std::function<void()>& work, unsigned helpers) {
+                std::unique_lock<std::mutex> running(runMutex, std::try_to_lock);
+                if (!running.owns_lock()) {
+                    work();
+                    return;
+                }
+                while (threads.size() < helpers) {
+                    try {
+                        threads.emplace_back(&ReducePool::serve, this);
+                    } catch (const std::system_error&) {
+                        // Out of threads: the ones already running share the chunks
+                        break;
+                    }
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    job = &work;
+                    wanted = helpers < threads.size() ? helpers : static_cast<unsigned>(threads.size());
+                    ++generation;
+                }
+                wake.notify_all();
+                work();
+                std::unique_lock<std::mutex> lock(mutex);
+                wanted = 0;
+                idle.wait(lock, [&]() { return active == 0; });
+                job = nullptr;
+            }
+        };
+
+        enum class Reduction {
+            Sum,
+            Product
+        };
+
+        // Partial result of one chunk; carry is only used by compensated sums
+        struct Partial {
+            double value;
+            double carry;
+        };
+
+        Partial reduceChunk(Reduction reduction, Summation summation, const double* values, std::size_t n) {
+            Partial partial = {0.0, 0.0};
+            if (reduction == Reduction::Product) {
+                partial.value = MathUtils::product(values, n);
+            } else if (summation == Summation::Compensated) {
+                MathUtils::accumulateCompensated(values, n, partial.value, partial.carry);
+            } else {
+                partial.value = MathUtils::sum(values, n, summation);
+            }
+            return partial;
+        }
+
+        /**
+         * @brief Combines chunk partials in chunk order
+         * @param reduction Whether the partials are sums or products
+         * @param summation How sums are combined, matching the per-chunk mode
+         * @param partials One partial per chunk
+         * @return The final result
+         */
+        double combine(Reduction reduction, Summation summation, const std::vector<Partial>& partials) {
+            if (reduction == Reduction::Product) {
+                double total = 1.0;
+                for (std::size_t i = 0; i < partials.size(); ++i) {
+                    total *= partials[i].value;
+                }
+                return total;
+            }
+
+            if (summation == Summation::Compensated) {
+                // Compensated-add the chunk sums, and carry their carries along
+                double total = 0.0;
+                double carry = 0.0;
+                for (std::size_t i = 0; i < partials.size(); ++i) {
+                    MathUtils::compensatedAdd(total, carry, partials[i].value);
+                    carry += partials[i].carry;
+                }
+                return total + carry;
+            }
+
+            std::vector<double> values(partials.size());
+            for (std::size_t i = 0; i < partials.size(); ++i) {
+                values[i] = partials[i].value;
+            }
+            return MathUtils::sum(values.data(), values.size(), summation);
+        }
+
+        double reduce(Reduction reduction, const double* values, std::size_t n, const ReduceOptions& options) {
+            const std::size_t chunkSize = options.chunkSize != 0 ? options.chunkSize : 1;
+            const std::size_t chunks = (n + chunkSize - 1) / chunkSize;
+            if (chunks <= 1) {
+                return combine(reduction, options.summation,
+                               std::vector<Partial>(1, reduceChunk(reduction, options.summation, values, n)));
+            }
+
+            unsigned threads = options.threads != 0 ? options.threads : std::thread::hardware_concurrency();
+            if (threads == 0) {
+                threads = 1;
+            }
+            if (threads > chunks) {
+                threads = static_cast<unsigned>(chunks);
+            }
+
+            std::vector<Partial> partials(chunks);
+            std::atomic<std::size_t> nextChunk(0);
+            // Threads keep claiming the next unprocessed chunk, which balances
+            // load without affecting where chunk boundaries fall.
+            const std::function<void()> worker = [&]() {
+                for (;;) {
+                    const std::size_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed);
+                    if (chunk >= chunks) {
+                        return;
+                    }
+                    const std::size_t begin = chunk * chunkSize;
+                    const std::size_t count = n - begin < chunkSize ? n - begin : chunkSize;
+                    partials[chunk] = reduceChunk(reduction, options.summation, values + begin, count);
+                }
+            };
+
+            ReducePool::instance().run(worker, threads - 1);
+            return combine(reduction, options.summation, partials);
+        }
+    }
+
+    /**
+     * @brief Sums a large array across threads
+     * @param values The values to sum
+     * @param n Number of values
+     * @param options Summation mode, thread count and chunk size
+     * @return The sum; identical for every thread count given the same options
+     */
+    double ParallelReduce::sum(const double* values, std::size_t n, const ReduceOptions& options) {
+        return reduce(Reduction::Sum, values, n, options);
+    }
+
+    /**
+     * @brief Multiplies a large array together across threads
+     * @param values The factors
+     * @param n Number of factors
+     * @param options Thread count and chunk size (the summation mode is ignored)
+     * @return The product; identical for every thread count given the same options
+     */
+    double ParallelReduce::product(const double* values, std::size_t n, const ReduceOptions& options) {
+        return reduce(Reduction::Product, values, n, options);
+    }
+}
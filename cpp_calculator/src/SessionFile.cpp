@@ -0,0 +1,190 @@
+#include "SessionFile.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    SessionHeader makeHeader(double initialValue) {
+        SessionHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "CALC", sizeof(header.magic));
+        header.version = sessionFormatVersion;
+        header.recordSize = sizeof(JournalEntry);
+        header.byteOrder = sessionByteOrderMark;
+        header.initialValue = initialValue;
+        return header;
+    }
+}
+
+/**
+ * @brief Checks that a header describes a session this build can read
+ * @param header The header to check
+ * @param source Used in error messages
+ * Throws std::runtime_error describing the first mismatch
+ */
+void validateSessionHeader(const SessionHeader& header, const std::string& source) {
+    if (std::memcmp(header.magic, "CALC", sizeof(header.magic)) != 0) {
+        throw std::runtime_error(source + " is not a calculator session file");
+    }
+    if (header.byteOrder != sessionByteOrderMark) {
+        throw std::runtime_error(source + " was written with a different byte order");
+    }
+    if (header.version != sessionFormatVersion || header.recordSize != sizeof(JournalEntry)) {
+        throw std::runtime_error(source + " uses an unsupported session format version");
+    }
+}
+
+/**
+ * @brief Constructor - Opens a session file for appending records
+ * @param path The session file
+ * @param initialValue Value before the first record of a new session
+ * @param mode Whether to replace or continue an existing file
+ * @param bufferEntries Records held in memory between writes
+ */
+SessionWriter::SessionWriter(const std::string& path, double initialValue, SessionOpen mode,
+                             std::size_t bufferEntries)
+    : file(nullptr),
+      buffer(new JournalEntry[bufferEntries != 0 ? bufferEntries : 1]),
+      bufferCapacity(bufferEntries != 0 ? bufferEntries : 1),
+      buffered(0),
+      flushed(0) {
+    if (mode == SessionOpen::Append) {
+        file = std::fopen(path.c_str(), "r+b");
+    }
+
+    if (file != nullptr) {
+        SessionHeader header;
+        if (std::fread(&header, sizeof(header), 1, file) != 1) {
+            std::fclose(file);
+            throw std::runtime_error(path + " is not a calculator session file");
+        }
+        try {
+            validateSessionHeader(header, path);
+        } catch (...) {
+            std::fclose(file);
+            throw;
+        }
+        // Position after the last whole record, dropping any torn tail
+        std::fseek(file, 0, SEEK_END);
+        const long end = std::ftell(file);
+        flushed = static_cast<std::uint64_t>(end - static_cast<long>(sizeof(SessionHeader))) / sizeof(JournalEntry);
+        std::fseek(file, static_cast<long>(sizeof(SessionHeader) + flushed * sizeof(JournalEntry)), SEEK_SET);
+    } else {
+        file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            throw std::runtime_error("Cannot open " + path + " for writing");
+        }
+        const SessionHeader header = makeHeader(initialValue);
+        if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+            std::fclose(file);
+            throw std::runtime_error("Cannot write " + path);
+        }
+    }
+
+    // Records are already gathered into large blocks here
+    std::setvbuf(file, nullptr, _IONBF, 0);
+}
+
+SessionWriter::~SessionWriter() {
+    try {
+        flush();
+    } catch (const std::exception&) {
+    }
+    std::fclose(file);
+}
+
+/**
+ * @brief Appends one record
+ * @param operation The operation performed
+ * @param operand The operand (the exponent for Power)
+ */
+void SessionWriter::record(Operation operation, double operand) {
+    if (buffered == bufferCapacity) {
+        flush();
+    }
+    JournalEntry& slot = buffer[buffered++];
+    std::memset(&slot, 0, sizeof(slot));
+    slot.operand = operand;
+    slot.operation = operation;
+}
+
+/**
+ * @brief Appends existing records
+ * @param entries The records, oldest first
+ * @param n Number of records; large runs bypass the buffer
+ */
+void SessionWriter::append(const JournalEntry* entries, std::size_t n) {
+    if (buffered + n <= bufferCapacity) {
+        std::memcpy(&buffer[buffered], entries, n * sizeof(JournalEntry));
+        buffered += n;
+        return;
+    }
+    flush();
+    if (std::fwrite(entries, sizeof(JournalEntry), n, file) != n) {
+        throw std::runtime_error("Failed to write session records");
+    }
+    flushed += n;
+}
+
+/**
+ * @brief Appends the applied entries of a journal
+ * @param journal The journal; its base value is not written
+ */
+void SessionWriter::append(const OperationJournal& journal) {
+    for (std::size_t i = 0; i < journal.size(); ++i) {
+        const JournalEntry& entry = journal.entry(i);
+        record(entry.operation, entry.operand);
+    }
+}
+
+void SessionWriter::flush() {
+    if (buffered == 0) {
+        return;
+    }
+    const std::size_t written = std::fwrite(buffer.get(), sizeof(JournalEntry), buffered, file);
+    flushed += written;
+    if (written != buffered) {
+        std::memmove(buffer.get(), &buffer[written], (buffered - written) * sizeof(JournalEntry));
+        buffered -= written;
+        throw std::runtime_error("Failed to write session records");
+    }
+    buffered = 0;
+}
+
+std::uint64_t SessionWriter::size() const {
+    return flushed + buffered;
+}
+
+/**
+ * @brief Constructor - Maps a session file and checks its header
+ * @param path The session file
+ */
+MappedSession::MappedSession(const std::string& path)
+    : file(path), header(nullptr), records(nullptr), count(0) {
+    if (file.size() < sizeof(SessionHeader)) {
+        throw std::runtime_error(path + " is not a calculator session file");
+    }
+    header = reinterpret_cast<const SessionHeader*>(file.data());
+    validateSessionHeader(*header, path);
+    records = reinterpret_cast<const JournalEntry*>(file.data() + sizeof(SessionHeader));
+    count = (file.size() - sizeof(SessionHeader)) / sizeof(JournalEntry);
+}
+
+double MappedSession::getInitialValue() const {
+    return header->initialValue;
+}
+
+const JournalEntry* MappedSession::entries() const {
+    return records;
+}
+
+std::size_t MappedSession::size() const {
+    return count;
+}
+
+const JournalEntry& MappedSession::entry(std::size_t index) const {
+    return records[index];
+}
+
+double MappedSession::replay() const {
+    return OperationJournal::replay(header->initialValue, records, count);
+}
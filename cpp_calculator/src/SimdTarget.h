@@ -0,0 +1,22 @@
+#ifndef SIMDTARGET_H
+#define SIMDTARGET_H
+
+// Instruction-set detection shared by the MathUtils kernel translation units
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MATHUTILS_X86 1
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+// GCC and Clang can compile AVX2/AVX-512 kernels without raising the
+// baseline ISA, so those tiers are only selected when the CPU supports them.
+#define MATHUTILS_X86_DISPATCH 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATHUTILS_HAVE_SSE2 1
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define MATHUTILS_NEON 1
+#include <arm_neon.h>
+#endif
+
+#endif // SIMDTARGET_H
@@ -0,0 +1,224 @@
+#include "Snapshot.h"
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    /**
+     * @brief Forces a written file's data to stable storage
+     * @param file The open file
+     * @return True on success
+     */
+    bool flushToDisk(std::FILE* file) {
+        if (std::fflush(file) != 0) {
+            return false;
+        }
+#ifdef _WIN32
+        return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)))) != 0;
+#else
+        return ::fsync(fileno(file)) == 0;
+#endif
+    }
+
+    /**
+     * @brief Makes a rename within a directory durable
+     * @param path A file in the directory
+     * Best effort: some file systems cannot sync a directory, and the snapshot
+     * itself is already on disk by then. Windows needs nothing here, since
+     * MOVEFILE_WRITE_THROUGH already waits for the move.
+     */
+    void flushDirectory(const std::string& path) {
+#ifndef _WIN32
+        const std::string::size_type slash = path.find_last_of('/');
+        const std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+        const int descriptor = ::open(directory.c_str(), O_RDONLY);
+        if (descriptor >= 0) {
+            ::fsync(descriptor);
+            ::close(descriptor);
+        }
+#else
+        (void)path;
+#endif
+    }
+
+    /**
+     * @brief Moves a finished file over the destination in one step
+     * @param from The temporary file
+     * @param to The destination, replaced if it exists
+     * @return True on success
+     */
+    bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+        return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+    }
+
+    /**
+     * @brief Writes a snapshot file from bank-layout arrays
+     * @param path The snapshot file
+     * @param precision Element type of values and operands
+     * @param count Number of calculators
+     * @param values Their values, count elements
+     * @param operations Their last operations
+     * @param operands The operands of those operations, count elements
+     * @param sequence Journal position of the state
+     * @param divisionErrors Division error count to record
+     * The arrays go to path + ".tmp", which is flushed to disk before it
+     * replaces path, so after a crash path holds the old or the new snapshot
+     */
+    void writeArrays(const std::string& path, Utils::Precision precision, std::size_t count, const void* values,
+                     const Operation* operations, const void* operands, std::uint64_t sequence,
+                     std::uint64_t divisionErrors) {
+        SnapshotHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "CSNP", sizeof(header.magic));
+        header.version = snapshotFormatVersion;
+        header.precision = static_cast<std::uint8_t>(precision);
+        header.byteOrder = sessionByteOrderMark;
+        header.count = count;
+        header.sequence = sequence;
+        header.divisionErrors = divisionErrors;
+
+        const std::string temporary = path + ".tmp";
+        std::FILE* file = std::fopen(temporary.c_str(), "wb");
+        if (file == nullptr) {
+            throw std::runtime_error("Cannot open " + temporary + " for writing");
+        }
+        const std::size_t elementSize = Utils::precisionSize(precision);
+        bool written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+        if (count != 0) {
+            written = written && std::fwrite(values, elementSize, count, file) == count &&
+                      std::fwrite(operands, elementSize, count, file) == count &&
+                      std::fwrite(operations, sizeof(Operation), count, file) == count;
+        }
+        written = written && flushToDisk(file);
+        written = std::fclose(file) == 0 && written;
+        if (!written || !replaceFile(temporary, path)) {
+            std::remove(temporary.c_str());
+            throw std::runtime_error("Cannot write snapshot " + path);
+        }
+        flushDirectory(path);
+    }
+}
+
+/**
+ * @brief Writes a snapshot of double calculators
+ * @param path The snapshot file, replaced atomically
+ * @param count Number of calculators
+ * @param values Their values
+ * @param operations Their last operations
+ * @param operands The operands of those operations
+ * @param sequence Journal position their state corresponds to
+ * @param divisionErrors Division error count to record (a bank's)
+ */
+void writeSnapshot(const std::string& path, std::size_t count, const double* values, const Operation* operations,
+                   const double* operands, std::uint64_t sequence, std::uint64_t divisionErrors) {
+    writeArrays(path, Utils::Precision::Double, count, values, operations, operands, sequence, divisionErrors);
+}
+
+/**
+ * @brief Writes a snapshot of float calculators
+ * @param path The snapshot file, replaced atomically
+ * @param count Number of calculators
+ * @param values Their values
+ * @param operations Their last operations
+ * @param operands The operands of those operations
+ * @param sequence Journal position their state corresponds to
+ * @param divisionErrors Division error count to record (a bank's)
+ */
+void writeSnapshot(const std::string& path, std::size_t count, const float* values, const Operation* operations,
+                   const float* operands, std::uint64_t sequence, std::uint64_t divisionErrors) {
+    writeArrays(path, Utils::Precision::Float, count, values, operations, operands, sequence, divisionErrors);
+}
+
+/**
+ * @brief Constructor - Maps a snapshot file and checks it against its header
+ * @param path The snapshot file
+ * The file must be exactly as long as the header says, so a snapshot cut
+ * short is rejected rather than restored with missing calculators. Every
+ * operation code must name an Operation, and every Power operand must pass
+ * isValidExponent
+ */
+MappedSnapshot::MappedSnapshot(const std::string& path) : file(path), header(nullptr), count(0) {
+    if (file.size() < sizeof(SnapshotHeader)) {
+        throw std::runtime_error(path + " is not a calculator snapshot");
+    }
+    header = reinterpret_cast<const SnapshotHeader*>(file.data());
+    if (std::memcmp(header->magic, "CSNP", sizeof(header->magic)) != 0) {
+        throw std::runtime_error(path + " is not a calculator snapshot");
+    }
+    if (header->byteOrder != sessionByteOrderMark) {
+        throw std::runtime_error(path + " was written with a different byte order");
+    }
+    const Utils::Precision precision = static_cast<Utils::Precision>(header->precision);
+    if (header->version != snapshotFormatVersion ||
+        (precision != Utils::Precision::Double && precision != Utils::Precision::Float)) {
+        throw std::runtime_error(path + " uses an unsupported snapshot format version");
+    }
+    const std::size_t bytesPerCalculator = 2 * Utils::precisionSize(precision) + sizeof(Operation);
+    const std::size_t payload = file.size() - sizeof(SnapshotHeader);
+    if (header->count > payload / bytesPerCalculator || header->count * bytesPerCalculator != payload) {
+        throw std::runtime_error(path + " is truncated or corrupt");
+    }
+    count = static_cast<std::size_t>(header->count);
+
+    // One pass over the records, so restore() and describeOperation only ever
+    // see valid operation codes and Power exponents
+    const Operation* codes = operations();
+    const double* doubleOperands = precision == Utils::Precision::Double ? operands<double>() : nullptr;
+    const float* floatOperands = precision == Utils::Precision::Float ? operands<float>() : nullptr;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (static_cast<std::uint8_t>(codes[i]) > static_cast<std::uint8_t>(Operation::DivisionError)) {
+            throw std::runtime_error(path + " is truncated or corrupt");
+        }
+        if (codes[i] == Operation::Power &&
+            !isValidExponent(doubleOperands != nullptr ? doubleOperands[i] : static_cast<double>(floatOperands[i]))) {
+            throw std::runtime_error(path + " is truncated or corrupt");
+        }
+    }
+}
+
+void MappedSnapshot::requirePrecision(Utils::Precision precision) const {
+    if (getPrecision() != precision) {
+        throw std::runtime_error(getPrecision() == Utils::Precision::Double ? "Snapshot holds double calculators"
+                                                                            : "Snapshot holds float calculators");
+    }
+}
+
+std::size_t MappedSnapshot::size() const {
+    return count;
+}
+
+Utils::Precision MappedSnapshot::getPrecision() const {
+    return static_cast<Utils::Precision>(header->precision);
+}
+
+std::uint64_t MappedSnapshot::getSequence() const {
+    return header->sequence;
+}
+
+std::uint64_t MappedSnapshot::getDivisionErrorCount() const {
+    return header->divisionErrors;
+}
+
+/**
+ * @brief Gets the saved operation codes
+ * @return size() codes, in place in the mapping
+ */
+const Operation* MappedSnapshot::operations() const {
+    return reinterpret_cast<const Operation*>(file.data() + sizeof(SnapshotHeader) +
+                                              2 * count * Utils::precisionSize(getPrecision()));
+}
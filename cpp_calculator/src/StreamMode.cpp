@@ -0,0 +1,355 @@
+#include "StreamMode.h"
+#include "Calculator.h"
+#include "Instrumentation.h"
+#include "SessionFile.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace {
+    const std::size_t readBufferSize = 1 << 20;
+    const std::size_t writeBufferSize = 1 << 16;
+
+    const char* usage =
+        "usage: calculator --stream [--binary] [--final] [--metrics out.prom] [file]\n"
+        "  Applies operations read from file (or stdin) to a calculator.\n"
+        "  Text input has one operation per line: add|+, subtract|-, multiply|*,\n"
+        "  divide|/ or power|^ followed by an operand, or reset. Blank lines and\n"
+        "  lines starting with # are skipped.\n"
+        "  --binary  read the session file format instead of text\n"
+        "  --final   print only the final value instead of one value per operation\n"
+        "  --metrics write operation counters and latency histograms in the Prometheus\n"
+        "            text format to out.prom at exit (needs an instrumented build)\n";
+
+    // Collects formatted values and hands them to std::cout in large writes
+    class OutputBuffer {
+    private:
+        std::vector<char> buffer;
+        std::size_t used;
+
+    public:
+        OutputBuffer() : buffer(writeBufferSize), used(0) {}
+        ~OutputBuffer() {
+            flush();
+        }
+
+        void writeValue(double value) {
+            // %.17g round-trips every double; 32 bytes covers the longest form
+            if (buffer.size() - used < 32) {
+                flush();
+            }
+            used += static_cast<std::size_t>(std::snprintf(&buffer[used], 32, "%.17g\n", value));
+        }
+
+        void flush() {
+            std::cout.write(buffer.data(), static_cast<std::streamsize>(used));
+            used = 0;
+        }
+    };
+
+    struct StreamOptions {
+        bool binary = false;
+        bool finalOnly = false;
+        const char* path = nullptr;
+        const char* metricsPath = nullptr;
+    };
+
+    /**
+     * @brief Applies one journal record through the public calculator methods
+     * @param calc The calculator
+     * @param entry The record; a DivisionError record repeats the rejected division
+     * Throws std::runtime_error for a Power record that is not a valid exponent,
+     * whether it was parsed from text or read from a session file
+     */
+    void apply(Calculator& calc, const JournalEntry& entry) {
+        switch (entry.operation) {
+        case Operation::Add:
+            calc.add(entry.operand);
+            break;
+        case Operation::Subtract:
+            calc.subtract(entry.operand);
+            break;
+        case Operation::Multiply:
+            calc.multiply(entry.operand);
+            break;
+        case Operation::Divide:
+        case Operation::DivisionError:
+            calc.divide(entry.operand);
+            break;
+        case Operation::Power:
+            if (!isValidExponent(entry.operand)) {
+                throw std::runtime_error("Exponent must be an integer");
+            }
+            calc.powerOf(static_cast<int>(entry.operand));
+            break;
+        case Operation::Reset:
+            calc.reset();
+            break;
+        default:
+            break;
+        }
+    }
+
+    /**
+     * @brief Parses one line of text input
+     * @param line Start of the line; the line ends at '\n' or the terminating NUL
+     * @param entry Receives the operation
+     * @return false for blank and comment lines; throws std::runtime_error on bad input
+     */
+    bool parseLine(const char* line, JournalEntry& entry) {
+        while (*line == ' ' || *line == '\t') {
+            ++line;
+        }
+        if (*line == '\n' || *line == '\r' || *line == '\0' || *line == '#') {
+            return false;
+        }
+
+        const char* word = line;
+        while (*line != ' ' && *line != '\t' && *line != '\n' && *line != '\r' && *line != '\0') {
+            ++line;
+        }
+        const std::size_t length = static_cast<std::size_t>(line - word);
+
+        struct Keyword {
+            const char* name;
+            Operation operation;
+        };
+        static const Keyword keywords[] = {
+            {"add", Operation::Add},           {"+", Operation::Add},
+            {"subtract", Operation::Subtract}, {"-", Operation::Subtract},
+            {"multiply", Operation::Multiply}, {"*", Operation::Multiply},
+            {"divide", Operation::Divide},     {"/", Operation::Divide},
+            {"power", Operation::Power},       {"^", Operation::Power},
+            {"reset", Operation::Reset}};
+
+        const Keyword* match = nullptr;
+        for (const Keyword& keyword : keywords) {
+            if (std::strlen(keyword.name) == length && std::memcmp(keyword.name, word, length) == 0) {
+                match = &keyword;
+                break;
+            }
+        }
+        if (match == nullptr) {
+            throw std::runtime_error("unknown operation '" + std::string(word, length) + "'");
+        }
+
+        entry.operation = match->operation;
+        entry.operand = 0.0;
+        if (match->operation != Operation::Reset) {
+            // strtod would skip a newline too and take the operand from the next line
+            while (*line == ' ' || *line == '\t') {
+                ++line;
+            }
+            char* end = nullptr;
+            if (*line != '\n' && *line != '\r' && *line != '\0') {
+                entry.operand = std::strtod(line, &end);
+            }
+            if (end == nullptr || end == line) {
+                throw std::runtime_error("missing operand for '" + std::string(word, length) + "'");
+            }
+            line = end;
+        }
+        while (*line == ' ' || *line == '\t' || *line == '\r') {
+            ++line;
+        }
+        if (*line != '\n' && *line != '\0') {
+            throw std::runtime_error("unexpected text after operation");
+        }
+        return true;
+    }
+
+    /**
+     * @brief Streams text operations
+     * @param input The source, read in large blocks
+     * @param calc The calculator the operations are applied to
+     * @param out Receives one value per operation unless finalOnly
+     * @return The process exit code
+     */
+    int streamText(std::FILE* input, Calculator& calc, OutputBuffer& out, bool finalOnly) {
+        // One extra byte keeps the data NUL-terminated for strtod
+        std::vector<char> buffer(readBufferSize + 1);
+        std::size_t filled = 0;
+        std::size_t lineNumber = 0;
+        bool atEnd = false;
+
+        while (!atEnd) {
+            const std::size_t got = std::fread(&buffer[filled], 1, readBufferSize - filled, input);
+            filled += got;
+            atEnd = got == 0;
+            buffer[filled] = '\0';
+
+            std::size_t start = 0;
+            while (start < filled) {
+                const char* line = &buffer[start];
+                const char* newline = static_cast<const char*>(std::memchr(line, '\n', filled - start));
+                if (newline == nullptr) {
+                    if (start == 0 && filled == readBufferSize) {
+                        std::cerr << "line " << lineNumber + 1 << ": line too long\n";
+                        return 1;
+                    }
+                    if (!atEnd) {
+                        break; // finish the line after the next read
+                    }
+                    newline = &buffer[filled];
+                }
+
+                ++lineNumber;
+                JournalEntry entry;
+                try {
+                    if (parseLine(line, entry)) {
+                        apply(calc, entry);
+                        if (!finalOnly) {
+                            out.writeValue(calc.getValue());
+                        }
+                    }
+                } catch (const std::runtime_error& error) {
+                    std::cerr << "line " << lineNumber << ": " << error.what() << '\n';
+                    return 1;
+                }
+                start = static_cast<std::size_t>(newline - buffer.data()) + 1;
+            }
+
+            if (start < filled) {
+                std::memmove(buffer.data(), &buffer[start], filled - start);
+                filled -= start;
+            } else {
+                filled = 0;
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Streams records in the session file format
+     * @param input The source, positioned at the session header
+     * @param source Name used in error messages
+     * @param calc The calculator, set to the session's initial value first
+     * @param out Receives one value per record unless finalOnly
+     * @return The process exit code
+     */
+    int streamBinary(std::FILE* input, const char* source, Calculator& calc, OutputBuffer& out, bool finalOnly) {
+        SessionHeader header;
+        if (std::fread(&header, sizeof(header), 1, input) != 1) {
+            std::cerr << source << " is not a calculator session file\n";
+            return 1;
+        }
+        try {
+            validateSessionHeader(header, source);
+        } catch (const std::runtime_error& error) {
+            std::cerr << error.what() << '\n';
+            return 1;
+        }
+        calc.restore(header.initialValue);
+
+        std::vector<JournalEntry> records(readBufferSize / sizeof(JournalEntry));
+        std::uint64_t recordNumber = 0;
+        std::size_t got;
+        while ((got = std::fread(records.data(), sizeof(JournalEntry), records.size(), input)) != 0) {
+            for (std::size_t i = 0; i < got; ++i) {
+                ++recordNumber;
+                try {
+                    apply(calc, records[i]);
+                } catch (const std::runtime_error& error) {
+                    std::cerr << source << ": record " << recordNumber << ": " << error.what() << '\n';
+                    return 1;
+                }
+                if (!finalOnly) {
+                    out.writeValue(calc.getValue());
+                }
+            }
+        }
+        return 0;
+    }
+}
+
+/**
+ * @brief Runs the streaming mode
+ * @param argc Number of arguments after --stream
+ * @param argv The arguments
+ * @return 0 on success, 1 on bad input, 2 on bad usage
+ */
+int runStreamMode(int argc, char** argv) {
+    StreamOptions options;
+    for (int i = 0; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--binary") {
+            options.binary = true;
+        } else if (arg == "--final") {
+            options.finalOnly = true;
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            options.metricsPath = argv[++i];
+        } else if (arg == "--help") {
+            std::cout << usage;
+            return 0;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            std::cerr << usage;
+            return 2;
+        } else if (options.path == nullptr) {
+            options.path = argv[i];
+        } else {
+            std::cerr << usage;
+            return 2;
+        }
+    }
+
+    // Nothing here mixes C stdio output with iostreams, so the sync can go
+    std::ios::sync_with_stdio(false);
+
+    std::FILE* input = stdin;
+#ifdef _WIN32
+    if (options.binary) {
+        _setmode(_fileno(stdin), _O_BINARY);
+    }
+#endif
+    if (options.path != nullptr && std::strcmp(options.path, "-") != 0) {
+        input = std::fopen(options.path, options.binary ? "rb" : "r");
+        if (input == nullptr) {
+            std::cerr << "Cannot open " << options.path << '\n';
+            return 1;
+        }
+    }
+    // Reads are already large, so skip stdio's own buffering
+    std::setvbuf(input, nullptr, _IONBF, 0);
+
+    Calculator calc;
+    int status;
+    {
+        OutputBuffer out;
+        status = options.binary
+                     ? streamBinary(input, options.path != nullptr ? options.path : "stdin", calc, out, options.finalOnly)
+                     : streamText(input, calc, out, options.finalOnly);
+        if (status == 0 && options.finalOnly) {
+            out.writeValue(calc.getValue());
+        }
+    }
+    if (input != stdin) {
+        std::fclose(input);
+    }
+
+    if (calc.getDivisionErrorCount() != 0) {
+        std::cerr << "Division errors: " << calc.getDivisionErrorCount() << '\n';
+    }
+    if (options.metricsPath != nullptr) {
+        if (!Instrumentation::enabled()) {
+            std::cerr << "--metrics: built without CALCULATOR_ENABLE_INSTRUMENTATION, counters are zero\n";
+        }
+        std::ofstream metrics(options.metricsPath);
+        Instrumentation::writePrometheus(metrics, Instrumentation::snapshot());
+        if (!metrics) {
+            std::cerr << "Cannot write " << options.metricsPath << '\n';
+            status = status != 0 ? status : 1;
+        }
+    }
+    std::cout.flush();
+    return status;
+}
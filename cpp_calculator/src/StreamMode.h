@@ -0,0 +1,8 @@
+#ifndef STREAMMODE_H
+#define STREAMMODE_H
+
+// Entry point of `calculator --stream`; args excludes the program name and
+// the --stream flag itself. Returns the process exit code.
+int runStreamMode(int argc, char** argv);
+
+#endif // STREAMMODE_H
@@ -1,7 +1,14 @@
+#include <cstring>
 #include <iostream>
 #include "Calculator.h"
+#include "StreamMode.h"
+
+int main(int argc, char** argv) {
+    // calculator --stream [...] runs as a pipeline stage instead of the demo
+    if (argc > 1 && std::strcmp(argv[1], "--stream") == 0) {
+        return runStreamMode(argc - 2, argv + 2);
+    }
 
-int main() {
     Calculator calc;
     
     std::cout << "=== Calculator Demo ===" << std::endl;
@@ -30,6 +37,8 @@ int main() {
     // Test division by zero
     std::cout << std::endl << "Testing division by zero:" << std::endl;
     calc.divide(0);
+    std::cout << "After " << calc.getLastOperation() << ": " << calc.getValue() << std::endl;
+    std::cout << "Division errors: " << calc.getDivisionErrorCount() << std::endl;
     
     // Reset
     std::cout << std::endl;
@@ -0,0 +1,149 @@
+#include "BigIntCalculator.h"
+#include <gtest/gtest.h>
+#include <string>
+
+using Utils::BigInt;
+
+namespace {
+    BigInt pow2(unsigned int exponent) {
+        return BigInt::power(BigInt(2), exponent);
+    }
+
+    // Checks the defining identities of truncating division
+    void expectDivision(const BigInt& a, const BigInt& b) {
+        BigInt quotient;
+        BigInt remainder;
+        BigInt::divide(a, b, quotient, remainder);
+        EXPECT_EQ(quotient * b + remainder, a) << a << " / " << b;
+        const BigInt magnitude = b.isNegative() ? -b : b;
+        EXPECT_LT(remainder.isNegative() ? -remainder : remainder, magnitude) << a << " % " << b;
+        EXPECT_TRUE(remainder.isZero() || remainder.isNegative() == a.isNegative()) << a << " % " << b;
+        EXPECT_EQ(a / b, quotient);
+        EXPECT_EQ(a % b, remainder);
+    }
+}
+
+// Values that shrink to a word or two while their limbs are still on the heap
+
+TEST(BigInt, DifferenceOnHeapAddsAsWord) {
+    const BigInt big = pow2(200);
+    const BigInt difference = (big + 5) - big;
+    EXPECT_FALSE(difference.isInline());
+    EXPECT_EQ(difference + 1, BigInt(6));
+    EXPECT_EQ(BigInt(1) - difference, BigInt(-4));
+}
+
+TEST(BigInt, QuotientOnHeapAddsAsWord) {
+    const BigInt big = pow2(200);
+    const BigInt quotient = (big * 3) / big;
+    EXPECT_EQ(quotient.limbCount(), 1u);
+    EXPECT_EQ(quotient + 1, BigInt(4));
+    EXPECT_EQ(quotient.toString(), "3");
+}
+
+TEST(BigInt, AssignmentIntoHeapValueAddsAsWord) {
+    BigInt value = pow2(300);
+    value = BigInt(7);
+    EXPECT_EQ(value + value, BigInt(14));
+    EXPECT_EQ(value - 10, BigInt(-3));
+}
+
+TEST(BigInt, CalculatorScaledUpAndBackDown) {
+    BigIntCalculator calc;
+    calc.add(3);
+    calc.multiply(pow2(200));
+    calc.divide(pow2(200));
+    calc.add(1);
+    EXPECT_EQ(calc.getValue(), BigInt(4));
+}
+
+TEST(BigInt, CalculatorDescribesEveryDigit) {
+    BigIntCalculator calc;
+    const BigInt operand = BigInt::fromString("123456789012345678901234567890");
+    calc.add(operand);
+    EXPECT_EQ(calc.getLastOperation(), "Added 123456789012345678901234567890");
+    calc.divide(-operand);
+    EXPECT_EQ(calc.getLastOperation(), "Divided by -123456789012345678901234567890");
+    EXPECT_EQ(calc.getValue(), BigInt(-1));
+}
+
+// Products past the Karatsuba threshold
+
+TEST(BigInt, KaratsubaProductMatchesReference) {
+    // 3^1000 (50 limbs) * 7^700 (62 limbs), digits from Python
+    const std::string product = (BigInt::power(3, 1000) * BigInt::power(7, 700)).toString();
+    EXPECT_EQ(product.size(), 1069u);
+    EXPECT_EQ(product.substr(0, 30), "489646584707813639495853841381");
+    EXPECT_EQ(product.substr(product.size() - 30), "332185507351644449309351640001");
+}
+
+TEST(BigInt, LargeUnbalancedProductMatchesReference) {
+    const BigInt product = BigInt::power(3, 20000) * BigInt::power(7, 15000);
+    EXPECT_EQ(product % BigInt(1000000007), BigInt(407775121));
+}
+
+TEST(BigInt, KaratsubaSquareIdentity) {
+    // (2^k - 1)^2 == 2^2k - 2^(k+1) + 1, with all-ones limbs stressing the carries
+    for (unsigned int k : {1280u, 1281u, 4096u, 10000u}) {
+        const BigInt ones = pow2(k) - 1;
+        EXPECT_EQ(ones * ones, pow2(2 * k) - pow2(k + 1) + 1) << k;
+    }
+}
+
+TEST(BigInt, KaratsubaDistributes) {
+    const BigInt a = BigInt::power(11, 2000) - 12345;
+    const BigInt b = BigInt::power(13, 1500) + 678;
+    EXPECT_EQ((a + b) * (a + b), a * a + 2 * (a * b) + b * b);
+    EXPECT_EQ((a * b) / b, a);
+    EXPECT_TRUE(((a * b) % a).isZero());
+}
+
+// Division edge cases
+
+TEST(BigInt, DivisionTruncatesTowardZero) {
+    EXPECT_EQ(BigInt(-7) / BigInt(2), BigInt(-3));
+    EXPECT_EQ(BigInt(-7) % BigInt(2), BigInt(-1));
+    EXPECT_EQ(BigInt(7) / BigInt(-2), BigInt(-3));
+    EXPECT_EQ(BigInt(7) % BigInt(-2), BigInt(1));
+    EXPECT_EQ(-(pow2(200) + 3) / pow2(100), -pow2(100));
+}
+
+TEST(BigInt, DivisionWithTopBitDivisor) {
+    // Normalization shift of zero, values from Python
+    const BigInt divisor = pow2(127) + 1;
+    const BigInt dividend = pow2(256) - 1;
+    EXPECT_EQ((dividend / divisor).toString(), "680564733841876926926749214863536422908");
+    EXPECT_EQ(dividend % divisor, BigInt(3));
+}
+
+TEST(BigInt, DivisionIdentities) {
+    const BigInt word = pow2(64) - 1;
+    const BigInt cases[][2] = {
+        {word * word - 1, word},
+        {word * word, word},
+        {pow2(96) - pow2(32), pow2(64) - pow2(32) + 1},
+        {pow2(192) - 1, pow2(96) - 1},
+        {pow2(160), pow2(128) - 1},
+        {BigInt::power(10, 300) + 7, BigInt(1000000007)},
+        {BigInt::power(10, 300) + 7, BigInt::power(10, 150) - 3},
+        {-BigInt::power(3, 500), BigInt::power(2, 400) + 1},
+        {BigInt(5), pow2(100)},
+    };
+    for (const auto& pair : cases) {
+        expectDivision(pair[0], pair[1]);
+        expectDivision(-pair[0], pair[1]);
+        expectDivision(pair[0], -pair[1]);
+    }
+}
+
+TEST(BigInt, DivisionByZeroThrows) {
+    EXPECT_THROW(pow2(200) / BigInt(0), std::runtime_error);
+    EXPECT_THROW(BigInt(5) % BigInt(0), std::runtime_error);
+}
+
+TEST(BigInt, StringRoundTrip) {
+    const std::string text = "-123456789012345678901234567890123456789012345678901234567890";
+    EXPECT_EQ(BigInt::fromString(text).toString(), text);
+    EXPECT_EQ(BigInt::fromString("-0").toString(), "0");
+    EXPECT_THROW(BigInt::fromString("12a"), std::invalid_argument);
+}
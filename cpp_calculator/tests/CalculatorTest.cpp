@@ -0,0 +1,47 @@
+#include "Calculator.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <memory_resource>
+
+TEST(Calculator, DescribesDoubleOperands) {
+    Calculator calc;
+    calc.add(10);
+    EXPECT_EQ(calc.getLastOperation(), "Added 10");
+    calc.powerOf(2);
+    EXPECT_EQ(calc.getLastOperation(), "Raised to power 2");
+}
+
+TEST(Calculator, IntegerCalculatorDescribesExactOperands) {
+    IntegerCalculator calc;
+    calc.add(1234567);
+    EXPECT_EQ(calc.getLastOperation(), "Added 1234567");
+    calc.subtract(INT64_C(9007199254740993));
+    EXPECT_EQ(calc.getLastOperation(), "Subtracted 9007199254740993");
+    calc.divide(0);
+    EXPECT_EQ(calc.getLastOperation(), "Division error");
+    EXPECT_EQ(calc.getDivisionErrorCount(), 1u);
+    calc.powerOf(1);
+    EXPECT_EQ(calc.getLastOperation(), "Raised to power 1");
+    calc.reset();
+    EXPECT_EQ(calc.getLastOperation(), "reset");
+}
+
+TEST(Calculator, DecimalCalculatorDescribesEveryDecimal) {
+    DecimalCalculator<2> ledger;
+    ledger.add(Utils::Fixed<2>::fromUnits(123456789));
+    EXPECT_EQ(ledger.getLastOperation(), "Added 1234567.89");
+    ledger.subtract(Utils::Fixed<2>::fromUnits(-50));
+    EXPECT_EQ(ledger.getLastOperation(), "Subtracted -0.50");
+
+    std::pmr::monotonic_buffer_resource arena;
+    EXPECT_EQ(ledger.getLastOperation(&arena), "Subtracted -0.50");
+}
+
+TEST(Calculator, ExactRestoreDescribesTheRecord) {
+    IntegerCalculator calc;
+    calc.add(3);
+    calc.restore(7, Operation::Divide, 2.0);
+    EXPECT_EQ(calc.getLastOperation(), "Divided by 2");
+    EXPECT_EQ(calc.getOperation(), Operation::Divide);
+    EXPECT_EQ(calc.getOperand(), 2.0);
+}
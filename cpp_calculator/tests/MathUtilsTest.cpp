@@ -0,0 +1,61 @@
+#include "MathUtils.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstddef>
+#include <cfenv>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using Utils::MathUtils;
+using Utils::Parity;
+
+TEST(MathUtils, IntegerParityForEveryIntegralType) {
+    const long negativeOdd = -7L;
+    const std::size_t size = 10;
+    const unsigned char small = 3;
+    EXPECT_FALSE(MathUtils::isEven(negativeOdd));
+    EXPECT_TRUE(MathUtils::isOdd(negativeOdd));
+    EXPECT_TRUE(MathUtils::isEven(size));
+    EXPECT_TRUE(MathUtils::isOdd(small));
+    EXPECT_TRUE(MathUtils::isEven(INT64_MIN));
+    EXPECT_EQ(MathUtils::parity(std::int64_t(5)), Parity::Odd);
+    EXPECT_EQ(MathUtils::parity(std::uint64_t(1) << 63), Parity::Even);
+    static_assert(MathUtils::isEven(4), "integer parity stays constexpr");
+}
+
+TEST(MathUtils, FloatingPointParity) {
+    EXPECT_TRUE(MathUtils::isEven(-4.5));
+    EXPECT_TRUE(MathUtils::isOdd(3.0f));
+    EXPECT_TRUE(MathUtils::isEven(9007199254740994.0));
+    EXPECT_FALSE(MathUtils::isEven(std::numeric_limits<double>::infinity()));
+    EXPECT_FALSE(MathUtils::isOdd(std::nan("")));
+    EXPECT_EQ(MathUtils::parity(std::nan("")), Parity::NotFinite);
+}
+
+TEST(MathUtils, BatchDivideTailRaisesNoFlags) {
+    // Every length up to a few vectors, so each kernel's tail is covered
+    for (std::size_t n = 1; n <= 33; ++n) {
+        const std::vector<double> a(n, 3.0);
+        const std::vector<double> b(n, 2.0);
+        std::vector<double> out(n);
+        std::feclearexcept(FE_ALL_EXCEPT);
+        MathUtils::divide(a.data(), b.data(), out.data(), n);
+        EXPECT_FALSE(std::fetestexcept(FE_INVALID | FE_DIVBYZERO))
+            << "n = " << n << " on " << MathUtils::batchInstructionSet();
+        EXPECT_EQ(out[n - 1], 1.5);
+    }
+}
+
+TEST(MathUtils, FloatBatchDivideTailRaisesNoFlags) {
+    for (std::size_t n = 1; n <= 65; ++n) {
+        const std::vector<float> a(n, 3.0f);
+        const std::vector<float> b(n, 2.0f);
+        std::vector<float> out(n);
+        std::feclearexcept(FE_ALL_EXCEPT);
+        MathUtils::divide(a.data(), b.data(), out.data(), n);
+        EXPECT_FALSE(std::fetestexcept(FE_INVALID | FE_DIVBYZERO))
+            << "n = " << n << " on " << MathUtils::floatInstructionSet();
+        EXPECT_EQ(out[n - 1], 1.5f);
+    }
+}
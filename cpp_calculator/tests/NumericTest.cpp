@@ -0,0 +1,46 @@
+#include "Calculator.h"
+#include "Numeric.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+
+using Utils::Fixed;
+
+TEST(Fixed, FromIntegerScales) {
+    EXPECT_EQ(Fixed<2>::fromInteger(-12).getUnits(), -1200);
+    EXPECT_EQ(Fixed<0>::fromInteger(INT64_MIN).getUnits(), INT64_MIN);
+    EXPECT_EQ(Fixed<2>::fromInteger(INT64_MAX / 100).getUnits(), INT64_MAX / 100 * 100);
+}
+
+TEST(Fixed, FromIntegerOverflowThrows) {
+    EXPECT_THROW(Fixed<2>::fromInteger(INT64_MAX / 10), std::overflow_error);
+    EXPECT_THROW(Fixed<2>::fromInteger(INT64_MIN / 10), std::overflow_error);
+    EXPECT_THROW(Fixed<18>::fromInteger(10), std::overflow_error);
+}
+
+TEST(Fixed, FromDoubleOverflowThrows) {
+    EXPECT_THROW(Fixed<2>::fromDouble(1e300), std::overflow_error);
+    std::ostringstream out;
+    out << Fixed<2>::fromDouble(-12.5);
+    EXPECT_EQ(out.str(), "-12.50");
+}
+
+TEST(Fixed, PowerRoundsAfterEachMultiplication) {
+    const Utils::CheckedValue<Fixed<2> > square = Utils::Arithmetic<Fixed<2> >::power(Fixed<2>::fromUnits(15), 2);
+    ASSERT_TRUE(square.ok());
+    EXPECT_EQ(square.value.getUnits(), 2); // 0.0225 rounds to 0.02
+    const Utils::CheckedValue<Fixed<2> > cube = Utils::Arithmetic<Fixed<2> >::power(Fixed<2>::fromUnits(-150), 3);
+    ASSERT_TRUE(cube.ok());
+    EXPECT_EQ(cube.value.getUnits(), -338); // -3.375 rounds away from zero
+}
+
+TEST(Fixed, NegativeExponentIsInvalid) {
+    EXPECT_EQ(Utils::Arithmetic<Fixed<2> >::power(Fixed<2>::fromUnits(15), -2).status,
+              Utils::MathStatus::InvalidExponent);
+
+    DecimalCalculator<2> ledger;
+    ledger.add(Fixed<2>::fromUnits(1));
+    EXPECT_THROW(ledger.powerOf(-3), std::domain_error);
+    EXPECT_EQ(ledger.getValue().getUnits(), 1);
+}
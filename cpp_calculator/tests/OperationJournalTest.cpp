@@ -0,0 +1,87 @@
+#include "OperationJournal.h"
+#include "SessionFile.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    JournalEntry makeEntry(Operation operation, double operand) {
+        JournalEntry entry = {};
+        entry.operand = operand;
+        entry.operation = operation;
+        return entry;
+    }
+
+    // A session file removed when the test ends
+    struct TemporarySession {
+        std::string path;
+
+        explicit TemporarySession(const char* name) : path(name) {}
+
+        ~TemporarySession() {
+            std::remove(path.c_str());
+        }
+    };
+}
+
+TEST(OperationJournal, ExponentValidation) {
+    EXPECT_TRUE(isValidExponent(-3.0));
+    EXPECT_TRUE(isValidExponent(static_cast<double>(std::numeric_limits<int>::min())));
+    EXPECT_TRUE(isValidExponent(static_cast<double>(std::numeric_limits<int>::max())));
+    EXPECT_FALSE(isValidExponent(2.5));
+    EXPECT_FALSE(isValidExponent(std::nan("")));
+    EXPECT_FALSE(isValidExponent(std::numeric_limits<double>::infinity()));
+    EXPECT_FALSE(isValidExponent(4294967296.0));
+}
+
+TEST(OperationJournal, RecordRejectsInvalidExponent) {
+    OperationJournal journal;
+    EXPECT_THROW(journal.record(Operation::Power, std::nan("")), std::invalid_argument);
+    EXPECT_EQ(journal.size(), 0u);
+    journal.record(Operation::Add, 3.0);
+    journal.record(Operation::Power, 2.0);
+    EXPECT_EQ(journal.value(), 9.0);
+}
+
+TEST(OperationJournal, ReplayRejectsInvalidExponent) {
+    const JournalEntry entries[] = {makeEntry(Operation::Add, 2.0), makeEntry(Operation::Power, 1e300)};
+    EXPECT_EQ(OperationJournal::replay(0.0, entries, 1), 2.0);
+    EXPECT_THROW(OperationJournal::replay(0.0, entries, 2), std::runtime_error);
+}
+
+TEST(MappedSession, CorruptPowerRecordIsRejected) {
+    TemporarySession session("operation_journal_test_session.bin");
+    {
+        SessionWriter writer(session.path, 1.0);
+        writer.record(Operation::Add, 1.0);
+        const JournalEntry corrupt = makeEntry(Operation::Power, std::nan(""));
+        writer.append(&corrupt, 1);
+    }
+    MappedSession mapped(session.path);
+    ASSERT_EQ(mapped.size(), 2u);
+    Calculator calc;
+    EXPECT_THROW(mapped.replayInto(calc), std::runtime_error);
+}
+
+TEST(MappedSession, ReplayTailContinuesFromRestoredValue) {
+    TemporarySession session("operation_journal_test_tail.bin");
+    Calculator live;
+    {
+        SessionWriter writer(session.path);
+        BasicCalculator<SessionTrace> calc{SessionTrace(writer)};
+        calc.add(4.0);
+        calc.multiply(2.5);
+        calc.powerOf(2);
+        calc.subtract(1.0);
+        live.restore(calc.getValue());
+    }
+    MappedSession mapped(session.path);
+    Calculator calc;
+    calc.restore(10.0); // the state after the first two records
+    mapped.replayTailInto(calc, 2);
+    EXPECT_EQ(calc.getValue(), live.getValue());
+    EXPECT_THROW(mapped.replayTailInto(calc, 5), std::runtime_error);
+}
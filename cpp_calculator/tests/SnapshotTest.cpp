@@ -0,0 +1,144 @@
+#include "Snapshot.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    // Files removed when the test ends
+    struct TemporaryFiles {
+        std::string snapshot;
+        std::string session;
+
+        explicit TemporaryFiles(const std::string& name) : snapshot(name + ".snap"), session(name + ".session") {}
+
+        ~TemporaryFiles() {
+            std::remove(snapshot.c_str());
+            std::remove(session.c_str());
+        }
+    };
+
+    std::string readFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    void writeFile(const std::string& path, const std::string& data) {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << data;
+    }
+}
+
+TEST(Snapshot, BankRoundTrip) {
+    TemporaryFiles files("snapshot_test_bank");
+    CalculatorBank bank(1001, 1.5);
+    bank.multiply(3.0);
+    bank.divide(0.0);
+    bank.restore(7, -2.0, Operation::Power, 3.0);
+    writeSnapshot(files.snapshot, bank, 99);
+
+    MappedSnapshot snapshot(files.snapshot);
+    EXPECT_EQ(snapshot.size(), 1001u);
+    EXPECT_EQ(snapshot.getSequence(), 99u);
+    EXPECT_EQ(snapshot.getPrecision(), Utils::Precision::Double);
+    CalculatorBank restored(3);
+    snapshot.restoreInto(restored);
+    ASSERT_EQ(restored.size(), bank.size());
+    EXPECT_EQ(restored.getDivisionErrorCount(), bank.getDivisionErrorCount());
+    for (std::size_t i = 0; i < bank.size(); ++i) {
+        EXPECT_EQ(restored.getValue(i), bank.getValue(i));
+        EXPECT_EQ(restored.getOperation(i), bank.getOperation(i));
+        EXPECT_EQ(restored.getOperand(i), bank.getOperand(i));
+    }
+
+    FloatCalculatorBank wrongPrecision;
+    EXPECT_THROW(snapshot.restoreInto(wrongPrecision), std::runtime_error);
+}
+
+TEST(Snapshot, WarmStartMatchesFullReplay) {
+    TemporaryFiles files("snapshot_test_warm");
+    double expected;
+    {
+        SessionWriter writer(files.session, 2.0);
+        BasicCalculator<SessionTrace> calc{SessionTrace(writer)};
+        calc.restore(2.0);
+        for (int i = 0; i < 100; ++i) {
+            calc.add(i * 0.5);
+            calc.multiply(1.001);
+        }
+        writer.flush();
+        writeSnapshot(files.snapshot, &calc, 1, writer.size());
+        calc.subtract(0.25);
+        calc.powerOf(2);
+        calc.divide(0.0);
+        expected = calc.getValue();
+    }
+
+    MappedSnapshot snapshot(files.snapshot);
+    EXPECT_EQ(snapshot.getSequence(), 200u);
+    Calculator warm;
+    snapshot.restoreInto(warm);
+    MappedSession session(files.session);
+    session.replayTailInto(warm, snapshot.getSequence());
+    Calculator cold;
+    session.replayInto(cold);
+    EXPECT_EQ(warm.getValue(), expected);
+    EXPECT_EQ(warm.getValue(), cold.getValue());
+    EXPECT_EQ(warm.getLastOperation(), cold.getLastOperation());
+}
+
+TEST(Snapshot, RejectsTruncatedFile) {
+    TemporaryFiles files("snapshot_test_truncated");
+    writeSnapshot(files.snapshot, CalculatorBank(10, 1.0));
+    const std::string data = readFile(files.snapshot);
+    writeFile(files.snapshot, data.substr(0, data.size() - 1));
+    EXPECT_THROW(MappedSnapshot snapshot(files.snapshot), std::runtime_error);
+}
+
+TEST(Snapshot, RejectsUnknownOperationCode) {
+    TemporaryFiles files("snapshot_test_operation");
+    writeSnapshot(files.snapshot, CalculatorBank(10, 1.0));
+    std::string data = readFile(files.snapshot);
+    data[data.size() - 3] = static_cast<char>(0xee);
+    writeFile(files.snapshot, data);
+    EXPECT_THROW(MappedSnapshot snapshot(files.snapshot), std::runtime_error);
+}
+
+TEST(Snapshot, RejectsInvalidPowerOperand) {
+    TemporaryFiles files("snapshot_test_exponent");
+    CalculatorBank bank(4, 1.0);
+    bank.restore(2, 1.0, Operation::Power, 1e300);
+    writeSnapshot(files.snapshot, bank, 0);
+    EXPECT_THROW(MappedSnapshot snapshot(files.snapshot), std::runtime_error);
+
+    bank.restore(2, 1.0, Operation::Power, std::nan(""));
+    writeSnapshot(files.snapshot, bank, 0);
+    EXPECT_THROW(MappedSnapshot snapshot(files.snapshot), std::runtime_error);
+
+    FloatCalculatorBank floats(4, 1.0f);
+    floats.restore(1, 1.0f, Operation::Power, 3e9f);
+    writeSnapshot(files.snapshot, floats, 0);
+    EXPECT_THROW(MappedSnapshot snapshot(files.snapshot), std::runtime_error);
+
+    floats.restore(1, 1.0f, Operation::Power, -3.0f);
+    writeSnapshot(files.snapshot, floats, 0);
+    MappedSnapshot valid(files.snapshot);
+    EXPECT_EQ(valid.operands<float>()[1], -3.0f);
+}
+
+TEST(Snapshot, ReplacesPreviousSnapshot) {
+    TemporaryFiles files("snapshot_test_replace");
+    writeSnapshot(files.snapshot, CalculatorBank(4, 1.0), 1);
+    writeSnapshot(files.snapshot, CalculatorBank(2, 5.0), 2);
+    MappedSnapshot snapshot(files.snapshot);
+    EXPECT_EQ(snapshot.size(), 2u);
+    EXPECT_EQ(snapshot.getSequence(), 2u);
+    EXPECT_EQ(snapshot.values<double>()[1], 5.0);
+    std::FILE* leftover = std::fopen((files.snapshot + ".tmp").c_str(), "rb");
+    EXPECT_EQ(leftover, nullptr);
+    if (leftover != nullptr) {
+        std::fclose(leftover);
+    }
+}